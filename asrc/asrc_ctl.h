@@ -0,0 +1,72 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file asrc_ctl.h
+   @brief live volume and dither of asrcrate, shared with the asrcCtl control plugin
+*/
+
+#ifndef ASRC_CTL_H
+#define ASRC_CTL_H
+
+#include <stdint.h>
+
+#include "shm_ctl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ASRC_CTL_MAGIC                        0x4c544341 /* "ACTL" */
+#define ASRC_CTL_VERSION                      1
+#define ASRC_CTL_MODE                         0660 /* the user and group of the stream */
+#define ASRC_CTL_VOLUME_MIN                   -600 /* 0.1 dB, mutes */
+#define ASRC_CTL_VOLUME_MAX                   120
+#define ASRC_CTL_RAMP_MAX                     1000000 /* us */
+#define ASRC_CTL_DITHER_MAX                   2
+
+/*
+ * Layout of the shared memory page named by the control field of the
+ * converter. The converter fills it on open, a control writes a value
+ * then bumps gen, the converter applies every value again once it sees a
+ * new gen. The page is kept after close so that the controls opened on
+ * it stay valid.
+ */
+typedef struct {
+	shm_ctl hdr;
+	int32_t volume;             /* 0.1 dB */
+	uint32_t ramp_us;           /* of a volume change */
+	uint32_t dither;            /* PCM_DITHER_* */
+} asrc_ctl;
+
+/* Maps the page, created when create is set. */
+static inline asrc_ctl *asrc_ctl_open(const char *name, int create)
+{
+	return (asrc_ctl *)shm_ctl_open(name, sizeof(asrc_ctl), ASRC_CTL_MAGIC, ASRC_CTL_VERSION,
+					ASRC_CTL_MODE, create);
+}
+
+static inline void asrc_ctl_close(asrc_ctl *ctl)
+{
+	if (ctl)
+		shm_ctl_close(&ctl->hdr, sizeof(*ctl));
+}
+
+/* Publishes the values written before, to be applied on the next period. */
+static inline void asrc_ctl_commit(asrc_ctl *ctl)
+{
+	shm_ctl_commit(&ctl->hdr);
+}
+
+/* Claims the page once the values are filled, returns the gen seen. */
+static inline uint32_t asrc_ctl_publish(asrc_ctl *ctl)
+{
+	return shm_ctl_publish(&ctl->hdr, ASRC_CTL_MAGIC, ASRC_CTL_VERSION);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
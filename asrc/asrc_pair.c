@@ -29,12 +29,13 @@
 #include <imx/linux/mxc_asrc.h>
 
 #include "asrc_pair.h"
+#include "pcm_kernels.h"
 
 #define ASRC_DEVICE     "/dev/mxc_asrc"
 #define DMA_MAX_BYTES   (32768)
 
 #define LINEAR_RATE         (20)
-#define LINEAR_PITCH_BITS   (16)
+#define LINEAR_PITCH_BITS   PCM_LERP_BITS
 #define LINEAR_PITCH        (1 << LINEAR_PITCH_BITS)
 
 static uint32_t get_max_divider(uint32_t x, uint32_t y)
@@ -108,8 +109,45 @@ static void get_dma_buffer_segments(unsigned int channels, uint32_t frames, uint
     *seg_num = num;
 }
 
+/*
+ * Room to pad a whole output period, allocated with the setup so that the
+ * conversion itself never allocates. In rt mode it is locked.
+ */
+static int alloc_pad(asrc_pair *pair)
+{
+    unsigned int frames = pair->out_period_frames / pair->channels / LINEAR_RATE + 1;
+    size_t size = (size_t)frames * (LINEAR_RATE + 1) * pair->channels * sizeof(int16_t);
+    int16_t *pad;
+
+    if (frames <= pair->pad_frames)
+        return 0;
+
+    if (pair->rt)
+    {
+        rt_arena_destroy(pair->arena);
+        pair->pad = NULL;
+        pair->pad_frames = 0;
+        pair->arena = rt_arena_create(size, 0);
+        if (!pair->arena)
+            return -ENOMEM;
+        if (!pair->arena->locked)
+            fprintf(stderr, "%s: pad buffer not locked: %s\n", __func__, strerror(pair->arena->lock_err));
+        pad = rt_arena_alloc(pair->arena, size);
+    }
+    else
+    {
+        pad = realloc(pair->pad, size);
+        if (!pad)
+            return -ENOMEM;
+    }
+
+    pair->pad = pad;
+    pair->pad_frames = frames;
+    return 0;
+}
+
 asrc_pair *asrc_pair_create(unsigned int channels, ssize_t in_period_frames,
-        ssize_t out_period_frames, unsigned int in_rate, unsigned int out_rate, int type)
+        ssize_t out_period_frames, unsigned int in_rate, unsigned int out_rate, int type, int rt)
 {
     int fd;
     int err;
@@ -165,8 +203,18 @@ asrc_pair *asrc_pair_create(unsigned int channels, ssize_t in_period_frames,
     pair->in_period_frames = in_period_frames;
     pair->out_period_frames = out_period_frames;
     pair->buf_size = dma_buffer_size;
+    pair->rt = rt;
+    pair->volume = pair->volume_target = PCM_VOLUME_UNITY;
     calculate_num_den(pair);
-    
+
+    if (alloc_pad(pair) < 0)
+    {
+        fprintf(stderr, "%s: Unable to allocate the pad buffer\n", __func__);
+        free(pair);
+        pair = NULL;
+        goto release_pair;
+    }
+
     goto end;
 
 release_pair:
@@ -185,7 +233,11 @@ void asrc_pair_destroy(asrc_pair *pair)
 
     ioctl(pair->fd, ASRC_RELEASE_PAIR, &pair->index);
     close(pair->fd);
-    
+
+    if (pair->arena)
+        rt_arena_destroy(pair->arena);
+    else
+        free(pair->pad);
     free (pair);
 }
 
@@ -234,6 +286,8 @@ int asrc_pair_set_rate(asrc_pair *pair, ssize_t in_period_frames,
         pair->in_period_frames = in_period_frames;
         pair->out_period_frames = out_period_frames;
         calculate_num_den(pair);
+        if ((err = alloc_pad(pair)) < 0)
+            fprintf(stderr, "%s: Unable to allocate the pad buffer\n", __func__);
     }
 
     if (is_converting)
@@ -246,42 +300,79 @@ void asrc_pair_reset(asrc_pair *pair)
 {
 }
 
+void asrc_pair_set_volume(asrc_pair *pair, int32_t volume, unsigned int ramp_frames)
+{
+    /* a ramp in progress goes on from where it is */
+    int64_t from = pair->ramp_frames > 0 ? pair->volume_ramp :
+        (int64_t)pair->volume << PCM_VOLUME_RAMP_BITS;
+
+    if (volume < 0)
+        volume = 0;
+    else if (volume > PCM_VOLUME_MAX)
+        volume = PCM_VOLUME_MAX;
+
+    pair->volume_target = volume;
+    pair->ramp_frames = volume != pair->volume ? ramp_frames : 0;
+    if (pair->ramp_frames == 0)
+    {
+        pair->volume = volume;
+    }
+    else
+    {
+        pair->volume_ramp = from;
+        pair->volume_step = pcm_volume_step(from, volume, ramp_frames);
+    }
+}
+
+void asrc_pair_set_dither(asrc_pair *pair, int dither)
+{
+    pair->dither = dither;
+}
+
+/*
+ * Volume and dither of a segment the driver just wrote, while it is still
+ * in the cache. Nothing is done at unity, the samples are already final.
+ */
+static void apply_volume(asrc_pair *pair, int16_t *samples, unsigned int frames)
+{
+    const pcm_kernels *k = pcm_kernels_get();
+    unsigned int ch = pair->channels;
+    unsigned int n;
+
+    if (pair->ramp_frames > 0)
+    {
+        n = frames < pair->ramp_frames ? frames : pair->ramp_frames;
+        k->volume_s16(samples, samples, ch, n, pair->volume, pair->volume_step,
+                pair->dither_pos, pair->dither);
+        pair->volume_ramp += (int64_t)n * pair->volume_step;
+        pair->dither_pos += n * ch;
+        samples += n * ch;
+        frames -= n;
+        pair->ramp_frames -= n;
+        pair->volume = pair->ramp_frames > 0 ?
+            (int32_t)(pair->volume_ramp >> PCM_VOLUME_RAMP_BITS) : pair->volume_target;
+    }
+
+    if (frames == 0 || pair->volume == PCM_VOLUME_UNITY)
+        return;
+
+    k->volume_s16(samples, samples, ch, frames, pair->volume, 0, pair->dither_pos, pair->dither);
+    pair->dither_pos += frames * ch;
+}
+
 static void linear_pad_s16(asrc_pair *pair, int16_t *samples, int frames)
 {
     unsigned int ch = pair->channels;
-    unsigned int c;
-    int i;
 
     int src_frames = frames * LINEAR_RATE;
     int dst_frames = frames * (LINEAR_RATE + 1);
-    int16_t *src, *s, *d;
-    int32_t pos;
+    int16_t *src = pair->pad;
     int32_t step = LINEAR_PITCH * (src_frames - 1) / (dst_frames - 1);
 
-    src = (int16_t *) malloc((dst_frames << 1) * ch);
-
     /* first, copy samples to src buffer */
     memcpy(src, samples, (src_frames << 1) * ch);
 
-    for (c = 0; c < ch; c++)
-    {
-        pos = 0;
-        s = src + c;
-        d = samples + c;
-        for (i = 0; i < dst_frames; i++)
-        {
-            *d = ((LINEAR_PITCH - pos) * (*s) + pos * (*(s + ch))) >> LINEAR_PITCH_BITS;
-            d += ch;
-            pos += step;
-            if (pos >= LINEAR_PITCH)
-            {
-                pos -= LINEAR_PITCH;
-                s += ch;
-            }
-        }
-    }
-
-    free (src);
+    pcm_kernels_get()->lerp_s16(samples, src, ch, dst_frames, step);
 }
 
 void asrc_pair_convert_s16(asrc_pair *pair, const int16_t *src, unsigned int src_frames,
@@ -320,6 +411,8 @@ void asrc_pair_convert_s16(asrc_pair *pair, const int16_t *src, unsigned int src
                     pair->index, buf_info.input_buffer_vaddr, buf_info.input_buffer_length,
                     buf_info.output_buffer_vaddr, buf_info.output_buffer_length);
 
+        apply_volume(pair, (int16_t *)d, (buf_info.output_buffer_length >> 1) / pair->channels);
+
         s += in_len;
         src_left -= in_len;
         d += buf_info.output_buffer_length;
@@ -330,6 +423,9 @@ void asrc_pair_convert_s16(asrc_pair *pair, const int16_t *src, unsigned int src
     if (dst_left > 0)
     {
         frames = (dst_left >> 1) / pair->channels;
+        /* the pad buffer holds a period, the frames missing beyond it stay as they are */
+        if (frames > pair->pad_frames)
+            frames = pair->pad_frames;
         /* we use LINEAR_RATE * N frames to generate (LINEAR_RATE+1)*N frames */
         samples = (int16_t *)d - frames * LINEAR_RATE * pair->channels;
         if (frames > 0 && samples >= dst)
@@ -27,6 +27,8 @@
 #include <stdint.h>
 #include <imx/linux/mxc_asrc.h>
 
+#include "rt_arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -46,10 +48,27 @@ typedef struct {
     uint32_t den;
 
     int is_converting;
+
+    /* room of linear_pad_s16(), sized for an output period */
+    int16_t *pad;
+    unsigned int pad_frames;
+    /* real-time mode: the pad buffer is locked */
+    int rt;
+    rt_arena *arena;
+
+    /* output volume in Q14, ramping to volume_target over ramp_frames */
+    int32_t volume;
+    int32_t volume_target;
+    /* ramping volume and its step, with PCM_VOLUME_RAMP_BITS more fraction bits */
+    int64_t volume_ramp;
+    int64_t volume_step;
+    unsigned int ramp_frames;
+    int dither;
+    uint32_t dither_pos;
 } asrc_pair;
 
 asrc_pair *asrc_pair_create(unsigned int channels, ssize_t in_period_frames,
-        ssize_t out_period_frames, unsigned int in_rate, unsigned int out_rate, int type);
+        ssize_t out_period_frames, unsigned int in_rate, unsigned int out_rate, int type, int rt);
 
 void asrc_pair_destroy(asrc_pair *pair);
 
@@ -60,6 +79,15 @@ int asrc_pair_set_rate(asrc_pair *pair, ssize_t in_period_frames,
 
 void asrc_pair_reset(asrc_pair *pair);
 
+/*
+ * Ramps the output volume, Q14 from 0 to PCM_VOLUME_MAX, to volume over
+ * ramp_frames output frames, from the next conversion.
+ */
+void asrc_pair_set_volume(asrc_pair *pair, int32_t volume, unsigned int ramp_frames);
+
+/* PCM_DITHER_NONE, _TPDF or _SHAPED, added while the volume is not unity. */
+void asrc_pair_set_dither(asrc_pair *pair, int dither);
+
 void asrc_pair_convert_s16(asrc_pair *pair, const int16_t *src, unsigned int src_frames,
         int16_t *dst, unsigned int dst_frames);
 
@@ -0,0 +1,441 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Soak test of the frame accounting of asrcrate.
+ *
+ * The rate plugin is driven the way pcm_rate drives it for playback, one
+ * convert_s16() per slave period, for days of audio at the speed of the
+ * cpu. /dev/mxc_asrc is not touched: open() and ioctl() of the device are
+ * answered here by a stand-in of the ASRC driver that converts at the
+ * exact ratio, keeps some input frames in its pipeline and holds in a
+ * bounded fifo the output frames the buffer it is given has no room for,
+ * dropping the ones beyond it.
+ *
+ * Every simulated hour, and for the whole run, it prints:
+ *  - the periods asrc_pair_convert_s16() padded and the frames it was short,
+ *  - the frames the driver dropped,
+ *  - the latency creep: how much the delay from the app writing a frame to
+ *    it being heard grew since the first second,
+ *  - the drift of the app position pcm_rate reports against the slave clock,
+ *  - the cpu time spent in convert_s16() per simulated hour, the stand-in
+ *    excluded.
+ *
+ * Each accounting strategy is a separate run:
+ *  round   pcm_rate today: fixed app periods rounded from the slave one, the
+ *          position within a period through input_frames() of the plugin
+ *  floor   the same periods, the position within a period rounded down
+ *  carry   app periods of either size that carry the rounding error over,
+ *          so that they sum to the exact ratio
+ *
+ * -m fails the run when the drift of a strategy goes beyond the given
+ * milliseconds, to catch regressions. The wrappers of open() and ioctl()
+ * need glibc.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <math.h>
+#include <sys/syscall.h>
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_rate.h>
+#include <imx/linux/mxc_asrc.h>
+
+#define ARRAY_SIZE(ary)                       (sizeof(ary)/sizeof(ary[0]))
+
+#define ASRC_DEVICE                           "/dev/mxc_asrc" /* as in asrc_pair.c */
+#define SOAK_TONE_FRAMES                      1024
+#define SOAK_SETTLE_SECONDS                   1
+
+enum { ACCT_ROUND, ACCT_FLOOR, ACCT_CARRY };
+
+static const char *const strategies[] = { "round", "floor", "carry" };
+
+int SND_PCM_RATE_PLUGIN_ENTRY(asrcrate) (unsigned int version, void **objp,
+					   snd_pcm_rate_ops_t *ops);
+
+struct soak_opts {
+	unsigned int in_rate;
+	unsigned int out_rate;
+	unsigned int channels;
+	unsigned int period;            /* slave frames */
+	unsigned int hours;
+	unsigned int latency;           /* input frames in the pipeline of the driver */
+	unsigned int fifo;              /* output frames it holds */
+	double max_drift_ms;
+	int strategy;                   /* -1 for all of them */
+};
+
+/* Counters of a simulated hour or of a whole run. */
+struct soak_stats {
+	uint64_t periods;
+	uint64_t padded;
+	uint64_t short_frames;
+	uint64_t dropped;
+	double cpu_ns;
+	double max_drift;               /* frames at the app rate */
+};
+
+/* The stand-in of the ASRC driver, for the single pair the plugin opens. */
+static struct {
+	int fd;
+	unsigned int channels;
+	unsigned int in_rate;
+	unsigned int out_rate;
+	unsigned int latency;
+	unsigned int fifo;
+	uint64_t in_total;
+	uint64_t produced;
+	uint64_t pending;
+	uint64_t delivered;
+	uint64_t dropped;
+	double ns;
+	int16_t *tone;
+} model = { .fd = -1 };
+
+static double cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Converts the whole input: the frames out of the pipeline go to the
+ * output buffer, those without room wait in the fifo.
+ */
+static void model_convert(struct asrc_convert_buffer *buf)
+{
+	unsigned int frame = model.channels * sizeof(int16_t);
+	uint64_t produced, n, k, chunk, pos;
+	int16_t *out = buf->output_buffer_vaddr;
+
+	model.in_total += buf->input_buffer_length / frame;
+	produced = model.in_total > model.latency ?
+		   (model.in_total - model.latency) * model.out_rate / model.in_rate : 0;
+	model.pending += produced - model.produced;
+	model.produced = produced;
+
+	n = buf->output_buffer_length / frame;
+	if (n > model.pending)
+		n = model.pending;
+	for (k = 0; k < n; k += chunk) {
+		pos = (model.delivered + k) % SOAK_TONE_FRAMES;
+		chunk = n - k < SOAK_TONE_FRAMES - pos ? n - k : SOAK_TONE_FRAMES - pos;
+		memcpy(out + k * model.channels, model.tone + pos * model.channels, chunk * frame);
+	}
+	model.pending -= n;
+	model.delivered += n;
+	buf->output_buffer_length = n * frame;
+
+	if (model.pending > model.fifo) {
+		model.dropped += model.pending - model.fifo;
+		model.pending = model.fifo;
+	}
+}
+
+static int model_ioctl(unsigned long request, void *arg)
+{
+	struct asrc_config *config = arg;
+	double t0 = cpu_ns();
+
+	switch (request) {
+	case ASRC_REQ_PAIR:
+		((struct asrc_req *)arg)->index = ASRC_PAIR_A;
+		break;
+	case ASRC_CONFIG_PAIR:
+		model.channels = config->channel_num;
+		model.in_rate = config->input_sample_rate;
+		model.out_rate = config->output_sample_rate;
+		model.in_total = model.produced = model.pending = 0;
+		model.delivered = model.dropped = 0;
+		break;
+	case ASRC_CONVERT:
+		model_convert(arg);
+		break;
+	default:
+		break;
+	}
+
+	model.ns += cpu_ns() - t0;
+	return 0;
+}
+
+/* asrc_pair.c opens the device and talks to it through these. */
+int open(const char *path, int flags, ...)
+{
+	va_list ap;
+	int mode = 0;
+
+	if (flags & O_CREAT) {
+		va_start(ap, flags);
+		mode = va_arg(ap, int);
+		va_end(ap);
+	}
+
+	if (strcmp(path, ASRC_DEVICE) == 0) {
+		model.fd = syscall(SYS_openat, AT_FDCWD, "/dev/null", O_RDWR);
+		return model.fd;
+	}
+
+	return syscall(SYS_openat, AT_FDCWD, path, flags, mode);
+}
+
+int ioctl(int fd, unsigned long request, ...)
+{
+	va_list ap;
+	void *arg;
+
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	if (fd < 0 || fd != model.fd)
+		return syscall(SYS_ioctl, fd, request, arg);
+
+	return model_ioctl(request, arg);
+}
+
+/* App frames of the k-th slave period. */
+static unsigned int app_period(const struct soak_opts *opts, int strategy, uint64_t k)
+{
+	uint64_t slave = (uint64_t)opts->period * opts->in_rate;
+
+	if (strategy == ACCT_CARRY)
+		return (k + 1) * slave / opts->out_rate - k * slave / opts->out_rate;
+
+	/* the one pcm_rate refines from the slave period */
+	return (slave + opts->out_rate / 2) / opts->out_rate;
+}
+
+/* App position pcm_rate reports rest slave frames into a period. */
+static uint64_t app_position(const struct soak_opts *opts, int strategy, snd_pcm_rate_ops_t *ops,
+			     void *obj, uint64_t consumed, unsigned int rest)
+{
+	if (strategy == ACCT_FLOOR)
+		return consumed + (uint64_t)rest * opts->in_rate / opts->out_rate;
+
+	return consumed + ops->input_frames(obj, rest);
+}
+
+static void print_stats(const char *label, const struct soak_opts *opts, const struct soak_stats *st,
+			double hours, double latency, double drift)
+{
+	printf("%-6s %10llu %8.4f %12llu %10llu %10.3f %10.3f %10.3f %10.2f\n",
+	       label, (unsigned long long)st->periods,
+	       st->periods ? 100.0 * st->padded / st->periods : 0,
+	       (unsigned long long)st->short_frames, (unsigned long long)st->dropped,
+	       latency * 1000 / opts->in_rate, drift * 1000 / opts->in_rate,
+	       st->max_drift * 1000 / opts->in_rate, st->cpu_ns / 1e6 / hours);
+}
+
+static void add_stats(struct soak_stats *total, const struct soak_stats *st)
+{
+	total->periods += st->periods;
+	total->padded += st->padded;
+	total->short_frames += st->short_frames;
+	total->dropped += st->dropped;
+	total->cpu_ns += st->cpu_ns;
+	if (st->max_drift > total->max_drift)
+		total->max_drift = st->max_drift;
+}
+
+/* Heard app frames: what the driver delivered or skipped, less its pipeline. */
+static double heard(const struct soak_opts *opts)
+{
+	return (double)(model.delivered + model.dropped) * opts->in_rate / opts->out_rate;
+}
+
+static int soak(const struct soak_opts *opts, int strategy, struct soak_stats *total)
+{
+	snd_pcm_rate_ops_t ops;
+	snd_pcm_rate_info_t info;
+	struct soak_stats st;
+	void *obj;
+	int16_t *src, *dst;
+	uint64_t k, consumed = 0, spos = 0, hour_frames, dropped, delivered;
+	unsigned int frames, max_frames, q, h = 0;
+	double t0, model_ns, drift = 0, latency, latency0 = 0;
+	char label[16];
+	int err;
+
+	memset(&ops, 0, sizeof(ops));
+	err = SND_PCM_RATE_PLUGIN_ENTRY(asrcrate)(SND_PCM_RATE_PLUGIN_VERSION, &obj, &ops);
+	if (err < 0)
+		return err;
+
+	memset(&info, 0, sizeof(info));
+	info.channels = opts->channels;
+	info.in.format = info.out.format = SND_PCM_FORMAT_S16_LE;
+	info.in.rate = opts->in_rate;
+	info.out.rate = opts->out_rate;
+	info.in.period_size = app_period(opts, ACCT_ROUND, 0);
+	info.out.period_size = opts->period;
+	info.in.buffer_size = info.in.period_size * 4;
+	info.out.buffer_size = info.out.period_size * 4;
+	model.latency = opts->latency;
+	model.fifo = opts->fifo;
+	err = ops.init(obj, &info);
+	if (err < 0) {
+		ops.close(obj);
+		return err;
+	}
+
+	max_frames = app_period(opts, ACCT_ROUND, 0) + 1;
+	src = calloc((size_t)max_frames * opts->channels, sizeof(*src));
+	dst = calloc((size_t)opts->period * opts->channels, sizeof(*dst));
+	if (!src || !dst) {
+		err = -ENOMEM;
+		goto out;
+	}
+	for (k = 0; k < (uint64_t)max_frames * opts->channels; k++)
+		src[k] = 8192 * sin(2 * M_PI * k / opts->channels / 64);
+
+	hour_frames = (uint64_t)opts->out_rate * 3600;
+	memset(total, 0, sizeof(*total));
+	memset(&st, 0, sizeof(st));
+	for (k = 0; h < opts->hours; k++) {
+		frames = app_period(opts, strategy, k);
+
+		dropped = model.dropped;
+		delivered = model.delivered;
+		model_ns = model.ns;
+		t0 = cpu_ns();
+		ops.convert_s16(obj, dst, opts->period, src, frames);
+		st.cpu_ns += cpu_ns() - t0 - (model.ns - model_ns);
+
+		st.periods++;
+		st.dropped += model.dropped - dropped;
+		if (model.delivered - delivered < opts->period) {
+			st.padded++;
+			st.short_frames += opts->period - (model.delivered - delivered);
+		}
+
+		/* positions pcm_rate reports while the slave plays this period */
+		for (q = 0; q < 4; q++) {
+			drift = (double)app_position(opts, strategy, &ops, obj, consumed, opts->period * q / 4) -
+				(double)(spos + opts->period * q / 4) * opts->in_rate / opts->out_rate;
+			if (fabs(drift) > st.max_drift)
+				st.max_drift = fabs(drift);
+		}
+		consumed += frames;
+		spos += opts->period;
+
+		latency = consumed - heard(opts);
+		if (spos <= (uint64_t)opts->out_rate * SOAK_SETTLE_SECONDS)
+			latency0 = latency;
+
+		if (spos >= hour_frames * (h + 1)) {
+			h++;
+			snprintf(label, sizeof(label), "%u", h);
+			print_stats(label, opts, &st, 1, latency - latency0, drift);
+			add_stats(total, &st);
+			memset(&st, 0, sizeof(st));
+		}
+	}
+
+	latency = consumed - heard(opts);
+	print_stats("total", opts, total, opts->hours, latency - latency0, drift);
+	err = total->max_drift * 1000 / opts->in_rate > opts->max_drift_ms ? -ERANGE : 0;
+
+out:
+	free(src);
+	free(dst);
+	ops.free(obj);
+	ops.close(obj);
+	return err;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-i in_rate] [-o out_rate] [-c channels] [-p period] [-t hours]\n"
+	       "          [-l latency] [-f fifo] [-m max_drift_ms] [-a round|floor|carry]\n"
+	       "  period is in slave frames, latency the input frames the driver holds in\n"
+	       "  its pipeline and fifo the output frames it keeps when the buffer is full.\n"
+	       "  Without -a every accounting strategy is run.\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	struct soak_opts opts = {
+		.in_rate = 44100,
+		.out_rate = 48000,
+		.channels = 2,
+		.period = 1024,
+		.hours = 24,
+		.latency = 32,
+		.fifo = 64,
+		.max_drift_ms = INFINITY,
+		.strategy = -1,
+	};
+	struct soak_stats total;
+	unsigned int s, i;
+	int opt, err, failed = 0;
+
+	while ((opt = getopt(argc, argv, "i:o:c:p:t:l:f:m:a:h")) != -1) {
+		switch (opt) {
+		case 'i': opts.in_rate = atoi(optarg); break;
+		case 'o': opts.out_rate = atoi(optarg); break;
+		case 'c': opts.channels = atoi(optarg); break;
+		case 'p': opts.period = atoi(optarg); break;
+		case 't': opts.hours = atoi(optarg); break;
+		case 'l': opts.latency = atoi(optarg); break;
+		case 'f': opts.fifo = atoi(optarg); break;
+		case 'm': opts.max_drift_ms = atof(optarg); break;
+		case 'a':
+			for (i = 0; i < ARRAY_SIZE(strategies); i++)
+				if (strcmp(optarg, strategies[i]) == 0)
+					opts.strategy = i;
+			if (opts.strategy < 0) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (opts.in_rate == 0 || opts.out_rate == 0 || opts.channels == 0 ||
+	    opts.period < 2 || opts.hours == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	model.tone = malloc((size_t)SOAK_TONE_FRAMES * opts.channels * sizeof(*model.tone));
+	if (!model.tone)
+		return 1;
+	for (i = 0; i < SOAK_TONE_FRAMES * opts.channels; i++)
+		model.tone[i] = 8192 * sin(2 * M_PI * (i / opts.channels) / SOAK_TONE_FRAMES);
+
+	printf("%u -> %u Hz, %u channels, %u frames slave periods, %u hours\n",
+	       opts.in_rate, opts.out_rate, opts.channels, opts.period, opts.hours);
+
+	for (s = 0; s < ARRAY_SIZE(strategies); s++) {
+		if (opts.strategy >= 0 && (unsigned int)opts.strategy != s)
+			continue;
+
+		printf("\n%s: app periods of %u frames%s\n", strategies[s], app_period(&opts, s, 0),
+		       s == ACCT_CARRY ? " or one more" : "");
+		printf("%-6s %10s %8s %12s %10s %10s %10s %10s %10s\n",
+		       "hour", "periods", "padded %", "short frames", "dropped",
+		       "creep ms", "drift ms", "max ms", "cpu ms/h");
+		err = soak(&opts, s, &total);
+		if (err == -ERANGE) {
+			printf("FAIL: drift beyond %.3f ms\n", opts.max_drift_ms);
+			failed = 1;
+		} else if (err < 0) {
+			printf("FAIL: %s\n", snd_strerror(err));
+			failed = 1;
+		}
+	}
+
+	free(model.tone);
+	return failed;
+}
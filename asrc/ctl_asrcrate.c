@@ -0,0 +1,250 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Control plugin of asrcrate: the volume, its ramp and the dither of a
+ * running conversion as mixer elements, through the shared memory page
+ * of its control field.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <alsa/asoundlib.h>
+#include <alsa/control_external.h>
+
+#include "asrc_ctl.h"
+
+#define PLUG_NAME                               asrcCtl
+
+enum {
+	CTL_VOLUME,
+	CTL_VOLUME_RAMP,
+	CTL_DITHER,
+	CTL_ELEMS
+};
+
+static const char *const ctl_names[CTL_ELEMS] = {
+	"Playback Volume",
+	"Playback Volume Ramp",
+	"Playback Dither",
+};
+
+typedef struct snd_ctl_asrc {
+	snd_ctl_ext_t ext;
+	asrc_ctl *ctl;
+} snd_ctl_asrc_t;
+
+static int asrc_elem_count(snd_ctl_ext_t *ext)
+{
+	return CTL_ELEMS;
+}
+
+static int asrc_elem_list(snd_ctl_ext_t *ext, unsigned int offset, snd_ctl_elem_id_t *id)
+{
+	if (offset >= CTL_ELEMS)
+		return -EINVAL;
+
+	snd_ctl_elem_id_set_interface(id, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_id_set_name(id, ctl_names[offset]);
+	return 0;
+}
+
+static snd_ctl_ext_key_t asrc_find_elem(snd_ctl_ext_t *ext, const snd_ctl_elem_id_t *id)
+{
+	const char *name = snd_ctl_elem_id_get_name(id);
+	unsigned int i;
+
+	for (i = 0; i < CTL_ELEMS; i++)
+		if (strcmp(name, ctl_names[i]) == 0)
+			return i;
+
+	return SND_CTL_EXT_KEY_NOT_FOUND;
+}
+
+static int asrc_get_attribute(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key, int *type,
+			      unsigned int *acc, unsigned int *count)
+{
+	if (key >= CTL_ELEMS)
+		return -EINVAL;
+
+	*type = SND_CTL_ELEM_TYPE_INTEGER;
+	*acc = SND_CTL_EXT_ACCESS_READWRITE;
+	*count = 1;
+	return 0;
+}
+
+/* Volume in 0.1 dB, the lowest mutes, ramp in us, dither 0 none, 1 tpdf, 2 shaped. */
+static int asrc_get_integer_info(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+				 long *imin, long *imax, long *istep)
+{
+	*istep = 1;
+	switch (key) {
+	case CTL_VOLUME:
+		*imin = ASRC_CTL_VOLUME_MIN;
+		*imax = ASRC_CTL_VOLUME_MAX;
+		break;
+	case CTL_VOLUME_RAMP:
+		*imin = 0;
+		*imax = ASRC_CTL_RAMP_MAX;
+		break;
+	case CTL_DITHER:
+		*imin = 0;
+		*imax = ASRC_CTL_DITHER_MAX;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int asrc_read_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key, long *value)
+{
+	snd_ctl_asrc_t *asrc = ext->private_data;
+	asrc_ctl *ctl = asrc->ctl;
+
+	switch (key) {
+	case CTL_VOLUME:
+		value[0] = ctl->volume;
+		break;
+	case CTL_VOLUME_RAMP:
+		value[0] = ctl->ramp_us;
+		break;
+	case CTL_DITHER:
+		value[0] = ctl->dither;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Returns 1 when a value changed, the converter applies it on its next period. */
+static int asrc_write_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key, long *value)
+{
+	snd_ctl_asrc_t *asrc = ext->private_data;
+	asrc_ctl *ctl = asrc->ctl;
+	long imin, imax, istep;
+	int changed;
+
+	if (asrc_get_integer_info(ext, key, &imin, &imax, &istep) < 0)
+		return -EINVAL;
+	if (value[0] < imin || value[0] > imax)
+		return -EINVAL;
+
+	switch (key) {
+	case CTL_VOLUME:
+		changed = ctl->volume != value[0];
+		ctl->volume = (int32_t)value[0];
+		break;
+	case CTL_VOLUME_RAMP:
+		changed = ctl->ramp_us != (uint32_t)value[0];
+		ctl->ramp_us = (uint32_t)value[0];
+		break;
+	default:
+		changed = ctl->dither != (uint32_t)value[0];
+		ctl->dither = (uint32_t)value[0];
+		break;
+	}
+
+	if (changed)
+		asrc_ctl_commit(ctl);
+
+	return changed;
+}
+
+static void asrc_ctl_close_ext(snd_ctl_ext_t *ext)
+{
+	snd_ctl_asrc_t *asrc = ext->private_data;
+
+	asrc_ctl_close(asrc->ctl);
+	free(asrc);
+}
+
+static const snd_ctl_ext_callback_t asrc_ctl_funcs = {
+	.elem_count = asrc_elem_count,
+	.elem_list = asrc_elem_list,
+	.find_elem = asrc_find_elem,
+	.get_attribute = asrc_get_attribute,
+	.get_integer_info = asrc_get_integer_info,
+	.read_integer = asrc_read_integer,
+	.write_integer = asrc_write_integer,
+	.close = asrc_ctl_close_ext,
+};
+
+SND_CTL_PLUGIN_DEFINE_FUNC(PLUG_NAME)
+{
+	snd_config_iterator_t i, next;
+	snd_ctl_asrc_t *asrc;
+	const char *control = NULL;
+	const char *id;
+	snd_config_t *n;
+	int err;
+
+	snd_config_for_each(i, next, conf) {
+		n = snd_config_iterator_entry(i);
+
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+
+		if ((strcmp(id, "comment") == 0) || (strcmp(id, "type") == 0) || (strcmp(id, "hint") == 0))
+			continue;
+
+		if (strcmp(id, "control") == 0) {
+			if (snd_config_get_string(n, &control) < 0) {
+				SNDERR("'control' must be a string");
+				return -EINVAL;
+			}
+			continue;
+		}
+
+		SNDERR("Unknown field %s", id);
+		return -EINVAL;
+	}
+
+	if (control == NULL) {
+		SNDERR("No control page defined for asrcCtl");
+		return -EINVAL;
+	}
+
+	asrc = calloc(1, sizeof(*asrc));
+	if (asrc == NULL)
+		return -ENOMEM;
+
+	/* the converter creates the page, the controls only exist once it was opened */
+	asrc->ctl = asrc_ctl_open(control, 0);
+	if (asrc->ctl == NULL) {
+		err = -errno;
+		SNDERR("No asrcrate converter with the control %s", control);
+		free(asrc);
+		return err;
+	}
+
+	asrc->ext.version = SND_CTL_EXT_VERSION;
+	asrc->ext.card_idx = 0;
+	strncpy(asrc->ext.id, "asrcCtl", sizeof(asrc->ext.id) - 1);
+	strncpy(asrc->ext.driver, "asrcrate", sizeof(asrc->ext.driver) - 1);
+	strncpy(asrc->ext.name, "asrcrate", sizeof(asrc->ext.name) - 1);
+	snprintf(asrc->ext.longname, sizeof(asrc->ext.longname), "asrcrate controls of %s", control);
+	strncpy(asrc->ext.mixername, "asrcrate", sizeof(asrc->ext.mixername) - 1);
+	asrc->ext.poll_fd = -1;
+	asrc->ext.callback = &asrc_ctl_funcs;
+	asrc->ext.private_data = asrc;
+
+	err = snd_ctl_ext_create(&asrc->ext, name, mode);
+	if (err < 0) {
+		asrc_ctl_close(asrc->ctl);
+		free(asrc);
+		return err;
+	}
+
+	*handlep = asrc->ext.handle;
+	return 0;
+}
+
+SND_CTL_PLUGIN_SYMBOL(PLUG_NAME);
@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "mix_share.h"
+
+static size_t share_size(const shm_share *hdr)
+{
+	const mix_share *sh = (const mix_share *)hdr;
+
+	return sizeof(mix_share) + (size_t)sh->channels * sh->capacity * sizeof(int32_t);
+}
+
+static const shm_share_kind share_kind = {
+	.magic = MIX_SHARE_MAGIC,
+	.version = MIX_SHARE_VERSION,
+	.mode = MIX_SHARE_MODE,
+	.header = sizeof(mix_share),
+	.size = share_size,
+};
+
+mix_share *mix_share_attach(const char *name, unsigned int rate, unsigned int slave_rate,
+		unsigned int channels, unsigned int block, unsigned int capacity, int *owner)
+{
+	size_t size = sizeof(mix_share) + (size_t)channels * capacity * sizeof(int32_t);
+	mix_share *sh;
+
+	sh = (mix_share *)shm_share_attach(name, &share_kind, size, owner);
+	if (!sh || !*owner)
+		return sh;
+
+	sh->rate = rate;
+	sh->slave_rate = slave_rate;
+	sh->channels = channels;
+	sh->block = block;
+	sh->capacity = capacity;
+	sh->delay = 0;
+	sh->mix_pos = 0;
+	sh->xruns = 0;
+	shm_share_publish(&sh->hdr, &share_kind);
+
+	return sh;
+}
+
+void mix_share_detach(mix_share *sh, const char *name, int owner)
+{
+	if (sh)
+		shm_share_detach(&sh->hdr, name, share_size(&sh->hdr), owner);
+}
+
+void mix_share_add(mix_share *sh, uint64_t pos, const int16_t *src, unsigned int frames)
+{
+	unsigned int n, i;
+	int32_t *dst;
+
+	while (frames > 0) {
+		n = sh->capacity - pos % sh->capacity;
+		if (n > frames)
+			n = frames;
+		dst = mix_share_frame(sh, pos);
+		for (i = 0; i < n * sh->channels; i++)
+			__atomic_fetch_add(&dst[i], src[i], __ATOMIC_RELAXED);
+		src += n * sh->channels;
+		pos += n;
+		frames -= n;
+	}
+}
+
+void mix_share_take(mix_share *sh, int16_t *dst)
+{
+	uint64_t pos = sh->mix_pos;
+	int32_t *src = mix_share_frame(sh, pos);
+	int32_t *prev;
+	unsigned int i;
+	int32_t v;
+
+	__atomic_store_n(&sh->mix_pos, pos + sh->block, __ATOMIC_RELEASE);
+
+	/* the capacity is a multiple of the block, it never wraps */
+	for (i = 0; i < sh->block * sh->channels; i++) {
+		v = __atomic_exchange_n(&src[i], 0, __ATOMIC_ACQ_REL);
+		dst[i] = v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+	}
+
+	/*
+	 * The sums a late pcm finished after the previous block was taken
+	 * would come back a lap later, they are dropped a block later.
+	 */
+	if (pos >= sh->block) {
+		prev = mix_share_frame(sh, pos - sh->block);
+		for (i = 0; i < sh->block * sh->channels; i++)
+			__atomic_store_n(&prev[i], 0, __ATOMIC_RELAXED);
+	}
+}
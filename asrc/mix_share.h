@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file mix_share.h
+   @brief shared memory ring the pcms of one rate are summed in, many writers and one reader
+*/
+
+#ifndef MIX_SHARE_H
+#define MIX_SHARE_H
+
+#include <stdint.h>
+
+#include "shm_share.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIX_SHARE_MAGIC                       0x58494d41 /* "AMIX" */
+#define MIX_SHARE_VERSION                     1
+#define MIX_SHARE_MODE                        0660 /* the user and group of the stream */
+
+/*
+ * Layout of the shared memory segment. The owner fills the header before
+ * setting magic, then only mix_pos, delay, xruns and running change. The
+ * pcms add their samples to the ring at and after mix_pos, the owner takes
+ * a block at mix_pos and leaves zeros behind for the next lap.
+ */
+typedef struct {
+	shm_share hdr;              /* running while the owner converts */
+	uint32_t rate;              /* of the pcms and the ring */
+	uint32_t slave_rate;
+	uint32_t channels;          /* interleaved S16 sums, kept in S32 */
+	uint32_t block;             /* frames taken at once */
+	uint32_t capacity;          /* frames of the ring */
+	uint32_t delay;             /* frames taken but not played yet, at rate */
+	uint32_t reserved;
+	uint64_t mix_pos;           /* frames taken since the start */
+	uint64_t xruns;             /* underruns of the slave */
+	int32_t data[];
+} mix_share;
+
+/*
+ * Attaches to the segment name, creating it when it doesn't exist. *owner
+ * is set when the caller created it and has to take the mix, the other
+ * parameters are then used to size it, else the ones of the owner are
+ * kept.
+ */
+mix_share *mix_share_attach(const char *name, unsigned int rate, unsigned int slave_rate,
+		unsigned int channels, unsigned int block, unsigned int capacity, int *owner);
+
+/* Whether the mix keeps being taken, see shm_share_running(). */
+static inline int mix_share_running(const mix_share *sh)
+{
+	return shm_share_running(&sh->hdr);
+}
+
+/* Takes over the conversion of an owner that left, see shm_share_adopt(). */
+static inline int mix_share_adopt(mix_share *sh)
+{
+	return shm_share_adopt(&sh->hdr);
+}
+
+void mix_share_detach(mix_share *sh, const char *name, int owner);
+
+static inline int32_t *mix_share_frame(mix_share *sh, uint64_t pos)
+{
+	return sh->data + (pos % sh->capacity) * sh->channels;
+}
+
+static inline uint64_t mix_share_pos(const mix_share *sh)
+{
+	return __atomic_load_n(&sh->mix_pos, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Sums frames at pos, which must not be below mix_pos, and end at most
+ * capacity - block beyond it: the block taken last is only cleared with
+ * the next one. Lock free, any number of pcms may add to the same frames.
+ */
+void mix_share_add(mix_share *sh, uint64_t pos, const int16_t *src, unsigned int frames);
+
+/*
+ * Moves the block at mix_pos to dst, saturated to S16, and zeroes it. The
+ * block leaves the ring before the samples are read, so that a pcm adding
+ * to it from then on sees it is late, and is zeroed again with the next
+ * block, so that what it added late is never played.
+ */
+void mix_share_take(mix_share *sh, int16_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
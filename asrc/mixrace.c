@@ -0,0 +1,271 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Race test of the mix ring of asrcMix.
+ *
+ * A pcm checks it is not late, then adds its frames; the owner may take
+ * the block in between. What such a pcm adds is not played, and must not
+ * be played a lap later either.
+ *
+ * First the interleaving is replayed step by step: a pcm adds a block the
+ * owner just took, another one fills the ring as far as it may, then the
+ * ring is taken for two laps, the first holding only the frames of the
+ * second pcm and the second only zeros.
+ *
+ * Then pcm threads add frames just ahead of an owner thread taking a block
+ * every block time, each one stalling up to half a block between its check
+ * and its add the way a preempted pcm would. The pcms add 1 to the frames
+ * of even laps and 64 to those of odd laps, so the owner, which checks
+ * every frame it takes, sees a late add that survived to the next lap.
+ * A pcm the host stalled beyond the block after the one it added to is
+ * out of what the ring guarantees, its frames are excused and counted.
+ * -t sets the seconds of the run, -p the pcms.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "mix_share.h"
+
+#define RACE_RATE                             48000
+#define RACE_CHANNELS                         2
+#define RACE_BLOCK                            64
+#define RACE_CAPACITY                         (8 * RACE_BLOCK)
+#define RACE_MAX_PCMS                         4
+#define RACE_EVEN_LAP                         1
+#define RACE_ODD_LAP                          64
+#define RACE_BLOCK_NS                         (1000000000ULL * RACE_BLOCK / RACE_RATE)
+
+struct race {
+	mix_share *sh;
+	unsigned int seconds;
+	unsigned int pcms;
+	int stop;
+	uint64_t late;                  /* adds the owner took meanwhile */
+	uint64_t overtaken;             /* frames the owner cleared meanwhile */
+	uint64_t blocks;
+	uint64_t excused;               /* samples of overtaken frames */
+	uint64_t bad;                   /* samples holding another lap */
+	uint64_t excuse[RACE_CAPACITY]; /* 1 + the lap an overtaken frame may show in */
+};
+
+static void sleep_ns(uint64_t ns)
+{
+	struct timespec ts = { .tv_sec = 0, .tv_nsec = ns };
+
+	nanosleep(&ts, NULL);
+}
+
+static int16_t lap_value(const mix_share *sh, uint64_t pos)
+{
+	return (pos / sh->capacity) & 1 ? RACE_ODD_LAP : RACE_EVEN_LAP;
+}
+
+static void fill(int16_t *buf, int16_t v, unsigned int frames)
+{
+	unsigned int i;
+
+	for (i = 0; i < frames * RACE_CHANNELS; i++)
+		buf[i] = v;
+}
+
+/* Counts the samples of a taken block which aren't expect. */
+static unsigned int check_block(const int16_t *buf, int16_t expect)
+{
+	unsigned int i, bad = 0;
+
+	for (i = 0; i < RACE_BLOCK * RACE_CHANNELS; i++)
+		if (buf[i] != expect)
+			bad++;
+	return bad;
+}
+
+static int replay(mix_share *sh)
+{
+	int16_t buf[RACE_CAPACITY * RACE_CHANNELS];
+	uint64_t pos, late_pos;
+	unsigned int i, bad = 0;
+
+	/* leave the first lap, the block before mix_pos is then in the ring */
+	for (i = 0; i < RACE_CAPACITY / RACE_BLOCK + 1; i++)
+		mix_share_take(sh, buf);
+
+	/* the pcm is not late, the owner takes the block, the pcm adds it */
+	late_pos = mix_share_pos(sh);
+	mix_share_take(sh, buf);
+	fill(buf, 1, RACE_BLOCK);
+	mix_share_add(sh, late_pos, buf, RACE_BLOCK);
+	if (mix_share_pos(sh) <= late_pos) {
+		fprintf(stderr, "replay: the late add was not seen\n");
+		return -1;
+	}
+
+	/* another pcm writes its buffer and the block it starts ahead */
+	pos = mix_share_pos(sh);
+	fill(buf, 2, sh->capacity - sh->block);
+	mix_share_add(sh, pos, buf, sh->capacity - sh->block);
+
+	for (i = 0; i < sh->capacity / sh->block - 1; i++) {
+		mix_share_take(sh, buf);
+		bad += check_block(buf, 2);
+	}
+	for (i = 0; i < sh->capacity / sh->block; i++) {
+		mix_share_take(sh, buf);
+		bad += check_block(buf, 0);
+	}
+
+	if (bad) {
+		fprintf(stderr, "replay: %u samples were played wrong\n", bad);
+		return -1;
+	}
+	printf("replay: ok\n");
+	return 0;
+}
+
+static void *pcm_thread(void *arg)
+{
+	struct race *race = arg;
+	mix_share *sh = race->sh;
+	int16_t buf[RACE_BLOCK * RACE_CHANNELS];
+	unsigned int seed = (uintptr_t)&buf;
+	uint64_t pos, w = 0;
+	unsigned int n, i;
+
+	while (!__atomic_load_n(&race->stop, __ATOMIC_RELAXED)) {
+		pos = mix_share_pos(sh);
+		if (w < pos)
+			w = pos;
+		/* stay within a block of the owner, where the race is */
+		if (w >= pos + sh->block) {
+			sleep_ns(RACE_BLOCK_NS / 8);
+			continue;
+		}
+
+		n = 1 + rand_r(&seed) % (sh->block / 4);
+		for (i = 0; i < n; i++)
+			fill(buf + i * RACE_CHANNELS, lap_value(sh, w + i), 1);
+		sleep_ns(rand_r(&seed) % (RACE_BLOCK_NS / 2));
+		mix_share_add(sh, w, buf, n);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		pos = mix_share_pos(sh);
+		if (pos > w)
+			__atomic_fetch_add(&race->late, 1, __ATOMIC_RELAXED);
+		for (i = 0; i < n; i++, w++) {
+			if (pos < w - w % sh->block + 2 * sh->block)
+				continue;
+			__atomic_store_n(&race->excuse[w % sh->capacity], w / sh->capacity + 2,
+					 __ATOMIC_RELAXED);
+			__atomic_fetch_add(&race->overtaken, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return NULL;
+}
+
+static void owner_run(struct race *race)
+{
+	mix_share *sh = race->sh;
+	int16_t buf[RACE_BLOCK * RACE_CHANNELS];
+	struct timespec next;
+	uint64_t pos, f, blocks;
+	struct timespec now;
+	unsigned int i;
+	int16_t v, expect;
+
+	blocks = (uint64_t)race->seconds * RACE_RATE / sh->block;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (race->blocks = 0; race->blocks < blocks; race->blocks++) {
+		next.tv_nsec += RACE_BLOCK_NS;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		/* a late wakeup is not caught up, the pcms keep a block to stall in */
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > next.tv_sec ||
+		    (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec))
+			next = now;
+
+		pos = sh->mix_pos;
+		mix_share_take(sh, buf);
+		for (i = 0; i < sh->block * sh->channels; i++) {
+			f = pos + i / sh->channels;
+			expect = lap_value(sh, f);
+			v = buf[i];
+			if (v % expect == 0 && v / expect <= (int)race->pcms)
+				continue;
+			if (__atomic_load_n(&race->excuse[f % sh->capacity], __ATOMIC_RELAXED) ==
+			    f / sh->capacity + 1)
+				race->excused++;
+			else
+				race->bad++;
+		}
+	}
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-t seconds] [-p pcms]\n"
+	       "  pcms is at most %d.\n", name, RACE_MAX_PCMS);
+}
+
+int main(int argc, char *argv[])
+{
+	struct race race = { .seconds = 10, .pcms = RACE_MAX_PCMS };
+	pthread_t threads[RACE_MAX_PCMS];
+	char name[32];
+	unsigned int i;
+	int opt, owner, err;
+
+	while ((opt = getopt(argc, argv, "t:p:h")) != -1) {
+		switch (opt) {
+		case 't': race.seconds = atoi(optarg); break;
+		case 'p': race.pcms = atoi(optarg); break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (race.pcms < 1 || race.pcms > RACE_MAX_PCMS) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	snprintf(name, sizeof(name), "/asrcmix-race-%d", getpid());
+	race.sh = mix_share_attach(name, RACE_RATE, RACE_RATE, RACE_CHANNELS, RACE_BLOCK,
+				   RACE_CAPACITY, &owner);
+	if (!race.sh || !owner) {
+		fprintf(stderr, "Unable to create the share %s\n", name);
+		return 1;
+	}
+
+	err = replay(race.sh);
+	if (err < 0)
+		goto out;
+
+	for (i = 0; i < race.pcms; i++)
+		pthread_create(&threads[i], NULL, pcm_thread, &race);
+	owner_run(&race);
+	__atomic_store_n(&race.stop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < race.pcms; i++)
+		pthread_join(threads[i], NULL);
+
+	printf("race: %llu blocks, %llu late adds, %llu samples of another lap\n"
+	       "      %llu frames overtaken by a stall of the host, %llu of their samples excused\n",
+	       (unsigned long long)race.blocks, (unsigned long long)race.late,
+	       (unsigned long long)race.bad, (unsigned long long)race.overtaken,
+	       (unsigned long long)race.excused);
+	if (race.bad)
+		err = -1;
+
+out:
+	mix_share_detach(race.sh, name, owner);
+	return err < 0 ? 1 : 0;
+}
@@ -0,0 +1,818 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Mix then resample playback plugin: the pcms playing at the same rate
+ * are summed in a shared memory ring at that rate, and one of them, the
+ * first until it leaves, converts the mix to the slave rate with a single
+ * ASRC pair. The pairs and the conversions follow the rates in use, not
+ * the pcms.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_external.h>
+#include <alsa/global.h>
+
+#include "asrc_pair.h"
+#include "mix_share.h"
+
+#define PLUG_NAME                               asrcMix
+
+#define ARRAY_SIZE(ary)                       (sizeof(ary)/sizeof(ary[0]))
+
+#define MIN_PCM_CHANNELS                      1
+#define MAX_PCM_CHANNELS                      10 /* of all the ASRC pairs */
+#define MIN_PERIOD_BYTES                      64
+#define MAX_PERIOD_BYTES                      65536
+#define MAX_BUFFER_BYTES                      (4 * MAX_PERIOD_BYTES)
+#define MAX_PERIODS                           1024
+#define MIX_BLOCK_MS                          10
+#define MIX_SLAVE_PERIODS                     4
+
+typedef struct snd_pcm_asrc_mix {
+	snd_pcm_ioplug_t io;
+	snd_pcm_uframes_t boundary;
+	/* configuration */
+	char *slave_name;
+	char *share;
+	unsigned int channels;
+	unsigned int slave_rate;
+	/* ring of the rate of the stream, attached at hw_params */
+	char *share_name;
+	mix_share *sh;
+	int owner;
+	int timer;
+	/* frames written before the start, added to the ring by it */
+	int16_t *prefill;
+	uint64_t base;                      /* ring position of the first frame */
+	uint64_t written;
+	int started;
+	/* owner: takes the mix, converts and plays it on the slave, the others wait to adopt the ring */
+	snd_pcm_t *slave;
+	asrc_pair *pair;
+	unsigned int out_block;             /* slave frames of a block */
+	int16_t *mix_buf;
+	int16_t *out_buf;
+	pthread_t thread;
+	int thread_exit;
+} snd_pcm_asrc_mix_t;
+
+/* Input rates of the ASRC, any rate goes through when it is the one of the slave. */
+static const unsigned int asrc_rates[] = {
+	8000, 16000, 22050, 32000, 44100, 48000, 64000, 88200, 96000, 176400, 192000
+};
+
+static unsigned int gcd(unsigned int a, unsigned int b)
+{
+	unsigned int t;
+
+	while (b != 0) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/*
+ * About MIX_BLOCK_MS of frames, a multiple of the smallest count of frames
+ * converted to a whole count of slave frames: every block gives the ASRC
+ * the exact ratio, and nothing is carried over or padded.
+ */
+static unsigned int mix_block(unsigned int rate, unsigned int slave_rate)
+{
+	unsigned int unit = rate / gcd(rate, slave_rate);
+	unsigned int block = rate * MIX_BLOCK_MS / 1000 / unit * unit;
+
+	return block < unit ? unit : block;
+}
+
+static snd_pcm_sframes_t consumed(snd_pcm_asrc_mix_t *mix)
+{
+	uint64_t pos = mix_share_pos(mix->sh);
+
+	return pos > mix->base ? (snd_pcm_sframes_t)(pos - mix->base) : 0;
+}
+
+static int owner_open(snd_pcm_asrc_mix_t *mix);
+
+/*
+ * Every pcm attached to a ring runs this thread, from its hw_params to its
+ * hw_free or close. The one of the owner takes a block of the mix every
+ * slave period: the slave write paces the ring, a slave underrun only
+ * costs a restart, the pcms see nothing of it. The others check every
+ * block whether the owner left or died, the first one to notice adopts
+ * the ring and converts it from then on with its own slave and pair.
+ */
+static void *mix_thread(void *arg)
+{
+	snd_pcm_asrc_mix_t *mix = arg;
+	mix_share *sh = mix->sh;
+	unsigned int ch = sh->channels;
+	struct timespec ts = { 0, MIX_BLOCK_MS * 1000000 };
+	snd_pcm_sframes_t frames, delay;
+	const int16_t *out;
+	unsigned int done;
+	int err;
+
+	while (!__atomic_load_n(&mix->thread_exit, __ATOMIC_ACQUIRE)) {
+		if (!mix->owner) {
+			if (!mix_share_adopt(sh)) {
+				nanosleep(&ts, NULL);
+				continue;
+			}
+			mix->owner = 1;
+			err = owner_open(mix);
+			if (err < 0) {
+				SNDERR("Unable to take the share %s over: %s", mix->share_name, snd_strerror(err));
+				goto stop;
+			}
+		}
+
+		mix_share_take(sh, mix->mix_buf);
+		out = mix->mix_buf;
+		if (mix->pair) {
+			asrc_pair_convert_s16(mix->pair, mix->mix_buf, sh->block * ch,
+					      mix->out_buf, mix->out_block * ch);
+			out = mix->out_buf;
+		}
+
+		for (done = 0; done < mix->out_block; done += frames) {
+			frames = snd_pcm_writei(mix->slave, out + done * ch, mix->out_block - done);
+			if (frames == -EPIPE) {
+				__atomic_add_fetch(&sh->xruns, 1, __ATOMIC_RELAXED);
+				frames = snd_pcm_prepare(mix->slave);
+			} else if (frames < 0) {
+				frames = snd_pcm_recover(mix->slave, frames, 1);
+			}
+			if (frames < 0) {
+				SNDERR("Shared playback %s stopped: %s", mix->share_name, snd_strerror(frames));
+				goto stop;
+			}
+		}
+
+		if (snd_pcm_delay(mix->slave, &delay) == 0 && delay > 0)
+			__atomic_store_n(&sh->delay, (uint32_t)((uint64_t)delay * sh->rate / sh->slave_rate),
+					 __ATOMIC_RELAXED);
+	}
+
+	return NULL;
+
+stop:
+	/* the pcms get -ENODEV from now on */
+	__atomic_store_n(&sh->hdr.running, 0, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static int slave_params(snd_pcm_asrc_mix_t *mix)
+{
+	snd_pcm_hw_params_t *params;
+	snd_pcm_sw_params_t *sparams;
+	snd_pcm_uframes_t period = mix->out_block, buffer = mix->out_block * MIX_SLAVE_PERIODS;
+	int err;
+
+	snd_pcm_hw_params_alloca(&params);
+	err = snd_pcm_hw_params_any(mix->slave, params);
+	if (err < 0) {
+		SNDERR("Broken configuration for playback: no configurations available: %s", snd_strerror(err));
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_access(mix->slave, params, SND_PCM_ACCESS_RW_INTERLEAVED);
+	err = err == 0 ? snd_pcm_hw_params_set_format(mix->slave, params, SND_PCM_FORMAT_S16_LE) : err;
+	err = err == 0 ? snd_pcm_hw_params_set_channels(mix->slave, params, mix->sh->channels) : err;
+	if (err < 0) {
+		SNDERR("The slave can't play %u channels of S16_LE: %s", mix->sh->channels, snd_strerror(err));
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_rate(mix->slave, params, mix->sh->slave_rate, 0);
+	if (err < 0) {
+		SNDERR("The slave can't play at %u Hz, see 'slave_rate'", mix->sh->slave_rate);
+		return err;
+	}
+
+	/* a period per block when the slave allows it, a dmix keeps its own */
+	snd_pcm_hw_params_set_period_size_near(mix->slave, params, &period, NULL);
+	snd_pcm_hw_params_set_buffer_size_near(mix->slave, params, &buffer);
+	err = snd_pcm_hw_params(mix->slave, params);
+	if (err < 0) {
+		SNDERR("Couldnt set hw params: %s", snd_strerror(err));
+		return err;
+	}
+
+	snd_pcm_sw_params_alloca(&sparams);
+	err = snd_pcm_sw_params_current(mix->slave, sparams);
+	err = err == 0 ? snd_pcm_sw_params_set_start_threshold(mix->slave, sparams, mix->out_block) : err;
+	err = err == 0 ? snd_pcm_sw_params(mix->slave, sparams) : err;
+	if (err < 0)
+		SNDERR("Unable to set the swparams for playback: %s", snd_strerror(err));
+
+	return err;
+}
+
+/* Open the slave and the pair of the rate of the share to take the mix. */
+static int owner_open(snd_pcm_asrc_mix_t *mix)
+{
+	mix_share *sh = mix->sh;
+	int err;
+
+	mix->out_block = (uint64_t)sh->block * sh->slave_rate / sh->rate;
+
+	err = snd_pcm_open(&mix->slave, mix->slave_name, SND_PCM_STREAM_PLAYBACK, 0);
+	if (err < 0) {
+		SNDERR("Cant open slave %s", mix->slave_name);
+		return err;
+	}
+
+	err = slave_params(mix);
+	if (err < 0)
+		return err;
+
+	if (sh->rate != sh->slave_rate) {
+		mix->pair = asrc_pair_create(sh->channels, sh->block * sh->channels,
+					     mix->out_block * sh->channels, sh->rate, sh->slave_rate, 0, 0);
+		if (!mix->pair) {
+			SNDERR("No ASRC pair left to convert %u to %u Hz", sh->rate, sh->slave_rate);
+			return -EBUSY;
+		}
+	}
+
+	mix->mix_buf = malloc((size_t)sh->block * sh->channels * sizeof(int16_t));
+	mix->out_buf = malloc((size_t)mix->out_block * sh->channels * sizeof(int16_t));
+	if (!mix->mix_buf || !mix->out_buf)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void owner_close(snd_pcm_asrc_mix_t *mix)
+{
+	if (mix->slave) {
+		snd_pcm_drop(mix->slave);
+		snd_pcm_close(mix->slave);
+		mix->slave = NULL;
+	}
+	if (mix->pair) {
+		asrc_pair_destroy(mix->pair);
+		mix->pair = NULL;
+	}
+	free(mix->mix_buf);
+	mix->mix_buf = NULL;
+	free(mix->out_buf);
+	mix->out_buf = NULL;
+}
+
+/*
+ * Attach to the ring of the rate of the stream, the first pcm to use a
+ * rate becomes the owner of its ring until it leaves it to another one,
+ * see mix_thread(). The ring holds the largest buffer,
+ * the block a stream starts ahead and the block being cleared after a
+ * take, see mix_share_take().
+ */
+static int share_open(snd_pcm_asrc_mix_t *mix, unsigned int rate)
+{
+	unsigned int block, capacity;
+	int err;
+
+	block = mix_block(rate, mix->slave_rate);
+	capacity = (MAX_BUFFER_BYTES / (mix->channels * sizeof(int16_t)) + block - 1) / block * block + 2 * block;
+
+	mix->share_name = malloc(strlen(mix->share) + sizeof("/asrcmix--192000"));
+	if (!mix->share_name)
+		return -ENOMEM;
+	sprintf(mix->share_name, "/asrcmix-%s-%u", mix->share, rate);
+
+	mix->sh = mix_share_attach(mix->share_name, rate, mix->slave_rate, mix->channels, block,
+				   capacity, &mix->owner);
+	if (!mix->sh) {
+		err = errno != 0 ? -errno : -ENOMEM;
+		SNDERR("Unable to attach to the share %s", mix->share_name);
+		free(mix->share_name);
+		mix->share_name = NULL;
+		return err;
+	}
+	if (mix->sh->channels != mix->channels) {
+		SNDERR("The share %s has %u channels", mix->share_name, mix->sh->channels);
+		return -EINVAL;
+	}
+	if (mix->io.buffer_size > mix->sh->capacity - 2 * mix->sh->block) {
+		SNDERR("The buffer can't exceed %u frames", mix->sh->capacity - 2 * mix->sh->block);
+		return -EINVAL;
+	}
+
+	if (mix->owner) {
+		err = owner_open(mix);
+		if (err < 0)
+			return err;
+	}
+
+	mix->thread_exit = 0;
+	err = pthread_create(&mix->thread, NULL, mix_thread, mix);
+	if (err != 0) {
+		mix->thread_exit = 1;
+		return -err;
+	}
+
+	return 0;
+}
+
+static void share_close(snd_pcm_asrc_mix_t *mix)
+{
+	if (mix->thread_exit == 0) {
+		__atomic_store_n(&mix->thread_exit, 1, __ATOMIC_RELEASE);
+		pthread_join(mix->thread, NULL);
+		mix->thread_exit = 1;
+	}
+	owner_close(mix);
+	/* one of the pcms left converts for the others */
+	mix_share_detach(mix->sh, mix->share_name, mix->owner);
+	mix->sh = NULL;
+	mix->owner = 0;
+	free(mix->share_name);
+	mix->share_name = NULL;
+}
+
+/* Wake the app up once per block, the ring has no fd to poll. */
+static void arm_timer(snd_pcm_asrc_mix_t *mix, int on)
+{
+	struct itimerspec its;
+	uint64_t ns = 0;
+
+	if (on)
+		ns = mix->sh->block * 1000000000ull / mix->sh->rate;
+	its.it_value.tv_sec = its.it_interval.tv_sec = ns / 1000000000;
+	its.it_value.tv_nsec = its.it_interval.tv_nsec = ns % 1000000000;
+	timerfd_settime(mix->timer, 0, &its, NULL);
+}
+
+/* The stream joins the mix a block after the one being taken, the frames written so far first. */
+static int mix_start(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	if (!mix_share_running(mix->sh))
+		return -ENODEV;
+
+	mix->base = mix_share_pos(mix->sh) + mix->sh->block;
+	mix_share_add(mix->sh, mix->base, mix->prefill, mix->written);
+	mix->started = 1;
+
+	return 0;
+}
+
+/* The frames already summed play out, they can't be told from the ones of the other pcms. */
+static int mix_stop(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	mix->started = 0;
+	return 0;
+}
+
+/* Frames taken by the owner, an underrun once it took more than was written. */
+static snd_pcm_sframes_t mix_pointer(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+	snd_pcm_sframes_t done;
+
+	if (!mix->started)
+		return 0;
+	if (!mix_share_running(mix->sh))
+		return -ENODEV;
+
+	done = consumed(mix);
+	if ((uint64_t)done > mix->written)
+		return -EPIPE;
+
+	return done % mix->boundary;
+}
+
+/* Frames in the ring, then in the slave and the ASRC. */
+static int mix_delay(snd_pcm_ioplug_t *io, snd_pcm_sframes_t *delayp)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	*delayp = __atomic_load_n(&mix->sh->delay, __ATOMIC_RELAXED) + mix->written;
+	if (mix->started)
+		*delayp -= consumed(mix);
+	return 0;
+}
+
+/*
+ * Sum the frames in the ring at their position. When the owner took them
+ * meanwhile they are an underrun, the part added too late is cleared by
+ * the owner with its next block.
+ */
+static snd_pcm_sframes_t mix_transfer(snd_pcm_ioplug_t *io, const snd_pcm_channel_area_t *areas,
+				      snd_pcm_uframes_t offset, snd_pcm_uframes_t size)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+	const int16_t *src;
+	uint64_t pos;
+
+	src = (const int16_t *)((const char *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8);
+
+	if (!mix->started) {
+		memcpy(mix->prefill + mix->written * io->channels, src, size * io->channels * sizeof(int16_t));
+		mix->written += size;
+		return size;
+	}
+
+	if (!mix_share_running(mix->sh))
+		return -ENODEV;
+
+	pos = mix->base + mix->written;
+	if (mix_share_pos(mix->sh) > pos)
+		return -EPIPE;
+	mix_share_add(mix->sh, pos, src, size);
+	if (mix_share_pos(mix->sh) > pos)
+		return -EPIPE;
+
+	mix->written += size;
+	return size;
+}
+
+/* Wait until the owner took the last frame, then for the slave to play it. */
+static int mix_drain(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+	struct timespec ts;
+	uint64_t ns;
+	int err;
+
+	if (!mix->started && mix->written > 0) {
+		err = mix_start(io);
+		if (err < 0)
+			return err;
+	}
+
+	while (mix->started && (uint64_t)consumed(mix) < mix->written) {
+		if (!mix_share_running(mix->sh))
+			return -ENODEV;
+		ns = mix->sh->block * 1000000000ull / mix->sh->rate;
+		ts.tv_sec = ns / 1000000000;
+		ts.tv_nsec = ns % 1000000000;
+		nanosleep(&ts, NULL);
+	}
+
+	ns = __atomic_load_n(&mix->sh->delay, __ATOMIC_RELAXED) * 1000000000ull / mix->sh->rate;
+	ts.tv_sec = ns / 1000000000;
+	ts.tv_nsec = ns % 1000000000;
+	nanosleep(&ts, NULL);
+
+	return 0;
+}
+
+static int mix_close(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	if (mix->sh)
+		share_close(mix);
+	if (mix->timer >= 0)
+		close(mix->timer);
+	free(mix->prefill);
+	free(mix->slave_name);
+	free(mix->share);
+	free(mix);
+	return 0;
+}
+
+static int mix_hw_free(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	if (mix->sh) {
+		arm_timer(mix, 0);
+		share_close(mix);
+	}
+	free(mix->prefill);
+	mix->prefill = NULL;
+	return 0;
+}
+
+static int mix_hw(snd_pcm_ioplug_t *io, snd_pcm_hw_params_t *params)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+	int err;
+
+	mix_hw_free(io);
+
+	mix->prefill = malloc(io->buffer_size * io->channels * sizeof(int16_t));
+	if (!mix->prefill)
+		return -ENOMEM;
+
+	err = share_open(mix, io->rate);
+	if (err < 0)
+		mix_hw_free(io);
+
+	return err;
+}
+
+static int mix_sw(snd_pcm_ioplug_t *io, snd_pcm_sw_params_t *params)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	snd_pcm_sw_params_get_boundary(params, &mix->boundary);
+	return 0;
+}
+
+static int mix_prepare(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	if (!mix_share_running(mix->sh))
+		return -ENODEV;
+
+	mix->started = 0;
+	mix->written = 0;
+	arm_timer(mix, 1);
+	return 0;
+}
+
+static int mix_poll_descriptors_count(snd_pcm_ioplug_t *io)
+{
+	return 1;
+}
+
+static int mix_poll_descriptors(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int space)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+
+	if (space < 1)
+		return -EINVAL;
+	pfd->fd = mix->timer;
+	pfd->events = POLLIN;
+	pfd->revents = 0;
+	return 1;
+}
+
+/* POLLOUT once a period is free in the buffer, POLLERR on an underrun or without owner. */
+static int mix_poll_revents(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int nfds, unsigned short *revents)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+	snd_pcm_sframes_t done = mix->started ? consumed(mix) : 0;
+	uint64_t expirations;
+
+	*revents = 0;
+	if (nfds == 0 || !(pfd->revents & POLLIN) || read(mix->timer, &expirations, sizeof(expirations)) < 0)
+		return 0;
+
+	if (!mix_share_running(mix->sh) || (uint64_t)done > mix->written)
+		*revents = POLLERR;
+	else if (io->buffer_size - (mix->written - done) >= io->period_size)
+		*revents = POLLOUT;
+
+	return 0;
+}
+
+static void mix_dump(snd_pcm_ioplug_t *io, snd_output_t *out)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+	mix_share *sh = mix->sh;
+
+	snd_output_printf(out, "%s\n", io->name);
+	snd_output_printf(out, "Its setup is:\n");
+	snd_pcm_dump_setup(io->pcm, out);
+	if (!sh)
+		return;
+	snd_output_printf(out, "Mix Settings: \n");
+	snd_output_printf(out, "  Share:            %s %s, %u clients\n", mix->share_name,
+			  mix->owner ? "owner" : "client", __atomic_load_n(&sh->hdr.clients, __ATOMIC_RELAXED));
+	snd_output_printf(out, "  Rate:             %u to %u Hz, %s\n", sh->rate, sh->slave_rate,
+			  sh->rate != sh->slave_rate ? "asrc" : "copy");
+	snd_output_printf(out, "  block:            %u frames\n", sh->block);
+	snd_output_printf(out, "  ring:             %u frames\n", sh->capacity);
+	snd_output_printf(out, "  xruns:            %llu\n",
+			  (unsigned long long)__atomic_load_n(&sh->xruns, __ATOMIC_RELAXED));
+	if (mix->slave) {
+		snd_output_printf(out, "Slave: ");
+		snd_pcm_dump(mix->slave, out);
+	}
+}
+
+static const snd_pcm_ioplug_callback_t mix_funcs = {
+	.start = mix_start,
+	.stop = mix_stop,
+	.pointer = mix_pointer,
+	.transfer = mix_transfer,
+	.close = mix_close,
+	.hw_params = mix_hw,
+	.hw_free = mix_hw_free,
+	.sw_params = mix_sw,
+	.prepare = mix_prepare,
+	.drain = mix_drain,
+	.poll_descriptors_count = mix_poll_descriptors_count,
+	.poll_descriptors = mix_poll_descriptors,
+	.poll_revents = mix_poll_revents,
+	.dump = mix_dump,
+	.delay = mix_delay
+};
+
+static int constrains(snd_pcm_ioplug_t *io)
+{
+	snd_pcm_asrc_mix_t *mix = io->private_data;
+	int err;
+
+	static unsigned int accesses[] = {
+		SND_PCM_ACCESS_RW_INTERLEAVED,
+		SND_PCM_ACCESS_MMAP_INTERLEAVED
+	};
+
+	static unsigned int formats[] = {
+		SND_PCM_FORMAT_S16_LE
+	};
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_ACCESS, ARRAY_SIZE(accesses), accesses);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw access mode");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_FORMAT, ARRAY_SIZE(formats), formats);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw format");
+		return err;
+	}
+
+	/* the ring is interleaved, a plug in front maps the others */
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_CHANNELS, mix->channels, mix->channels);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw channels");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_RATE, ARRAY_SIZE(asrc_rates), asrc_rates);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw rates");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIOD_BYTES, MIN_PERIOD_BYTES, MAX_PERIOD_BYTES);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw period bytes");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_BUFFER_BYTES, 2 * MIN_PERIOD_BYTES, MAX_BUFFER_BYTES);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw buffer bytes");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIODS, 2, MAX_PERIODS);
+	if (err < 0) {
+		SNDERR("ioplug cannot set periods");
+		return err;
+	}
+
+	return err;
+}
+
+static int parse_string(snd_config_t *n, const char *id, char **str)
+{
+	const char *s;
+
+	if (snd_config_get_string(n, &s) < 0) {
+		SNDERR("'%s' must be a string", id);
+		return -EINVAL;
+	}
+	free(*str);
+	*str = strdup(s);
+	return *str ? 0 : -ENOMEM;
+}
+
+static int parse_struct(snd_config_t *conf, snd_pcm_asrc_mix_t *mix)
+{
+	snd_config_iterator_t i, next;
+	snd_config_t *n;
+	const char *id;
+	long val;
+	int err;
+
+	snd_config_for_each(i, next, conf) {
+		n = snd_config_iterator_entry(i);
+
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+
+		if ((strcmp(id, "comment") == 0) || (strcmp(id, "type") == 0) || (strcmp(id, "hint") == 0))
+			continue;
+
+		if (strcmp(id, "slave") == 0) {
+			err = parse_string(n, id, &mix->slave_name);
+			if (err < 0)
+				return err;
+			continue;
+		}
+
+		if (strcmp(id, "share") == 0) {
+			err = parse_string(n, id, &mix->share);
+			if (err < 0)
+				return err;
+			if (mix->share[0] == '\0' || strchr(mix->share, '/') != NULL) {
+				SNDERR("'share' must be a name without /");
+				return -EINVAL;
+			}
+			continue;
+		}
+
+		if (strcmp(id, "channels") == 0) {
+			if (snd_config_get_integer(n, &val) < 0 || val < MIN_PCM_CHANNELS || val > MAX_PCM_CHANNELS) {
+				SNDERR("'channels' must be in range of: [%d, %d].", MIN_PCM_CHANNELS, MAX_PCM_CHANNELS);
+				return -EINVAL;
+			}
+			mix->channels = (unsigned int)val;
+			continue;
+		}
+
+		if (strcmp(id, "slave_rate") == 0) {
+			if (snd_config_get_integer(n, &val) < 0 || val < 32000 || val > 192000) {
+				SNDERR("'slave_rate' must be in range of: [32000, 192000].");
+				return -EINVAL;
+			}
+			mix->slave_rate = (unsigned int)val;
+			continue;
+		}
+
+		SNDERR("Unknown field %s", id);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+SND_PCM_PLUGIN_DEFINE_FUNC(PLUG_NAME)
+{
+	snd_pcm_asrc_mix_t *mix;
+	int err;
+
+	if (stream != SND_PCM_STREAM_PLAYBACK) {
+		SNDERR("asrcMix is only for playback");
+		return -EINVAL;
+	}
+
+	mix = calloc(1, sizeof(*mix));
+	if (!mix) {
+		SNDERR("Cannot allocate");
+		return -ENOMEM;
+	}
+
+	mix->io.private_data = mix;
+
+	/* Set default values. */
+	mix->channels = 2;
+	mix->slave_rate = 48000;
+	mix->thread_exit = 1;
+	mix->timer = -1;
+
+	err = parse_struct(conf, mix);
+	if (err == 0 && (!mix->slave_name || !mix->share)) {
+		SNDERR("asrcMix needs a slave and a share");
+		err = -EINVAL;
+	}
+	if (err == 0) {
+		mix->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (mix->timer < 0)
+			err = -errno;
+	}
+	if (err < 0) {
+		mix_close(&mix->io);
+		return err;
+	}
+
+	mix->io.version = SND_PCM_IOPLUG_VERSION;
+	mix->io.name = "Mix then resample with the ASRC";
+	mix->io.mmap_rw = 0;
+	mix->io.callback = &mix_funcs;
+	mix->io.flags = SND_PCM_IOPLUG_FLAG_BOUNDARY_WA | SND_PCM_IOPLUG_FLAG_MONOTONIC;
+
+	err = snd_pcm_ioplug_create(&mix->io, name, stream, mode);
+	if (err < 0) {
+		mix_close(&mix->io);
+		return err;
+	}
+
+	err = constrains(&mix->io);
+	if (err < 0) {
+		snd_pcm_ioplug_delete(&mix->io);
+		return err;
+	}
+
+	*pcmp = mix->io.pcm;
+
+	return 0;
+}
+
+SND_PCM_PLUGIN_SYMBOL(PLUG_NAME);
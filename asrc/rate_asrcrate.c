@@ -18,17 +18,88 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <math.h>
 #include <alsa/asoundlib.h>
 #include <alsa/pcm_rate.h>
 
 #include "asrc_pair.h"
+#include "asrc_ctl.h"
+#include "pcm_kernels.h"
+
+#ifndef SND_PCM_RATE_PLUGIN_CONF_ENTRY
+#define SND_PCM_RATE_PLUGIN_CONF_ENTRY(name) _snd_pcm_rate_##name##_open_conf
+#endif
+
+static const char *const dither_names[] = { "none", "tpdf", "shaped" };
 
 struct rate_src {
 	int type;
+	int rt;
 	unsigned int channels;
     asrc_pair *pair;
+	/* output volume in 0.1 dB, ASRC_CTL_VOLUME_MIN mutes, and its ramp */
+	int32_t volume;
+	uint32_t ramp_us;
+	int dither;
+	/* live controls, see asrc_ctl.h */
+	char *ctl_name;
+	asrc_ctl *ctl;
+	uint32_t ctl_gen;
 };
 
+static int32_t volume_q14(int32_t volume)
+{
+	if (volume <= ASRC_CTL_VOLUME_MIN)
+		return 0;
+	return (int32_t)lrint(pow(10, volume / 200.0) * PCM_VOLUME_UNITY);
+}
+
+/* Sets the volume and dither of the pair, ramping from the current volume. */
+static void set_volume(struct rate_src *rate, unsigned int out_rate, int ramp)
+{
+	unsigned int frames = ramp ? (uint64_t)rate->ramp_us * out_rate / 1000000 : 0;
+
+	asrc_pair_set_volume(rate->pair, volume_q14(rate->volume), frames);
+	asrc_pair_set_dither(rate->pair, rate->dither);
+}
+
+/* Takes the values of a control once its gen moved, before the next period. */
+static void apply_controls(struct rate_src *rate)
+{
+	asrc_ctl *ctl = rate->ctl;
+	uint32_t gen = __atomic_load_n(&ctl->hdr.gen, __ATOMIC_ACQUIRE);
+
+	if (gen == rate->ctl_gen)
+		return;
+	rate->ctl_gen = gen;
+
+	rate->volume = ctl->volume < ASRC_CTL_VOLUME_MIN ? ASRC_CTL_VOLUME_MIN :
+		       ctl->volume > ASRC_CTL_VOLUME_MAX ? ASRC_CTL_VOLUME_MAX : ctl->volume;
+	if (ctl->ramp_us <= ASRC_CTL_RAMP_MAX)
+		rate->ramp_us = ctl->ramp_us;
+	if (ctl->dither <= ASRC_CTL_DITHER_MAX)
+		rate->dither = ctl->dither;
+	set_volume(rate, rate->pair->out_rate, 1);
+}
+
+/* Fill the control page with the configured values, the last ones of a previous open are lost. */
+static int open_controls(struct rate_src *rate)
+{
+	asrc_ctl *ctl;
+
+	ctl = asrc_ctl_open(rate->ctl_name, 1);
+	if (!ctl)
+		return -errno;
+	rate->ctl = ctl;
+
+	ctl->volume = rate->volume;
+	ctl->ramp_us = rate->ramp_us;
+	ctl->dither = rate->dither;
+	rate->ctl_gen = asrc_ctl_publish(ctl);
+
+	return 0;
+}
+
 static snd_pcm_uframes_t input_frames(void *obj, snd_pcm_uframes_t frames)
 {
    uint32_t num, den;
@@ -69,9 +140,10 @@ static int pcm_src_init(void *obj, snd_pcm_rate_info_t *info)
          asrc_pair_destroy(rate->pair);
       rate->channels = info->channels;
       rate->pair = asrc_pair_create(rate->channels, info->in.period_size * rate->channels,
-              info->out.period_size * rate->channels, info->in.rate, info->out.rate, rate->type);
+              info->out.period_size * rate->channels, info->in.rate, info->out.rate, rate->type, rate->rt);
       if (!rate->pair)
          return -EINVAL;
+      set_volume(rate, info->out.rate, 0);
    }
 
    return 0;
@@ -94,11 +166,16 @@ static void pcm_src_convert_s16(void *obj, int16_t *dst, unsigned int dst_frames
 				const int16_t *src, unsigned int src_frames)
 {
    struct rate_src *rate = obj;
+   if (rate->ctl)
+      apply_controls(rate);
    asrc_pair_convert_s16(rate->pair, src, src_frames * rate->channels, dst, dst_frames * rate->channels);
 }
 
 static void pcm_src_close(void *obj)
 {
+   struct rate_src *rate = obj;
+   asrc_ctl_close(rate->ctl);
+   free(rate->ctl_name);
    free(obj);
 }
 
@@ -113,7 +190,14 @@ static int get_supported_rates(void *obj, unsigned int *rate_min,
 
 static void dump(void *obj, snd_output_t *out)
 {
-	snd_output_printf(out, "Converter: asrc\n");
+	struct rate_src *rate = obj;
+
+	snd_output_printf(out, "Converter: asrc%s\n", rate->rt ? " (rt)" : "");
+	if (rate->volume != 0 || rate->dither != PCM_DITHER_NONE)
+		snd_output_printf(out, "  volume %.1f dB, %u us ramp, %s dither\n", rate->volume / 10.0,
+				  rate->ramp_us, dither_names[rate->dither]);
+	if (rate->ctl)
+		snd_output_printf(out, "  controls %s (gen %u)\n", rate->ctl_name, rate->ctl_gen);
 }
 #endif
 
@@ -134,7 +218,7 @@ static snd_pcm_rate_ops_t pcm_src_ops = {
 };
 
 static int pcm_src_open(unsigned int version, void **objp,
-			snd_pcm_rate_ops_t *ops, int type)
+			snd_pcm_rate_ops_t *ops, int type, int rt)
 {
 	struct rate_src *rate;
 
@@ -148,6 +232,8 @@ static int pcm_src_open(unsigned int version, void **objp,
 	if (!rate)
 		return -ENOMEM;
 	rate->type = type;
+	rate->rt = rt;
+	rate->ramp_us = 10000;
 
 	*objp = rate;
 #if SND_PCM_RATE_PLUGIN_VERSION >= 0x010002
@@ -159,8 +245,119 @@ static int pcm_src_open(unsigned int version, void **objp,
 	return 0;
 }
 
+/*
+ * Fields of the converter when given as a compound, after its name:
+ * volume in dB, volume_ramp in us, dither and control.
+ */
+static int parse_conf(struct rate_src *rate, const snd_config_t *conf)
+{
+	snd_config_iterator_t i, next;
+	snd_config_t *n;
+	const char *id, *str;
+	double volume;
+	long ramp;
+	unsigned int d;
+
+	snd_config_for_each(i, next, conf) {
+		n = snd_config_iterator_entry(i);
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+		if (strcmp(id, "name") == 0 || strcmp(id, "comment") == 0)
+			continue;
+
+		if (strcmp(id, "volume") == 0) {
+			if (snd_config_get_ireal(n, &volume) < 0) {
+				SNDERR("'volume' must be a number of dB");
+				return -EINVAL;
+			}
+			volume *= 10;
+			rate->volume = volume < ASRC_CTL_VOLUME_MIN ? ASRC_CTL_VOLUME_MIN :
+				       volume > ASRC_CTL_VOLUME_MAX ? ASRC_CTL_VOLUME_MAX : (int32_t)lrint(volume);
+			continue;
+		}
+		if (strcmp(id, "volume_ramp") == 0) {
+			if (snd_config_get_integer(n, &ramp) < 0 || ramp < 0 || ramp > ASRC_CTL_RAMP_MAX) {
+				SNDERR("'volume_ramp' must be from 0 to %d us", ASRC_CTL_RAMP_MAX);
+				return -EINVAL;
+			}
+			rate->ramp_us = ramp;
+			continue;
+		}
+		if (strcmp(id, "dither") == 0) {
+			if (snd_config_get_string(n, &str) < 0)
+				str = "";
+			for (d = 0; d < sizeof(dither_names) / sizeof(dither_names[0]); d++)
+				if (strcmp(str, dither_names[d]) == 0)
+					break;
+			if (d == sizeof(dither_names) / sizeof(dither_names[0])) {
+				SNDERR("'dither' must be none, tpdf or shaped");
+				return -EINVAL;
+			}
+			rate->dither = d;
+			continue;
+		}
+		if (strcmp(id, "control") == 0) {
+			if (snd_config_get_string(n, &str) < 0) {
+				SNDERR("'control' must be a string");
+				return -EINVAL;
+			}
+			free(rate->ctl_name);
+			rate->ctl_name = strdup(str);
+			if (!rate->ctl_name)
+				return -ENOMEM;
+			continue;
+		}
+
+		SNDERR("Unknown field %s", id);
+		return -EINVAL;
+	}
+
+	if (rate->ctl_name && open_controls(rate) < 0) {
+		SNDERR("Unable to create the controls %s", rate->ctl_name);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int pcm_src_open_conf(unsigned int version, void **objp, snd_pcm_rate_ops_t *ops,
+			     const snd_config_t *conf, int type, int rt)
+{
+	int err;
+
+	err = pcm_src_open(version, objp, ops, type, rt);
+	if (err < 0 || !conf)
+		return err;
+
+	err = parse_conf(*objp, conf);
+	if (err < 0) {
+		pcm_src_close(*objp);
+		*objp = NULL;
+	}
+	return err;
+}
+
 int SND_PCM_RATE_PLUGIN_ENTRY(asrcrate) (unsigned int version, void **objp,
 					   snd_pcm_rate_ops_t *ops)
 {
-	return pcm_src_open(version, objp, ops, 0);
+	return pcm_src_open(version, objp, ops, 0, 0);
+}
+
+int SND_PCM_RATE_PLUGIN_CONF_ENTRY(asrcrate) (unsigned int version, void **objp,
+					        snd_pcm_rate_ops_t *ops, const snd_config_t *conf)
+{
+	return pcm_src_open_conf(version, objp, ops, conf, 0, 0);
+}
+
+/* Same converter with its working memory locked, for real-time streams. */
+int SND_PCM_RATE_PLUGIN_ENTRY(asrcrate_rt) (unsigned int version, void **objp,
+					      snd_pcm_rate_ops_t *ops)
+{
+	return pcm_src_open(version, objp, ops, 0, 1);
+}
+
+int SND_PCM_RATE_PLUGIN_CONF_ENTRY(asrcrate_rt) (unsigned int version, void **objp,
+						   snd_pcm_rate_ops_t *ops, const snd_config_t *conf)
+{
+	return pcm_src_open_conf(version, objp, ops, conf, 0, 1);
 }
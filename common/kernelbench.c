@@ -0,0 +1,232 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Micro-benchmark of the pcm kernels.
+ *
+ * Every kernel runs in the layouts the plugins use, once per variant the
+ * cpu supports. The output of each variant is checked against the generic
+ * one bit for bit, then timed, and its speedup over the generic one shown.
+ * The volume ramps are checked to reach their target first.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "pcm_kernels.h"
+
+enum { LERP_S16, GATHER_S32, S16_TO_S32, GAIN_S32, VOLUME_S16 };
+
+struct bench_case {
+	int kernel;
+	const char *name;
+	/* channels of lerp_s16, channels and dither of volume_s16, steps of the others */
+	unsigned int dst_step;
+	unsigned int src_step;
+};
+
+static const struct bench_case cases[] = {
+	{ LERP_S16, "lerp_s16 mono", 1, 1 },
+	{ LERP_S16, "lerp_s16 stereo", 2, 2 },
+	{ LERP_S16, "lerp_s16 8ch", 8, 8 },
+	{ GATHER_S32, "gather_s32 copy", 1, 1 },
+	{ GATHER_S32, "gather_s32 split", 1, 4 },
+	{ GATHER_S32, "gather_s32 merge", 8, 4 },
+	{ S16_TO_S32, "s16_to_s32 copy", 1, 1 },
+	{ S16_TO_S32, "s16_to_s32 split", 1, 2 },
+	{ S16_TO_S32, "s16_to_s32 stereo", 2, 2 },
+	{ GAIN_S32, "gain_s32 copy", 1, 1 },
+	{ GAIN_S32, "gain_s32 split", 1, 4 },
+	{ GAIN_S32, "gain_s32 merge", 8, 4 },
+	{ VOLUME_S16, "volume_s16 stereo", 2, PCM_DITHER_NONE },
+	{ VOLUME_S16, "volume_s16 tpdf", 2, PCM_DITHER_TPDF },
+	{ VOLUME_S16, "volume_s16 shaped", 2, PCM_DITHER_SHAPED },
+};
+
+static const char *const variants[] = { "generic", "neon", "avx2" };
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* The step of the padding of asrc_pair, 20 frames stretched to 21. */
+static uint32_t lerp_step(unsigned int n)
+{
+	unsigned int src = n / 21 * 20;
+
+	return (uint32_t)(((uint64_t)(src - 1) << PCM_LERP_BITS) / (n - 1));
+}
+
+static void run(const pcm_kernels *k, const struct bench_case *bc, void *dst,
+		const void *src, unsigned int n)
+{
+	switch (bc->kernel) {
+	case LERP_S16:
+		k->lerp_s16(dst, src, bc->dst_step, n, lerp_step(n));
+		break;
+	case GATHER_S32:
+		k->gather_s32(dst, bc->dst_step, src, bc->src_step, n);
+		break;
+	case S16_TO_S32:
+		k->s16_to_s32(dst, bc->dst_step, src, bc->src_step, n);
+		break;
+	case GAIN_S32:
+		/* +18 dB, full scale samples saturate */
+		k->gain_s32(dst, bc->dst_step, src, bc->src_step, n, 8 << PCM_GAIN_SHIFT);
+		break;
+	case VOLUME_S16:
+		/* +9.5 dB, loud samples saturate */
+		k->volume_s16(dst, src, bc->dst_step, n / bc->dst_step, 3 * PCM_VOLUME_UNITY, 0, 1, bc->src_step);
+		break;
+	}
+}
+
+struct ramp_case {
+	int32_t from;
+	int32_t to;
+	unsigned int frames;
+};
+
+/* 0 dB to -6 dB over 1 s at 48 kHz moves less than a Q14 step per frame. */
+static const struct ramp_case ramps[] = {
+	{ PCM_VOLUME_UNITY, 8211, 48000 },
+	{ PCM_VOLUME_UNITY, 0, 480 },
+	{ 0, PCM_VOLUME_UNITY, 441000 },
+	{ 2 * PCM_VOLUME_UNITY - 1, 1, 7 },
+	{ 100, 101, 1000 },
+};
+
+/*
+ * A full scale ramp of the volume itself, src at unity gives the volume in
+ * dst: it must stay between its ends and end within a step of its target.
+ */
+static int check_ramp(const struct ramp_case *rc)
+{
+	int16_t *src, *dst;
+	int32_t lo, hi, last;
+	int64_t step;
+	unsigned int i;
+	int ok = 1;
+
+	src = malloc(rc->frames * sizeof(int16_t));
+	dst = malloc(rc->frames * sizeof(int16_t));
+	if (!src || !dst) {
+		free(src);
+		free(dst);
+		return 0;
+	}
+
+	for (i = 0; i < rc->frames; i++)
+		src[i] = PCM_VOLUME_UNITY;
+	step = pcm_volume_step((int64_t)rc->from << PCM_VOLUME_RAMP_BITS, rc->to, rc->frames);
+	pcm_kernels_generic.volume_s16(dst, src, 1, rc->frames, rc->from, step, 0, PCM_DITHER_NONE);
+
+	lo = rc->from < rc->to ? rc->from : rc->to;
+	hi = rc->from < rc->to ? rc->to : rc->from;
+	for (i = 0; i < rc->frames; i++)
+		if (dst[i] < lo || dst[i] > hi)
+			ok = 0;
+	last = dst[rc->frames - 1];
+	if (dst[0] != rc->from || abs(rc->to - last) > (llabs(step) >> PCM_VOLUME_RAMP_BITS) + 1)
+		ok = 0;
+
+	printf("%-20s %5d to %5d in %6u frames, ends at %5d: %s\n", "volume ramp", rc->from, rc->to,
+	       rc->frames, last, ok ? "ok" : "FAIL");
+
+	free(src);
+	free(dst);
+	return ok;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-n samples] [-i iterations]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int n = 4096, iterations = 10000;
+	const struct bench_case *bc;
+	const pcm_kernels *k;
+	size_t size;
+	void *src, *ref, *dst;
+	double t0, ns, generic_ns;
+	unsigned int c, v, i;
+	int opt, failed = 0;
+
+	while ((opt = getopt(argc, argv, "n:i:h")) != -1) {
+		switch (opt) {
+		case 'n': n = atoi(optarg); break;
+		case 'i': iterations = atoi(optarg); break;
+		default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (n < 42 || iterations == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* samples and frames of up to 8 channels of 32 bits */
+	size = (size_t)n * 8 * sizeof(int32_t);
+	src = malloc(size);
+	ref = malloc(size);
+	dst = malloc(size);
+	if (!src || !ref || !dst)
+		return 1;
+	srand(1);
+	for (i = 0; i < size; i++)
+		((uint8_t *)src)[i] = rand();
+
+	for (c = 0; c < sizeof(ramps) / sizeof(ramps[0]); c++)
+		if (!check_ramp(&ramps[c]))
+			failed = 1;
+
+	printf("default kernels: %s\n", pcm_kernels_get()->name);
+	printf("%-20s %-8s %12s %8s\n", "kernel", "variant", "ns/sample", "speedup");
+
+	for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		bc = &cases[c];
+		memset(ref, 0, size);
+		run(&pcm_kernels_generic, bc, ref, src, n);
+		generic_ns = 0;
+
+		for (v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+			k = pcm_kernels_find(variants[v]);
+			if (k == NULL)
+				continue;
+
+			memset(dst, 0, size);
+			run(k, bc, dst, src, n);
+			if (memcmp(dst, ref, size) != 0) {
+				printf("%-20s %-8s FAIL: differs from generic\n", bc->name, k->name);
+				failed = 1;
+				continue;
+			}
+
+			t0 = now_ns();
+			for (i = 0; i < iterations; i++)
+				run(k, bc, dst, src, n);
+			ns = (now_ns() - t0) / iterations / n;
+			if (bc->kernel == LERP_S16)
+				ns /= bc->dst_step;
+			if (k == &pcm_kernels_generic)
+				generic_ns = ns;
+			printf("%-20s %-8s %12.3f %8.2f\n", bc->name, k->name, ns, generic_ns / ns);
+		}
+	}
+
+	free(src);
+	free(ref);
+	free(dst);
+
+	return failed;
+}
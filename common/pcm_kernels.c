@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Generic C kernels and the choice of the variant for the cpu. The SIMD
+ * variants are built with their own flags in pcm_kernels_neon.c and
+ * pcm_kernels_avx2.c, the rest of the plugins keeps the target baseline
+ * so one binary runs on every cpu of the family.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__arm__) && !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_ARM_NEON
+#define HWCAP_ARM_NEON		(1 << 12)
+#endif
+#endif
+
+#include "pcm_kernels.h"
+
+static const pcm_kernels *kernels;
+
+static void lerp_s16(int16_t *dst, const int16_t *src, unsigned int channels,
+		     unsigned int frames, uint32_t step)
+{
+	const int32_t one = 1 << PCM_LERP_BITS;
+	const int16_t *s;
+	uint64_t pos;
+	int32_t frac;
+	unsigned int i, c;
+
+	for (i = 0; i < frames; i++, dst += channels) {
+		pos = (uint64_t)i * step;
+		s = src + (pos >> PCM_LERP_BITS) * channels;
+		frac = (int32_t)(pos & (one - 1));
+		for (c = 0; c < channels; c++)
+			dst[c] = ((one - frac) * s[c] + frac * s[c + channels]) >> PCM_LERP_BITS;
+	}
+}
+
+static void gather_s32(int32_t *dst, unsigned int dst_step,
+		       const int32_t *src, unsigned int src_step, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		dst[i * dst_step] = src[i * src_step];
+}
+
+static void s16_to_s32(int32_t *dst, unsigned int dst_step,
+		       const int16_t *src, unsigned int src_step, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		dst[i * dst_step] = (int32_t)((uint32_t)src[i * src_step] << 16);
+}
+
+static void gain_s32(int32_t *dst, unsigned int dst_step,
+		     const int32_t *src, unsigned int src_step, unsigned int n, int32_t gain)
+{
+	unsigned int i;
+	int64_t v;
+
+	for (i = 0; i < n; i++) {
+		v = ((int64_t)src[i * src_step] * gain) >> PCM_GAIN_SHIFT;
+		if (v > INT32_MAX)
+			v = INT32_MAX;
+		else if (v < INT32_MIN)
+			v = INT32_MIN;
+		dst[i * dst_step] = (int32_t)v;
+	}
+}
+
+static void volume_s16(int16_t *dst, const int16_t *src, unsigned int channels,
+		       unsigned int frames, int32_t volume, int64_t step, uint32_t pos, int dither)
+{
+	int64_t v = (int64_t)volume << PCM_VOLUME_RAMP_BITS;
+	unsigned int i, c;
+
+	for (i = 0; i < frames; i++, v += step, src += channels, dst += channels)
+		for (c = 0; c < channels; c++, pos++)
+			dst[c] = pcm_volume_sample(src[c], (int32_t)(v >> PCM_VOLUME_RAMP_BITS), pos, channels, dither);
+}
+
+const pcm_kernels pcm_kernels_generic = {
+	.name = "generic",
+	.lerp_s16 = lerp_s16,
+	.gather_s32 = gather_s32,
+	.s16_to_s32 = s16_to_s32,
+	.gain_s32 = gain_s32,
+	.volume_s16 = volume_s16,
+};
+
+static int cpu_has_neon(void)
+{
+#if defined(__aarch64__)
+	return 1; /* ASIMD is part of ARMv8-A */
+#elif defined(__arm__)
+	return (getauxval(AT_HWCAP) & HWCAP_ARM_NEON) != 0;
+#else
+	return 0;
+#endif
+}
+
+static int cpu_has_avx2(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	return 0;
+#endif
+}
+
+const pcm_kernels *pcm_kernels_find(const char *name)
+{
+	if (strcmp(name, "generic") == 0)
+		return &pcm_kernels_generic;
+	if (strcmp(name, "neon") == 0 && cpu_has_neon())
+		return pcm_kernels_neon();
+	if (strcmp(name, "avx2") == 0 && cpu_has_avx2())
+		return pcm_kernels_avx2();
+
+	return NULL;
+}
+
+/* Runs when the plugin is loaded, before any stream is opened. */
+static void __attribute__((constructor)) pcm_kernels_init(void)
+{
+	const char *name = getenv("PCM_KERNELS");
+	const pcm_kernels *k = NULL;
+
+	if (name != NULL)
+		k = pcm_kernels_find(name);
+	if (k == NULL)
+		k = pcm_kernels_find("neon");
+	if (k == NULL)
+		k = pcm_kernels_find("avx2");
+	if (k == NULL)
+		k = &pcm_kernels_generic;
+
+	kernels = k;
+}
+
+const pcm_kernels *pcm_kernels_get(void)
+{
+	if (kernels == NULL)
+		pcm_kernels_init();
+
+	return kernels;
+}
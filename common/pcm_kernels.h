@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file pcm_kernels.h
+   @brief sample loops shared by the plugins, picked for the cpu at load
+*/
+
+#ifndef PCM_KERNELS_H
+#define PCM_KERNELS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCM_LERP_BITS           16 /* Q16 interpolation positions */
+#define PCM_GAIN_SHIFT          20 /* Q20 gains, 1 << 20 is unity */
+#define PCM_VOLUME_SHIFT        14 /* Q14 volumes of s16 samples */
+#define PCM_VOLUME_UNITY        (1 << PCM_VOLUME_SHIFT)
+#define PCM_VOLUME_MAX          (4 * PCM_VOLUME_UNITY - 1) /* +12 dB, the product stays in 32 bits */
+#define PCM_VOLUME_RAMP_BITS    32 /* fraction bits of a ramp below the Q14 of the volume */
+
+enum {
+	PCM_DITHER_NONE,
+	PCM_DITHER_TPDF,        /* triangular, white */
+	PCM_DITHER_SHAPED,      /* triangular, first order high pass */
+};
+
+#define PCM_DITHER_KEY          0x9e3779b9u /* second noise of the white one */
+
+/*
+ * The dither is a hash of the index of the sample rather than the output
+ * of a generator, so that the vector loops compute it lane by lane and
+ * every variant adds the same noise.
+ */
+static inline uint32_t pcm_dither_hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+/* Uniform noise of one output LSB in the fraction bits of the volume. */
+static inline int32_t pcm_dither_rpdf(uint32_t x)
+{
+	return (int32_t)(pcm_dither_hash(x) >> (32 - PCM_VOLUME_SHIFT)) - (1 << (PCM_VOLUME_SHIFT - 1));
+}
+
+/*
+ * Dither of sample pos: the sum of two uniform noises, or the difference
+ * of the ones of this sample and of the same channel a frame before.
+ */
+static inline int32_t pcm_dither(uint32_t pos, unsigned int channels, int dither)
+{
+	switch (dither) {
+	case PCM_DITHER_TPDF:
+		return pcm_dither_rpdf(pos) + pcm_dither_rpdf(pos + PCM_DITHER_KEY);
+	case PCM_DITHER_SHAPED:
+		return pcm_dither_rpdf(pos) - pcm_dither_rpdf(pos - channels);
+	default:
+		return 0;
+	}
+}
+
+/* One sample of volume_s16(), for the loops and the tails of the variants. */
+static inline int16_t pcm_volume_sample(int16_t s, int32_t volume, uint32_t pos,
+					unsigned int channels, int dither)
+{
+	int32_t v = s * volume + (1 << (PCM_VOLUME_SHIFT - 1)) + pcm_dither(pos, channels, dither);
+
+	v >>= PCM_VOLUME_SHIFT;
+	return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+/*
+ * Step per frame of a ramp from the volume from, with PCM_VOLUME_RAMP_BITS
+ * more fraction bits, to the Q14 volume to in frames: a ramp much longer
+ * than its volume change still moves every frame or so.
+ */
+static inline int64_t pcm_volume_step(int64_t from, int32_t to, unsigned int frames)
+{
+	return (((int64_t)to << PCM_VOLUME_RAMP_BITS) - from) / (int64_t)frames;
+}
+
+/*
+ * Every kernel walks n samples of one channel, steps are in samples so the
+ * same call reads or writes interleaved and planar buffers. The variants
+ * give the same results bit for bit, the SIMD ones take their vector path
+ * for the unit and small source steps and fall back to the generic loop
+ * otherwise.
+ */
+typedef struct {
+	const char *name;
+	/*
+	 * frames interleaved frames of channels interpolated through src,
+	 * frame i at position p + frac = i * step in Q16 is
+	 * (1 - frac) * src[p] + frac * src[p + 1] per channel. step is below
+	 * 1 << PCM_LERP_BITS, src holds every frame reached.
+	 */
+	void (*lerp_s16)(int16_t *dst, const int16_t *src, unsigned int channels,
+			 unsigned int frames, uint32_t step);
+	/* dst[i * dst_step] = src[i * src_step] */
+	void (*gather_s32)(int32_t *dst, unsigned int dst_step,
+			   const int32_t *src, unsigned int src_step, unsigned int n);
+	/* dst[i * dst_step] = src[i * src_step] << 16 */
+	void (*s16_to_s32)(int32_t *dst, unsigned int dst_step,
+			   const int16_t *src, unsigned int src_step, unsigned int n);
+	/* dst[i * dst_step] = src[i * src_step] * gain >> 20, saturated */
+	void (*gain_s32)(int32_t *dst, unsigned int dst_step,
+			 const int32_t *src, unsigned int src_step, unsigned int n, int32_t gain);
+	/*
+	 * frames interleaved frames of channels scaled by volume, plus step
+	 * per frame with PCM_VOLUME_RAMP_BITS more fraction bits, dithered and
+	 * rounded: sample i of the call is dithered as sample pos + i of the
+	 * stream. dst may be src. The volume stays in 0..PCM_VOLUME_MAX, a
+	 * ramp (step not 0) takes the generic loop.
+	 */
+	void (*volume_s16)(int16_t *dst, const int16_t *src, unsigned int channels,
+			   unsigned int frames, int32_t volume, int64_t step, uint32_t pos, int dither);
+} pcm_kernels;
+
+/*
+ * The kernels of the cpu, chosen when the plugin is loaded: NEON when the
+ * cpu has it, AVX2 on x86, the generic C ones otherwise. PCM_KERNELS in
+ * the environment forces one by name.
+ */
+const pcm_kernels *pcm_kernels_get(void);
+
+/* The kernels of name if built in and supported by the cpu, NULL otherwise. */
+const pcm_kernels *pcm_kernels_find(const char *name);
+
+/* Variants, NULL when not built for this target. */
+const pcm_kernels *pcm_kernels_neon(void);
+const pcm_kernels *pcm_kernels_avx2(void);
+extern const pcm_kernels pcm_kernels_generic;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * AVX2 kernels, built with -mavx2 and only called when the cpu has it.
+ * Eight samples per iteration, strided sources are gathered.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pcm_kernels.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+static void lerp_s16(int16_t *dst, const int16_t *src, unsigned int channels,
+		     unsigned int frames, uint32_t step)
+{
+	const int32_t one = 1 << PCM_LERP_BITS;
+	const __m256i lanes = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+						 _mm256_set1_epi32((int32_t)step));
+	const __m256i mask = _mm256_set1_epi32(one - 1);
+	const __m256i vone = _mm256_set1_epi32(one);
+	__m256i f, p, frac, base, a, b, r[2];
+	const int16_t *s;
+	uint64_t pos;
+	unsigned int i, c;
+
+	/* the stores of more channels are scattered, no faster than the C loop */
+	if (channels > 2) {
+		pcm_kernels_generic.lerp_s16(dst, src, channels, frames, step);
+		return;
+	}
+
+	for (i = 0; i + 8 <= frames; i += 8) {
+		pos = (uint64_t)i * step;
+		f = _mm256_add_epi32(_mm256_set1_epi32((int32_t)(pos & (one - 1))), lanes);
+		p = _mm256_add_epi32(_mm256_set1_epi32((int32_t)(pos >> PCM_LERP_BITS)),
+				     _mm256_srli_epi32(f, PCM_LERP_BITS));
+		frac = _mm256_and_si256(f, mask);
+		base = _mm256_mullo_epi32(p, _mm256_set1_epi32(channels));
+
+		for (c = 0; c < channels; c++) {
+			/* 32 bit gathers of two samples, src[p] in the low half, src[p + 1] in the high one */
+			a = _mm256_i32gather_epi32((const int *)(src + c), base, 2);
+			a = _mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16);
+			b = _mm256_i32gather_epi32((const int *)(src + c + channels - 1), base, 2);
+			b = _mm256_srai_epi32(b, 16);
+			a = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(vone, frac), a),
+					     _mm256_mullo_epi32(frac, b));
+			a = _mm256_srai_epi32(a, PCM_LERP_BITS);
+
+			if (channels == 2) {
+				r[c] = a;
+				continue;
+			}
+			a = _mm256_packs_epi32(a, a);
+			a = _mm256_permute4x64_epi64(a, 0x08);
+			_mm_storeu_si128((__m128i *)(dst + i), _mm256_castsi256_si128(a));
+		}
+
+		if (channels == 2) {
+			a = _mm256_packs_epi32(_mm256_unpacklo_epi32(r[0], r[1]),
+					       _mm256_unpackhi_epi32(r[0], r[1]));
+			_mm256_storeu_si256((__m256i *)(dst + i * 2), a);
+		}
+	}
+
+	for (; i < frames; i++) {
+		pos = (uint64_t)i * step;
+		s = src + (pos >> PCM_LERP_BITS) * channels;
+		for (c = 0; c < channels; c++)
+			dst[i * channels + c] = ((one - (int32_t)(pos & (one - 1))) * s[c] +
+						 (int32_t)(pos & (one - 1)) * s[c + channels]) >> PCM_LERP_BITS;
+	}
+}
+
+/*
+ * Indexes of eight samples src_step apart. A gather never reads past the
+ * last sample: the vector loops leave it to the scalar tail when a 32 bit
+ * read of a 16 bit sample could.
+ */
+static inline __m256i steps(unsigned int src_step)
+{
+	return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+				  _mm256_set1_epi32(src_step));
+}
+
+static void gather_s32(int32_t *dst, unsigned int dst_step,
+		       const int32_t *src, unsigned int src_step, unsigned int n)
+{
+	const __m256i idx = steps(src_step);
+	unsigned int i = 0;
+	__m256i v;
+
+	if (dst_step == 1) {
+		for (; i + 8 <= n; i += 8) {
+			if (src_step == 1)
+				v = _mm256_loadu_si256((const __m256i *)(src + i));
+			else
+				v = _mm256_i32gather_epi32((const int *)(src + i * src_step), idx, 4);
+			_mm256_storeu_si256((__m256i *)(dst + i), v);
+		}
+	}
+
+	pcm_kernels_generic.gather_s32(dst + i * dst_step, dst_step, src + i * src_step, src_step, n - i);
+}
+
+static void s16_to_s32(int32_t *dst, unsigned int dst_step,
+		       const int16_t *src, unsigned int src_step, unsigned int n)
+{
+	const __m256i idx = steps(src_step);
+	unsigned int i = 0;
+	__m256i v;
+
+	if (dst_step == 1 && src_step == 1) {
+		for (; i + 8 <= n; i += 8) {
+			v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+			_mm256_storeu_si256((__m256i *)(dst + i), _mm256_slli_epi32(v, 16));
+		}
+	} else if (dst_step == 1) {
+		for (; i + 8 < n; i += 8) {
+			v = _mm256_i32gather_epi32((const int *)(src + i * src_step), idx, 2);
+			_mm256_storeu_si256((__m256i *)(dst + i), _mm256_slli_epi32(v, 16));
+		}
+	}
+
+	pcm_kernels_generic.s16_to_s32(dst + i * dst_step, dst_step, src + i * src_step, src_step, n - i);
+}
+
+/* 64 bit products saturated to the range of a 32 bit result after the shift. */
+static inline __m256i gain_lanes(__m256i x, __m256i gain)
+{
+	const __m256i hi = _mm256_set1_epi64x(((int64_t)INT32_MAX << PCM_GAIN_SHIFT) |
+					      ((1 << PCM_GAIN_SHIFT) - 1));
+	const __m256i lo = _mm256_set1_epi64x((int64_t)INT32_MIN * (1 << PCM_GAIN_SHIFT));
+	__m256i even, odd;
+
+	even = _mm256_mul_epi32(x, gain);
+	odd = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), gain);
+	even = _mm256_blendv_epi8(even, hi, _mm256_cmpgt_epi64(even, hi));
+	even = _mm256_blendv_epi8(even, lo, _mm256_cmpgt_epi64(lo, even));
+	odd = _mm256_blendv_epi8(odd, hi, _mm256_cmpgt_epi64(odd, hi));
+	odd = _mm256_blendv_epi8(odd, lo, _mm256_cmpgt_epi64(lo, odd));
+
+	/* the low 32 bits of a logical and an arithmetic shift are the same */
+	return _mm256_blend_epi32(_mm256_srli_epi64(even, PCM_GAIN_SHIFT),
+				  _mm256_slli_epi64(_mm256_srli_epi64(odd, PCM_GAIN_SHIFT), 32), 0xaa);
+}
+
+static void gain_s32(int32_t *dst, unsigned int dst_step,
+		     const int32_t *src, unsigned int src_step, unsigned int n, int32_t gain)
+{
+	const __m256i idx = steps(src_step);
+	const __m256i g = _mm256_set1_epi32(gain);
+	unsigned int i = 0;
+	__m256i v;
+
+	if (dst_step == 1) {
+		for (; i + 8 <= n; i += 8) {
+			if (src_step == 1)
+				v = _mm256_loadu_si256((const __m256i *)(src + i));
+			else
+				v = _mm256_i32gather_epi32((const int *)(src + i * src_step), idx, 4);
+			_mm256_storeu_si256((__m256i *)(dst + i), gain_lanes(v, g));
+		}
+	}
+
+	pcm_kernels_generic.gain_s32(dst + i * dst_step, dst_step, src + i * src_step, src_step, n - i, gain);
+}
+
+/* The hash of pcm_dither_hash() on eight sample indexes. */
+static inline __m256i dither_hash(__m256i x)
+{
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int32_t)0x846ca68bu));
+	return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+}
+
+static inline __m256i dither_rpdf(__m256i x)
+{
+	return _mm256_sub_epi32(_mm256_srli_epi32(dither_hash(x), 32 - PCM_VOLUME_SHIFT),
+				_mm256_set1_epi32(1 << (PCM_VOLUME_SHIFT - 1)));
+}
+
+static void volume_s16(int16_t *dst, const int16_t *src, unsigned int channels,
+		       unsigned int frames, int32_t volume, int64_t step, uint32_t pos, int dither)
+{
+	const __m256i v = _mm256_set1_epi32(volume);
+	const __m256i round = _mm256_set1_epi32(1 << (PCM_VOLUME_SHIFT - 1));
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i key = _mm256_set1_epi32((int32_t)PCM_DITHER_KEY);
+	const __m256i back = _mm256_set1_epi32(channels);
+	unsigned int n = frames * channels, i = 0;
+	__m256i x, p;
+
+	if (step != 0) {
+		pcm_kernels_generic.volume_s16(dst, src, channels, frames, volume, step, pos, dither);
+		return;
+	}
+
+	for (; i + 8 <= n; i += 8) {
+		x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+		x = _mm256_add_epi32(_mm256_mullo_epi32(x, v), round);
+		p = _mm256_add_epi32(_mm256_set1_epi32((int32_t)(pos + i)), lanes);
+		if (dither == PCM_DITHER_TPDF)
+			x = _mm256_add_epi32(x, _mm256_add_epi32(dither_rpdf(p),
+								 dither_rpdf(_mm256_add_epi32(p, key))));
+		else if (dither == PCM_DITHER_SHAPED)
+			x = _mm256_add_epi32(x, _mm256_sub_epi32(dither_rpdf(p),
+								 dither_rpdf(_mm256_sub_epi32(p, back))));
+		x = _mm256_srai_epi32(x, PCM_VOLUME_SHIFT);
+		x = _mm256_permute4x64_epi64(_mm256_packs_epi32(x, x), 0x08);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm256_castsi256_si128(x));
+	}
+
+	for (; i < n; i++)
+		dst[i] = pcm_volume_sample(src[i], volume, pos + i, channels, dither);
+}
+
+static const pcm_kernels kernels = {
+	.name = "avx2",
+	.lerp_s16 = lerp_s16,
+	.gather_s32 = gather_s32,
+	.s16_to_s32 = s16_to_s32,
+	.gain_s32 = gain_s32,
+	.volume_s16 = volume_s16,
+};
+
+const pcm_kernels *pcm_kernels_avx2(void)
+{
+	return &kernels;
+}
+
+#else
+
+const pcm_kernels *pcm_kernels_avx2(void)
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * NEON kernels, native on ARMv8 and built with -mfpu=neon on ARMv7 where
+ * they are only called when the cpu has NEON. Four samples per iteration,
+ * sources two or four samples apart are deinterleaved by the loads.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pcm_kernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+static void lerp_s16(int16_t *dst, const int16_t *src, unsigned int channels,
+		     unsigned int frames, uint32_t step)
+{
+	const int32_t one = 1 << PCM_LERP_BITS;
+	static const uint32_t index[4] = { 0, 1, 2, 3 };
+	const uint32x4_t lanes = vmulq_n_u32(vld1q_u32(index), step);
+	const uint32x4_t mask = vdupq_n_u32(one - 1);
+	const int32x4_t vone = vdupq_n_s32(one);
+	int32x4_t frac, a;
+	int16x4x2_t r;
+	int16x4_t h;
+	uint32x4_t f, p;
+	uint32_t base[4];
+	int32_t sa[4], sb[4];
+	const int16_t *s;
+	uint64_t pos;
+	unsigned int i, c, k;
+
+	/* the stores of more channels are scattered, no faster than the C loop */
+	if (channels > 2) {
+		pcm_kernels_generic.lerp_s16(dst, src, channels, frames, step);
+		return;
+	}
+
+	for (i = 0; i + 4 <= frames; i += 4) {
+		pos = (uint64_t)i * step;
+		f = vaddq_u32(vdupq_n_u32((uint32_t)(pos & (one - 1))), lanes);
+		p = vaddq_u32(vdupq_n_u32((uint32_t)(pos >> PCM_LERP_BITS)),
+			      vshrq_n_u32(f, PCM_LERP_BITS));
+		frac = vreinterpretq_s32_u32(vandq_u32(f, mask));
+		vst1q_u32(base, vmulq_n_u32(p, channels));
+
+		for (c = 0; c < channels; c++) {
+			for (k = 0; k < 4; k++) {
+				sa[k] = src[base[k] + c];
+				sb[k] = src[base[k] + c + channels];
+			}
+			a = vmulq_s32(vsubq_s32(vone, frac), vld1q_s32(sa));
+			a = vmlaq_s32(a, frac, vld1q_s32(sb));
+			h = vmovn_s32(vshrq_n_s32(a, PCM_LERP_BITS));
+
+			if (channels == 2)
+				r.val[c] = h;
+			else
+				vst1_s16(dst + i, h);
+		}
+
+		if (channels == 2)
+			vst2_s16(dst + i * 2, r);
+	}
+
+	for (; i < frames; i++) {
+		pos = (uint64_t)i * step;
+		s = src + (pos >> PCM_LERP_BITS) * channels;
+		for (c = 0; c < channels; c++)
+			dst[i * channels + c] = ((one - (int32_t)(pos & (one - 1))) * s[c] +
+						 (int32_t)(pos & (one - 1)) * s[c + channels]) >> PCM_LERP_BITS;
+	}
+}
+
+/*
+ * The structure loads of two or four samples read a whole last frame, the
+ * vector loops stop while one more sample follows so they stay in src.
+ */
+static void gather_s32(int32_t *dst, unsigned int dst_step,
+		       const int32_t *src, unsigned int src_step, unsigned int n)
+{
+	unsigned int i = 0;
+
+	if (dst_step == 1 && src_step == 1) {
+		for (; i + 4 <= n; i += 4)
+			vst1q_s32(dst + i, vld1q_s32(src + i));
+	} else if (dst_step == 1 && src_step == 2) {
+		for (; i + 4 < n; i += 4)
+			vst1q_s32(dst + i, vld2q_s32(src + i * 2).val[0]);
+	} else if (dst_step == 1 && src_step == 4) {
+		for (; i + 4 < n; i += 4)
+			vst1q_s32(dst + i, vld4q_s32(src + i * 4).val[0]);
+	}
+
+	pcm_kernels_generic.gather_s32(dst + i * dst_step, dst_step, src + i * src_step, src_step, n - i);
+}
+
+static void s16_to_s32(int32_t *dst, unsigned int dst_step,
+		       const int16_t *src, unsigned int src_step, unsigned int n)
+{
+	unsigned int i = 0;
+
+	if (dst_step == 1 && src_step == 1) {
+		for (; i + 4 <= n; i += 4)
+			vst1q_s32(dst + i, vshll_n_s16(vld1_s16(src + i), 16));
+	} else if (dst_step == 1 && src_step == 2) {
+		for (; i + 4 < n; i += 4)
+			vst1q_s32(dst + i, vshll_n_s16(vld2_s16(src + i * 2).val[0], 16));
+	} else if (dst_step == 1 && src_step == 4) {
+		for (; i + 4 < n; i += 4)
+			vst1q_s32(dst + i, vshll_n_s16(vld4_s16(src + i * 4).val[0], 16));
+	}
+
+	pcm_kernels_generic.s16_to_s32(dst + i * dst_step, dst_step, src + i * src_step, src_step, n - i);
+}
+
+/* Saturating narrow of the 64 bit products, the shift rounds down like the C one. */
+static inline int32x4_t gain_lanes(int32x4_t x, int32x2_t gain)
+{
+	return vcombine_s32(vqshrn_n_s64(vmull_s32(vget_low_s32(x), gain), PCM_GAIN_SHIFT),
+			    vqshrn_n_s64(vmull_s32(vget_high_s32(x), gain), PCM_GAIN_SHIFT));
+}
+
+static void gain_s32(int32_t *dst, unsigned int dst_step,
+		     const int32_t *src, unsigned int src_step, unsigned int n, int32_t gain)
+{
+	const int32x2_t g = vdup_n_s32(gain);
+	unsigned int i = 0;
+
+	if (dst_step == 1 && src_step == 1) {
+		for (; i + 4 <= n; i += 4)
+			vst1q_s32(dst + i, gain_lanes(vld1q_s32(src + i), g));
+	} else if (dst_step == 1 && src_step == 2) {
+		for (; i + 4 < n; i += 4)
+			vst1q_s32(dst + i, gain_lanes(vld2q_s32(src + i * 2).val[0], g));
+	} else if (dst_step == 1 && src_step == 4) {
+		for (; i + 4 < n; i += 4)
+			vst1q_s32(dst + i, gain_lanes(vld4q_s32(src + i * 4).val[0], g));
+	}
+
+	pcm_kernels_generic.gain_s32(dst + i * dst_step, dst_step, src + i * src_step, src_step, n - i, gain);
+}
+
+/* The hash of pcm_dither_hash() on four sample indexes. */
+static inline uint32x4_t dither_hash(uint32x4_t x)
+{
+	x = veorq_u32(x, vshrq_n_u32(x, 16));
+	x = vmulq_n_u32(x, 0x7feb352du);
+	x = veorq_u32(x, vshrq_n_u32(x, 15));
+	x = vmulq_n_u32(x, 0x846ca68bu);
+	return veorq_u32(x, vshrq_n_u32(x, 16));
+}
+
+static inline int32x4_t dither_rpdf(uint32x4_t x)
+{
+	return vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(dither_hash(x), 32 - PCM_VOLUME_SHIFT)),
+			 vdupq_n_s32(1 << (PCM_VOLUME_SHIFT - 1)));
+}
+
+static void volume_s16(int16_t *dst, const int16_t *src, unsigned int channels,
+		       unsigned int frames, int32_t volume, int64_t step, uint32_t pos, int dither)
+{
+	static const uint32_t index[4] = { 0, 1, 2, 3 };
+	const uint32x4_t lanes = vld1q_u32(index);
+	const int32x4_t round = vdupq_n_s32(1 << (PCM_VOLUME_SHIFT - 1));
+	unsigned int n = frames * channels, i = 0;
+	uint32x4_t p;
+	int32x4_t x;
+
+	if (step != 0) {
+		pcm_kernels_generic.volume_s16(dst, src, channels, frames, volume, step, pos, dither);
+		return;
+	}
+
+	for (; i + 4 <= n; i += 4) {
+		x = vmlaq_n_s32(round, vmovl_s16(vld1_s16(src + i)), volume);
+		p = vaddq_u32(vdupq_n_u32(pos + i), lanes);
+		if (dither == PCM_DITHER_TPDF)
+			x = vaddq_s32(x, vaddq_s32(dither_rpdf(p),
+						   dither_rpdf(vaddq_u32(p, vdupq_n_u32(PCM_DITHER_KEY)))));
+		else if (dither == PCM_DITHER_SHAPED)
+			x = vaddq_s32(x, vsubq_s32(dither_rpdf(p),
+						   dither_rpdf(vsubq_u32(p, vdupq_n_u32(channels)))));
+		/* saturating narrow after the shift, like the C clamp */
+		vst1_s16(dst + i, vqshrn_n_s32(x, PCM_VOLUME_SHIFT));
+	}
+
+	for (; i < n; i++)
+		dst[i] = pcm_volume_sample(src[i], volume, pos + i, channels, dither);
+}
+
+static const pcm_kernels kernels = {
+	.name = "neon",
+	.lerp_s16 = lerp_s16,
+	.gather_s32 = gather_s32,
+	.s16_to_s32 = s16_to_s32,
+	.gain_s32 = gain_s32,
+	.volume_s16 = volume_s16,
+};
+
+const pcm_kernels *pcm_kernels_neon(void)
+{
+	return &kernels;
+}
+
+#else
+
+const pcm_kernels *pcm_kernels_neon(void)
+{
+	return NULL;
+}
+
+#endif
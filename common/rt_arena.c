@@ -0,0 +1,121 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "rt_arena.h"
+
+#define HUGE_PAGE_SIZE          (2 * 1024 * 1024)
+
+static size_t page_size(void)
+{
+	long size = sysconf(_SC_PAGESIZE);
+
+	return size > 0 ? (size_t)size : 4096;
+}
+
+rt_arena *rt_arena_create(size_t size, int flags)
+{
+	rt_arena *arena;
+	void *base = MAP_FAILED;
+	size_t len;
+
+	arena = calloc(1, sizeof(*arena));
+	if (!arena)
+		return NULL;
+
+#ifdef MAP_HUGETLB
+	/* only worth it above a huge page, falls back when none is reserved */
+	if ((flags & RT_ARENA_HUGE) && size > HUGE_PAGE_SIZE / 2) {
+		len = (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+		base = mmap(NULL, len, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		arena->huge = base != MAP_FAILED;
+	}
+#endif
+	if (base == MAP_FAILED) {
+		len = (size + page_size() - 1) & ~(page_size() - 1);
+		base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+	if (base == MAP_FAILED) {
+		free(arena);
+		return NULL;
+	}
+
+	/* every page written once, then kept resident */
+	memset(base, 0, len);
+	arena->locked = mlock(base, len) == 0;
+	arena->lock_err = arena->locked ? 0 : errno;
+	arena->base = base;
+	arena->size = len;
+
+	return arena;
+}
+
+void rt_arena_destroy(rt_arena *arena)
+{
+	if (!arena)
+		return;
+
+	if (arena->locked)
+		munlock(arena->base, arena->size);
+	munmap(arena->base, arena->size);
+	free(arena);
+}
+
+void *rt_arena_alloc(rt_arena *arena, size_t size)
+{
+	void *p;
+
+	size = rt_arena_block(size);
+	if (size > arena->size - arena->used)
+		return NULL;
+
+	p = (char *)arena->base + arena->used;
+	arena->used += size;
+
+	return p;
+}
+
+void rt_arena_reset(rt_arena *arena)
+{
+	arena->used = 0;
+}
+
+int rt_lock(void *addr, size_t size)
+{
+	size_t page = page_size();
+	uintptr_t start, end, a;
+
+	if (!addr || size == 0)
+		return 0;
+
+	start = (uintptr_t)addr & ~(uintptr_t)(page - 1);
+	end = ((uintptr_t)addr + size + page - 1) & ~(uintptr_t)(page - 1);
+
+	/* a write per page breaks the copy on write of untouched heap pages */
+	for (a = (uintptr_t)addr; a < (uintptr_t)addr + size; a = (a & ~(uintptr_t)(page - 1)) + page)
+		*(volatile char *)a = *(volatile char *)a;
+
+	return mlock((void *)start, end - start) == 0 ? 0 : -errno;
+}
+
+void rt_unlock(void *addr, size_t size)
+{
+	size_t page = page_size();
+	uintptr_t start, end;
+
+	if (!addr || size == 0)
+		return;
+
+	start = (uintptr_t)addr & ~(uintptr_t)(page - 1);
+	end = ((uintptr_t)addr + size + page - 1) & ~(uintptr_t)(page - 1);
+	munlock((void *)start, end - start);
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file rt_arena.h
+   @brief locked and prefaulted memory for the real-time mode of the plugins
+*/
+
+#ifndef RT_ARENA_H
+#define RT_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RT_ARENA_ALIGN          64 /* cache line */
+#define RT_ARENA_HUGE           (1 << 0) /* huge pages when the system has some reserved */
+
+/*
+ * One anonymous mapping the working buffers of a stream are cut from at
+ * hw_params, so that nothing is allocated, faulted in or paged out while
+ * it runs. The pages are written once and locked with mlock(): when the
+ * lock fails, RLIMIT_MEMLOCK being too low, the arena is still usable and
+ * locked says so.
+ */
+typedef struct {
+	void *base;
+	size_t size;
+	size_t used;
+	int huge;
+	int locked;
+	int lock_err;       /* errno of mlock() when not locked */
+} rt_arena;
+
+rt_arena *rt_arena_create(size_t size, int flags);
+
+void rt_arena_destroy(rt_arena *arena);
+
+/* Cache line aligned block of size bytes, NULL when the arena is full. */
+void *rt_arena_alloc(rt_arena *arena, size_t size);
+
+/* Frees every block at once, the pages stay locked. */
+void rt_arena_reset(rt_arena *arena);
+
+/* Bytes taken by size once aligned, to size an arena. */
+static inline size_t rt_arena_block(size_t size)
+{
+	return (size + RT_ARENA_ALIGN - 1) & ~(size_t)(RT_ARENA_ALIGN - 1);
+}
+
+/*
+ * Faults in and locks a buffer allocated elsewhere, its content is kept.
+ * Returns 0 or a negative errno, the pages are faulted in either way.
+ */
+int rt_lock(void *addr, size_t size);
+
+void rt_unlock(void *addr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "shm_ctl.h"
+
+shm_ctl *shm_ctl_open(const char *name, size_t size, uint32_t magic, uint32_t version,
+		      mode_t mode, int create)
+{
+	shm_ctl *ctl;
+	int fd;
+
+	fd = shm_open(name, create ? O_CREAT | O_RDWR : O_RDWR, mode);
+	if (fd < 0)
+		return NULL;
+	/* the mixer and tuning tools may run as another user of the group */
+	if (create)
+		fchmod(fd, mode);
+	if (create && ftruncate(fd, size) < 0) {
+		close(fd);
+		return NULL;
+	}
+	ctl = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ctl == MAP_FAILED)
+		return NULL;
+
+	if (!create && (__atomic_load_n(&ctl->magic, __ATOMIC_ACQUIRE) != magic ||
+			ctl->version != version)) {
+		munmap(ctl, size);
+		errno = ENODEV;
+		return NULL;
+	}
+
+	return ctl;
+}
+
+uint32_t shm_ctl_publish(shm_ctl *ctl, uint32_t magic, uint32_t version)
+{
+	ctl->pid = getpid();
+	ctl->version = version;
+	__atomic_store_n(&ctl->magic, magic, __ATOMIC_RELEASE);
+	shm_ctl_commit(ctl);
+	return __atomic_load_n(&ctl->gen, __ATOMIC_ACQUIRE);
+}
+
+void shm_ctl_close(shm_ctl *ctl, size_t size)
+{
+	if (ctl)
+		munmap(ctl, size);
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file shm_ctl.h
+   @brief shared memory page of live controls, filled by a pcm and written by its control plugin
+*/
+
+#ifndef SHM_CTL_H
+#define SHM_CTL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Header a control page starts with. The pcm fills the page on open, a
+ * control writes a value then bumps gen, the pcm applies every value
+ * again once it sees a new gen. The page is kept after close so that the
+ * controls opened on it stay valid.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t pid;               /* of the pcm that filled it last */
+	uint32_t gen;
+} shm_ctl;
+
+/*
+ * Maps the page of size bytes, created when create is set, else checked
+ * to be of magic and version.
+ */
+shm_ctl *shm_ctl_open(const char *name, size_t size, uint32_t magic, uint32_t version,
+		      mode_t mode, int create);
+
+void shm_ctl_close(shm_ctl *ctl, size_t size);
+
+/* Publishes the values written before, to be applied on the next period. */
+static inline void shm_ctl_commit(shm_ctl *ctl)
+{
+	__atomic_add_fetch(&ctl->gen, 1, __ATOMIC_RELEASE);
+}
+
+/* Claims the page once the pcm filled its values, returns the gen seen. */
+uint32_t shm_ctl_publish(shm_ctl *ctl, uint32_t magic, uint32_t version);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
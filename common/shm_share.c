@@ -0,0 +1,154 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "shm_share.h"
+
+#define SHARE_ATTACH_TRIES                    3
+#define SHARE_READY_WAIT_MS                   1000
+
+static shm_share *share_create(int fd, const shm_share_kind *kind, size_t size)
+{
+	shm_share *sh;
+
+	if (ftruncate(fd, size) < 0)
+		return NULL;
+	sh = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (sh == MAP_FAILED)
+		return NULL;
+
+	sh->version = kind->version;
+	sh->owner_pid = getpid();
+	sh->running = 1;
+	sh->clients = 1;
+
+	return sh;
+}
+
+/*
+ * Returns the attached segment, NULL with errno set to EAGAIN when stale
+ * or EBUSY when its last pcm is detaching.
+ */
+static shm_share *share_open(int fd, const shm_share_kind *kind)
+{
+	struct timespec ts = { 0, 1000000 };
+	shm_share *sh;
+	size_t size;
+	int ms;
+
+	sh = mmap(NULL, kind->header, PROT_READ, MAP_SHARED, fd, 0);
+	if (sh == MAP_FAILED)
+		return NULL;
+
+	/* the owner may still be filling the header */
+	for (ms = 0; __atomic_load_n(&sh->magic, __ATOMIC_ACQUIRE) != kind->magic; ms++) {
+		if (ms == SHARE_READY_WAIT_MS) {
+			munmap(sh, kind->header);
+			errno = EAGAIN;
+			return NULL;
+		}
+		nanosleep(&ts, NULL);
+	}
+
+	if (sh->version != kind->version) {
+		munmap(sh, kind->header);
+		errno = EAGAIN;
+		return NULL;
+	}
+
+	size = kind->size(sh);
+	munmap(sh, kind->header);
+	sh = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (sh == MAP_FAILED)
+		return NULL;
+
+	/* unlinked by its last pcm any time now */
+	if (__atomic_fetch_add(&sh->clients, 1, __ATOMIC_ACQ_REL) == 0) {
+		__atomic_sub_fetch(&sh->clients, 1, __ATOMIC_ACQ_REL);
+		munmap(sh, size);
+		errno = EBUSY;
+		return NULL;
+	}
+
+	return sh;
+}
+
+shm_share *shm_share_attach(const char *name, const shm_share_kind *kind, size_t size,
+			    int *owner)
+{
+	struct timespec ts = { 0, 1000000 };
+	shm_share *sh = NULL;
+	int tries, busy = 0, fd;
+
+	for (tries = 0; tries < SHARE_ATTACH_TRIES && !sh; tries++) {
+		fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, kind->mode);
+		if (fd >= 0) {
+			/* the pcms of the group may attach whatever the umask */
+			fchmod(fd, kind->mode);
+			sh = share_create(fd, kind, size);
+			close(fd);
+			if (!sh) {
+				shm_unlink(name);
+				return NULL;
+			}
+			*owner = 1;
+			break;
+		}
+		if (errno != EEXIST)
+			return NULL;
+
+		fd = shm_open(name, O_RDWR, 0);
+		if (fd < 0)
+			continue;
+		sh = share_open(fd, kind);
+		close(fd);
+		/* wait for the name to go, unless its last pcm died detaching */
+		if (!sh && errno == EBUSY && busy++ < SHARE_READY_WAIT_MS) {
+			nanosleep(&ts, NULL);
+			tries--;
+			continue;
+		}
+		/* never published or of another version, replace it */
+		if (!sh && (errno == EAGAIN || errno == EBUSY))
+			shm_unlink(name);
+		*owner = 0;
+	}
+
+	return sh;
+}
+
+int shm_share_adopt(shm_share *sh)
+{
+	uint32_t pid = __atomic_load_n(&sh->owner_pid, __ATOMIC_ACQUIRE);
+
+	if (pid != 0 && (kill(pid, 0) == 0 || errno != ESRCH))
+		return 0;
+
+	/* several pcms may notice at once, one of them wins */
+	return __atomic_compare_exchange_n(&sh->owner_pid, &pid, getpid(), 0,
+					   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+void shm_share_detach(shm_share *sh, const char *name, size_t size, int owner)
+{
+	if (!sh)
+		return;
+
+	/* a pcm still attached adopts it */
+	if (owner)
+		__atomic_store_n(&sh->owner_pid, 0, __ATOMIC_RELEASE);
+	if (__atomic_sub_fetch(&sh->clients, 1, __ATOMIC_ACQ_REL) == 0)
+		shm_unlink(name);
+	munmap(sh, size);
+}
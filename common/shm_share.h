@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file shm_share.h
+   @brief shared memory segment a pcm owns and the other pcms of a stream attach to
+*/
+
+#ifndef SHM_SHARE_H
+#define SHM_SHARE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Header a segment starts with. The first pcm to attach creates the
+ * segment and owns it: it fills the rest of its header before setting
+ * magic. The owner produces for every pcm attached, not for itself only:
+ * when it detaches, or its process dies, one of the pcms still attached
+ * adopts the segment and produces in its place. The segment goes with the
+ * last pcm.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t owner_pid;         /* 0 once the owner left */
+	uint32_t running;           /* cleared when the producer failed */
+	uint32_t clients;           /* attached pcms, owner included */
+} shm_share;
+
+/* A kind of segment, its header starting with shm_share. */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	mode_t mode;
+	size_t header;              /* bytes of the header */
+	size_t (*size)(const shm_share *sh); /* of a segment, from its header */
+} shm_share_kind;
+
+/*
+ * Attaches to the segment name, creating it with size bytes when it
+ * doesn't exist. *owner is set when the caller created it, it then fills
+ * the rest of the header and calls shm_share_publish(). A segment without
+ * owner is attached like the others, see shm_share_adopt().
+ */
+shm_share *shm_share_attach(const char *name, const shm_share_kind *kind, size_t size,
+			    int *owner);
+
+/* Lets the pcms waiting in shm_share_attach() see the header. */
+static inline void shm_share_publish(shm_share *sh, const shm_share_kind *kind)
+{
+	__atomic_store_n(&sh->magic, kind->magic, __ATOMIC_RELEASE);
+}
+
+/*
+ * Makes the caller the owner of a segment its owner left or died with.
+ * Returns 1 when it has to produce from now on, 0 while another process
+ * owns it. The pcms attached call it periodically.
+ */
+int shm_share_adopt(shm_share *sh);
+
+/* Whether the segment is produced, or will be once it is adopted. */
+static inline int shm_share_running(const shm_share *sh)
+{
+	return __atomic_load_n(&sh->running, __ATOMIC_ACQUIRE);
+}
+
+/* Leaves the segment to the other pcms, see shm_share_adopt(). */
+void shm_share_detach(shm_share *sh, const char *name, size_t size, int owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "cic_caps.h"
+
+#define CAPS_NAME_MAX                         64
+
+/* /swpdm-caps- followed by the pcm name, anything but letters and digits as _ */
+static void caps_name(const char *slave, char *name)
+{
+	size_t n;
+
+	n = snprintf(name, CAPS_NAME_MAX, "/swpdm-caps-");
+	for (; *slave && n < CAPS_NAME_MAX - 1; slave++, n++)
+		name[n] = isalnum((unsigned char)*slave) ? *slave : '_';
+	name[n] = '\0';
+}
+
+static cic_caps *caps_map(const char *slave, int create)
+{
+	char name[CAPS_NAME_MAX];
+	cic_caps *caps;
+	uint32_t magic = 0;
+	struct stat st;
+	int fd;
+
+	caps_name(slave, name);
+	fd = shm_open(name, create ? O_CREAT | O_RDWR : O_RDWR, CIC_CAPS_MODE);
+	if (fd < 0)
+		return NULL;
+	/* the pcms of the group may probe it whatever the umask */
+	if (create)
+		fchmod(fd, CIC_CAPS_MODE);
+	/* the first opener sizes the page, zeroed: every entry is free */
+	if (create && ftruncate(fd, sizeof(*caps)) < 0) {
+		close(fd);
+		return NULL;
+	}
+	/* not sized yet by its creator, a miss rather than a SIGBUS */
+	if (!create && (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*caps))) {
+		close(fd);
+		return NULL;
+	}
+	caps = mmap(NULL, sizeof(*caps), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (caps == MAP_FAILED)
+		return NULL;
+
+	if (__atomic_load_n(&caps->magic, __ATOMIC_ACQUIRE) == 0 && create) {
+		caps->version = CIC_CAPS_VERSION;
+		__atomic_compare_exchange_n(&caps->magic, &magic, CIC_CAPS_MAGIC, 0,
+					    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+	}
+	if (__atomic_load_n(&caps->magic, __ATOMIC_ACQUIRE) != CIC_CAPS_MAGIC ||
+	    caps->version != CIC_CAPS_VERSION) {
+		munmap(caps, sizeof(*caps));
+		return NULL;
+	}
+
+	return caps;
+}
+
+int cic_caps_lookup(const char *slave, unsigned int osr, cic_caps_entry *caps)
+{
+	cic_caps *page;
+	unsigned int i;
+	int ret = -1;
+
+	page = caps_map(slave, 0);
+	if (!page)
+		return -1;
+
+	for (i = 0; i < CIC_CAPS_ENTRIES; i++) {
+		if (__atomic_load_n(&page->entry[i].osr, __ATOMIC_ACQUIRE) == osr) {
+			*caps = page->entry[i];
+			ret = 0;
+			break;
+		}
+	}
+
+	munmap(page, sizeof(*page));
+	return ret;
+}
+
+void cic_caps_store(const char *slave, const cic_caps_entry *caps)
+{
+	cic_caps *page;
+	cic_caps_entry *e;
+	uint32_t osr;
+	unsigned int i;
+
+	page = caps_map(slave, 1);
+	if (!page)
+		return;
+
+	for (i = 0; i < CIC_CAPS_ENTRIES; i++) {
+		e = &page->entry[i];
+		osr = 0;
+		if (__atomic_compare_exchange_n(&e->osr, &osr, CIC_CAPS_BUSY, 0,
+						__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			memcpy(e->rates, caps->rates, sizeof(e->rates));
+			memcpy(e->max_period, caps->max_period, sizeof(e->max_period));
+			__atomic_store_n(&e->osr, caps->osr, __ATOMIC_RELEASE);
+			break;
+		}
+		/* stored meanwhile by another pcm */
+		if (osr == caps->osr)
+			break;
+	}
+
+	munmap(page, sizeof(*page));
+}
@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file cic_caps.h
+   @brief pdm slave capabilities probed by cicFilter, cached per card
+*/
+
+#ifndef CIC_CAPS_H
+#define CIC_CAPS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CIC_CAPS_MAGIC                        0x53504143 /* "CAPS" */
+#define CIC_CAPS_VERSION                      1
+#define CIC_CAPS_MODE                         0660 /* the user and group of the stream */
+#define CIC_CAPS_ENTRIES                      8
+#define CIC_CAPS_LAYOUTS                      2 /* 4 and 8 slave channels */
+#define CIC_CAPS_BUSY                         (1u << 31)
+
+/*
+ * What the slave accepts at one OSR. Bit i of rates is set when the i-th
+ * rate of pdm_native_rates() can be captured, max_period is the largest
+ * slave period in frames, 0 when the layout can't be opened at all.
+ */
+typedef struct {
+	uint32_t osr;               /* 0 while free, CIC_CAPS_BUSY while written */
+	uint32_t rates[CIC_CAPS_LAYOUTS];
+	uint32_t max_period[CIC_CAPS_LAYOUTS];
+} cic_caps_entry;
+
+/*
+ * Layout of the /swpdm-caps-<slave> shared memory page. Entries are
+ * claimed free, filled and published by storing their osr last, they are
+ * never modified afterwards. The page lives in tmpfs, so the slave is
+ * probed again after every boot.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	cic_caps_entry entry[CIC_CAPS_ENTRIES];
+} cic_caps;
+
+/* Fills caps with the ones cached for slave at osr, returns 0 when found. */
+int cic_caps_lookup(const char *slave, unsigned int osr, cic_caps_entry *caps);
+
+/* Caches the caps probed for slave, a full or unusable page is left as is. */
+void cic_caps_store(const char *slave, const cic_caps_entry *caps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
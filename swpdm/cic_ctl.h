@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file cic_ctl.h
+   @brief live controls of cicFilter, shared with the cicCtl control plugin
+*/
+
+#ifndef CIC_CTL_H
+#define CIC_CTL_H
+
+#include <stdint.h>
+
+#include "shm_ctl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CIC_CTL_MAGIC                         0x4c544350 /* "PCTL" */
+#define CIC_CTL_VERSION                       1
+#define CIC_CTL_MODE                          0660 /* the user and group of the stream */
+#define CIC_CTL_CHANNELS                      8
+#define CIC_CTL_GAIN_MIN                      -600 /* 0.1 dB */
+#define CIC_CTL_GAIN_MAX                      240
+#define CIC_CTL_SETTLE_MAX                    1000000 /* us */
+
+/*
+ * Layout of the shared memory page named by the control option. The pcm
+ * fills it on open, a control writes a value then bumps gen, the pcm
+ * applies every value again once it sees a new gen. The page is kept
+ * after close so that the controls opened on it stay valid.
+ */
+typedef struct {
+	shm_ctl hdr;
+	int32_t mic_gain[CIC_CTL_CHANNELS]; /* 0.1 dB */
+	uint32_t map[CIC_CTL_CHANNELS]; /* mic + 1 of each channel, 0 as configured */
+	uint32_t settle_us;         /* discard window after a start or an overrun */
+} cic_ctl;
+
+/* Maps the page, created when create is set. */
+static inline cic_ctl *cic_ctl_open(const char *name, int create)
+{
+	return (cic_ctl *)shm_ctl_open(name, sizeof(cic_ctl), CIC_CTL_MAGIC, CIC_CTL_VERSION,
+				       CIC_CTL_MODE, create);
+}
+
+static inline void cic_ctl_close(cic_ctl *ctl)
+{
+	if (ctl)
+		shm_ctl_close(&ctl->hdr, sizeof(*ctl));
+}
+
+/* Publishes the values written before, to be applied on the next block. */
+static inline void cic_ctl_commit(cic_ctl *ctl)
+{
+	shm_ctl_commit(&ctl->hdr);
+}
+
+/* Claims the page once the values are filled, returns the gen seen. */
+static inline uint32_t cic_ctl_publish(cic_ctl *ctl)
+{
+	return shm_ctl_publish(&ctl->hdr, CIC_CTL_MAGIC, CIC_CTL_VERSION);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,339 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "cic_decimator.h"
+#include "pcm_kernels.h"
+
+#define CIC_FIR_TAPS                          64
+#define CIC_FIR_KAISER_BETA                   8.0
+#define CIC_FIR_DESIGN_STEPS                  2048
+
+/*
+ * The PDM words are DSD_U32_LE: the oldest bit is the MSB of the word.
+ * The order 5 CIC is computed as its equivalent FIR of length 5 * (R - 1) + 1
+ * on the +1/-1 bitstream. Instead of running the integrators at the bit rate,
+ * the bitstream is sliced in groups of 4 or 8 bits and every group is
+ * resolved with a table holding the partial sum of the kernel coefficients
+ * it covers, so one CIC output costs 5 * R / group_bits lookups.
+ */
+
+static double cic_response(double f, unsigned int ratio)
+{
+	double num, den;
+
+	if (f == 0.0)
+		return 1.0;
+
+	num = sin(M_PI * f);
+	den = ratio * sin(M_PI * f / ratio);
+	return pow(fabs(num / den), CIC_ORDER);
+}
+
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 32; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+/*
+ * Kaiser windowed low pass at the output Nyquist rate that flattens the CIC
+ * droop in the pass band. Frequencies are normalized to the CIC output rate.
+ */
+static void design_fir(float *coefs, unsigned int taps, unsigned int ratio)
+{
+	const double fo = 0.5 / CIC_FIR_DECIMATION;
+	const double fp = 0.8 * fo;
+	const double fs = 1.1 * fo;
+	const double df = fs / CIC_FIR_DESIGN_STEPS;
+	double *h, sum = 0.0;
+	double f, d, t, w;
+	unsigned int n, k;
+
+	h = malloc(taps * sizeof(*h));
+	if (!h)
+		return;
+
+	for (n = 0; n < taps; n++) {
+		t = n - (taps - 1) / 2.0;
+		h[n] = 0.0;
+		for (k = 0; k < CIC_FIR_DESIGN_STEPS; k++) {
+			f = (k + 0.5) * df;
+			d = 1.0 / cic_response(f, ratio);
+			if (f > fp)
+				d *= 0.5 * (1.0 + cos(M_PI * (f - fp) / (fs - fp)));
+			h[n] += 2.0 * d * cos(2.0 * M_PI * f * t) * df;
+		}
+		w = 2.0 * n / (taps - 1) - 1.0;
+		h[n] *= bessel_i0(CIC_FIR_KAISER_BETA * sqrt(1.0 - w * w)) / bessel_i0(CIC_FIR_KAISER_BETA);
+		sum += h[n];
+	}
+
+	for (n = 0; n < taps; n++)
+		coefs[n] = (float)(h[n] / sum);
+
+	free(h);
+}
+
+static int build_lut(cic_decimator *dec)
+{
+	unsigned int len = CIC_ORDER * (dec->ratio - 1) + 1;
+	unsigned int entries = 1 << dec->group_bits;
+	unsigned int i, j, k, v, stage;
+	int64_t *h, *tmp;
+
+	h = calloc(len, sizeof(*h));
+	tmp = calloc(len, sizeof(*tmp));
+	if (!h || !tmp) {
+		free(h);
+		free(tmp);
+		return -1;
+	}
+
+	/* (1 + z^-1 + ... + z^-(R-1))^5 */
+	h[0] = 1;
+	for (stage = 0; stage < CIC_ORDER; stage++) {
+		memset(tmp, 0, len * sizeof(*tmp));
+		for (i = 0; i < len; i++)
+			for (j = 0; j < dec->ratio && i + j < len; j++)
+				tmp[i + j] += h[i];
+		memcpy(h, tmp, len * sizeof(*h));
+	}
+
+	for (k = 0; k < dec->groups; k++) {
+		for (v = 0; v < entries; v++) {
+			int64_t acc = 0;
+			for (i = 0; i < dec->group_bits; i++) {
+				j = k * dec->group_bits + dec->group_bits - 1 - i;
+				if (j >= len)
+					continue;
+				if ((v >> (dec->group_bits - 1 - i)) & 1)
+					acc += h[j];
+				else
+					acc -= h[j];
+			}
+			dec->lut[k * entries + v] = (int32_t)acc;
+		}
+	}
+
+	free(h);
+	free(tmp);
+	return 0;
+}
+
+/* The FIR stage of the kernels of the cpu, the generic one when not built. */
+static cic_fir_stage fir_stage_for(const char *name)
+{
+	cic_fir_stage fn = NULL;
+
+	if (strcmp(name, "neon") == 0)
+		fn = cic_fir_stage_neon();
+	else if (strcmp(name, "avx2") == 0)
+		fn = cic_fir_stage_avx2();
+
+	return fn ? fn : cic_fir_stage_generic;
+}
+
+cic_decimator *cic_decimator_create(unsigned int osr, unsigned int channels,
+		unsigned int out_frames, float gain)
+{
+	cic_decimator *dec;
+	unsigned int len, cic_frames;
+
+	switch (osr) {
+	case 48:
+	case 64:
+	case 96:
+	case 128:
+	case 192:
+		break;
+	default:
+		fprintf(stderr, "%s: unsupported OSR %u\n", __func__, osr);
+		return NULL;
+	}
+
+	if (channels == 0 || channels > CIC_DECIMATOR_MAX_CHANNELS || out_frames == 0 || (out_frames * osr) % 32) {
+		fprintf(stderr, "%s: %u frames can't be decimated by %u\n", __func__, out_frames, osr);
+		return NULL;
+	}
+
+	dec = calloc(1, sizeof(*dec));
+	if (!dec)
+		return NULL;
+
+	dec->osr = osr;
+	dec->channels = channels;
+	dec->ratio = osr / CIC_FIR_DECIMATION;
+	dec->group_bits = dec->ratio % 8 ? 4 : 8;
+	len = CIC_ORDER * (dec->ratio - 1) + 1;
+	dec->groups = (len + dec->group_bits - 1) / dec->group_bits;
+	dec->taps = CIC_FIR_TAPS;
+	dec->scale = gain / CIC_S32_FULL_SCALE;
+	dec->inputBufferSizePerChannel = out_frames * osr / 32;
+	dec->outputBufferSizePerChannel = out_frames;
+
+	cic_frames = out_frames * CIC_FIR_DECIMATION;
+	dec->bits_len = dec->groups - 1 + dec->inputBufferSizePerChannel * 32 / dec->group_bits;
+
+	dec->lut = malloc(dec->groups * (1 << dec->group_bits) * sizeof(*dec->lut));
+	dec->bits = malloc(channels * dec->bits_len);
+	dec->coefs = malloc(dec->taps * sizeof(*dec->coefs));
+	dec->fir = malloc((dec->taps - 1 + cic_frames) * channels * sizeof(*dec->fir));
+	dec->inputBuffer = malloc(dec->inputBufferSizePerChannel * channels * sizeof(*dec->inputBuffer));
+	dec->outputBuffer = malloc(out_frames * channels * sizeof(*dec->outputBuffer));
+	if (!dec->lut || !dec->bits || !dec->coefs || !dec->fir ||
+	    !dec->inputBuffer || !dec->outputBuffer || build_lut(dec) < 0) {
+		cic_decimator_destroy(dec);
+		return NULL;
+	}
+
+	design_fir(dec->coefs, dec->taps, dec->ratio);
+	dec->fir_stage = fir_stage_for(pcm_kernels_get()->name);
+	cic_decimator_reset(dec);
+
+	return dec;
+}
+
+void cic_decimator_destroy(cic_decimator *dec)
+{
+	if (!dec)
+		return;
+
+	free(dec->lut);
+	free(dec->bits);
+	free(dec->coefs);
+	free(dec->fir);
+	free(dec->inputBuffer);
+	free(dec->outputBuffer);
+	free(dec);
+}
+
+void cic_decimator_reset(cic_decimator *dec)
+{
+	/* An alternating bitstream is the PDM code of silence. */
+	memset(dec->bits, dec->group_bits == 8 ? 0xaa : 0x0a, dec->channels * dec->bits_len);
+	memset(dec->fir, 0, (dec->taps - 1) * dec->channels * sizeof(*dec->fir));
+}
+
+static void cic_stage(cic_decimator *dec)
+{
+	unsigned int channels = dec->channels;
+	unsigned int frames = dec->inputBufferSizePerChannel;
+	unsigned int history = dec->groups - 1;
+	unsigned int hop = dec->ratio / dec->group_bits;
+	unsigned int shift = dec->group_bits;
+	unsigned int cic_frames = dec->outputBufferSizePerChannel * CIC_FIR_DECIMATION;
+	float *fir = dec->fir + (dec->taps - 1) * channels;
+	const int32_t *lut = dec->lut;
+	unsigned int ch, f, n, k, p;
+	uint8_t *bits;
+	uint32_t w;
+	int32_t acc;
+
+	for (ch = 0; ch < channels; ch++) {
+		bits = dec->bits + ch * dec->bits_len;
+
+		/* slice the words of this channel in bit groups, oldest first */
+		p = history;
+		for (f = 0; f < frames; f++) {
+			w = dec->inputBuffer[f * channels + ch];
+			if (shift == 8) {
+				bits[p++] = w >> 24;
+				bits[p++] = w >> 16;
+				bits[p++] = w >> 8;
+				bits[p++] = w;
+			} else {
+				for (k = 0; k < 8; k++)
+					bits[p++] = (w >> (28 - 4 * k)) & 0xf;
+			}
+		}
+
+		p = history + hop - 1;
+		for (n = 0; n < cic_frames; n++, p += hop) {
+			acc = 0;
+			for (k = 0; k < dec->groups; k++)
+				acc += lut[(k << shift) + bits[p - k]];
+			fir[n * channels + ch] = acc * dec->scale;
+		}
+
+		memmove(bits, bits + dec->bits_len - history, history);
+	}
+}
+
+static inline int32_t to_s32(float v)
+{
+	v *= CIC_S32_FULL_SCALE;
+	if (v > CIC_S32_MAX_FLOAT)
+		v = CIC_S32_MAX_FLOAT;
+	else if (v < -CIC_S32_FULL_SCALE)
+		v = -CIC_S32_FULL_SCALE;
+	return (int32_t)lrintf(v);
+}
+
+void cic_fir_stage_generic(cic_decimator *dec, unsigned int first)
+{
+	unsigned int channels = dec->channels;
+	unsigned int m, ch, i;
+	const float *x, *p;
+	int32_t *out;
+	float a0, a1, a2, a3, c;
+
+	for (m = first; m < dec->outputBufferSizePerChannel; m++) {
+		x = dec->fir + (m * CIC_FIR_DECIMATION + CIC_FIR_DECIMATION - 1) * channels;
+		out = dec->outputBuffer + m * channels;
+		/* four independent accumulators per pass over the taps */
+		for (ch = 0; ch + 4 <= channels; ch += 4) {
+			a0 = a1 = a2 = a3 = 0.0f;
+			for (i = 0, p = x + ch; i < dec->taps; i++, p += channels) {
+				c = dec->coefs[i];
+				a0 += c * p[0];
+				a1 += c * p[1];
+				a2 += c * p[2];
+				a3 += c * p[3];
+			}
+			out[ch] = to_s32(a0);
+			out[ch + 1] = to_s32(a1);
+			out[ch + 2] = to_s32(a2);
+			out[ch + 3] = to_s32(a3);
+		}
+		for (; ch < channels; ch++) {
+			a0 = 0.0f;
+			for (i = 0, p = x + ch; i < dec->taps; i++, p += channels)
+				a0 += dec->coefs[i] * p[0];
+			out[ch] = to_s32(a0);
+		}
+	}
+}
+
+double cic_decimator_delay(unsigned int osr)
+{
+	/* both stages are linear phase, the CIC runs at the bit rate */
+	return CIC_ORDER * (osr / CIC_FIR_DECIMATION - 1) / 2.0 / osr +
+	       (CIC_FIR_TAPS - 1) / 2.0 / CIC_FIR_DECIMATION;
+}
+
+void cic_decimator_process(cic_decimator *dec)
+{
+	unsigned int channels = dec->channels;
+	unsigned int cic_frames = dec->outputBufferSizePerChannel * CIC_FIR_DECIMATION;
+
+	cic_stage(dec);
+	dec->fir_stage(dec, 0);
+
+	memmove(dec->fir, dec->fir + cic_frames * channels,
+		(dec->taps - 1) * channels * sizeof(*dec->fir));
+}
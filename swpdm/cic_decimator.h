@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file cic_decimator.h
+   @brief portable order 5 CIC decimator with compensation FIR
+*/
+
+#ifndef CIC_DECIMATOR_H
+#define CIC_DECIMATOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decimation of the compensation FIR, the CIC decimates by OSR / 4. */
+#define CIC_FIR_DECIMATION                    4
+#define CIC_ORDER                             5
+#define CIC_DECIMATOR_MAX_CHANNELS            8
+
+/* Largest float below 2^31, used to saturate the S32 conversion. */
+#define CIC_S32_FULL_SCALE                    2147483648.0f
+#define CIC_S32_MAX_FLOAT                     2147483520.0f
+
+typedef struct cic_decimator cic_decimator;
+
+/* FIR stage from output frame first to the end of the block. */
+typedef void (*cic_fir_stage)(cic_decimator *dec, unsigned int first);
+
+struct cic_decimator {
+	unsigned int osr;
+	unsigned int channels;
+	/* CIC stage */
+	unsigned int ratio;         /* CIC decimation, OSR / 4 */
+	unsigned int group_bits;    /* bits looked up at once, 4 or 8 */
+	unsigned int groups;        /* bit groups covered by the CIC kernel */
+	int32_t *lut;               /* groups * (1 << group_bits) partial sums */
+	uint8_t *bits;              /* per channel history + block of bit groups */
+	unsigned int bits_len;
+	/* FIR stage */
+	unsigned int taps;
+	float *coefs;
+	float *fir;                 /* interleaved history + block of CIC output */
+	float scale;
+	cic_fir_stage fir_stage;    /* variant of the cpu, see cic_decimator_create() */
+	/* Block buffers, DSD_U32_LE in and S32_LE out, channel interleaved. */
+	uint32_t *inputBuffer;
+	int32_t *outputBuffer;
+	unsigned int inputBufferSizePerChannel;
+	unsigned int outputBufferSizePerChannel;
+};
+
+cic_decimator *cic_decimator_create(unsigned int osr, unsigned int channels,
+		unsigned int out_frames, float gain);
+
+void cic_decimator_destroy(cic_decimator *dec);
+
+void cic_decimator_reset(cic_decimator *dec);
+
+void cic_decimator_process(cic_decimator *dec);
+
+/* Group delay of the CIC and FIR stages, in output frames. */
+double cic_decimator_delay(unsigned int osr);
+
+/*
+ * The FIR stage variants give the same samples bit for bit. The SIMD ones
+ * are built with their own flags in cic_decimator_neon.c and
+ * cic_decimator_avx2.c, NULL when not built for this target, and the one
+ * of the pcm kernels chosen for the cpu is used, see pcm_kernels_get().
+ */
+void cic_fir_stage_generic(cic_decimator *dec, unsigned int first);
+cic_fir_stage cic_fir_stage_neon(void);
+cic_fir_stage cic_fir_stage_avx2(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * AVX2 FIR stage of the built-in decimator, built with -mavx2 and only
+ * called when the cpu has it. Two output frames at a time, four channels
+ * of each per vector; the conversion rounds to nearest even like lrintf().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cic_decimator.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+static void fir_stage(cic_decimator *dec, unsigned int first)
+{
+	unsigned int channels = dec->channels;
+	unsigned int stride = CIC_FIR_DECIMATION * channels;
+	unsigned int m, ch, i;
+	const float *x;
+	__m256 acc, c;
+	__m256i out;
+
+	if (channels % 4) {
+		cic_fir_stage_generic(dec, first);
+		return;
+	}
+
+	for (m = first; m + 1 < dec->outputBufferSizePerChannel; m += 2) {
+		x = dec->fir + (m * CIC_FIR_DECIMATION + CIC_FIR_DECIMATION - 1) * channels;
+		for (ch = 0; ch < channels; ch += 4) {
+			acc = _mm256_setzero_ps();
+			for (i = 0; i < dec->taps; i++) {
+				c = _mm256_set1_ps(dec->coefs[i]);
+				acc = _mm256_add_ps(acc, _mm256_mul_ps(c,
+					_mm256_insertf128_ps(_mm256_castps128_ps256(
+						_mm_loadu_ps(x + i * channels + ch)),
+						_mm_loadu_ps(x + i * channels + stride + ch), 1)));
+			}
+			acc = _mm256_mul_ps(acc, _mm256_set1_ps(CIC_S32_FULL_SCALE));
+			acc = _mm256_min_ps(acc, _mm256_set1_ps(CIC_S32_MAX_FLOAT));
+			acc = _mm256_max_ps(acc, _mm256_set1_ps(-CIC_S32_FULL_SCALE));
+			out = _mm256_cvtps_epi32(acc);
+			_mm_storeu_si128((__m128i *)(dec->outputBuffer + m * channels + ch),
+					 _mm256_castsi256_si128(out));
+			_mm_storeu_si128((__m128i *)(dec->outputBuffer + (m + 1) * channels + ch),
+					 _mm256_extracti128_si256(out, 1));
+		}
+	}
+
+	cic_fir_stage_generic(dec, m);
+}
+
+cic_fir_stage cic_fir_stage_avx2(void)
+{
+	return fir_stage;
+}
+
+#else
+
+cic_fir_stage cic_fir_stage_avx2(void)
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * NEON FIR stage of the built-in decimator, one output frame at a time,
+ * four channels per vector. It needs the round to nearest conversion of
+ * ARMv8 to give the samples of lrintf(); ARMv7 keeps the C loop.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cic_decimator.h"
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__ARM_FEATURE_DIRECTED_ROUNDING)
+#include <arm_neon.h>
+
+static void fir_stage(cic_decimator *dec, unsigned int first)
+{
+	unsigned int channels = dec->channels;
+	unsigned int m, ch, i;
+	const float *x;
+	float32x4_t acc;
+
+	if (channels % 4) {
+		cic_fir_stage_generic(dec, first);
+		return;
+	}
+
+	for (m = first; m < dec->outputBufferSizePerChannel; m++) {
+		x = dec->fir + (m * CIC_FIR_DECIMATION + CIC_FIR_DECIMATION - 1) * channels;
+		for (ch = 0; ch < channels; ch += 4) {
+			acc = vdupq_n_f32(0.0f);
+			for (i = 0; i < dec->taps; i++)
+				acc = vmlaq_n_f32(acc, vld1q_f32(x + i * channels + ch), dec->coefs[i]);
+			/* saturated like to_s32(), the conversion alone would reach INT32_MAX */
+			acc = vmulq_n_f32(acc, CIC_S32_FULL_SCALE);
+			acc = vminq_f32(acc, vdupq_n_f32(CIC_S32_MAX_FLOAT));
+			acc = vmaxq_f32(acc, vdupq_n_f32(-CIC_S32_FULL_SCALE));
+			vst1q_s32(dec->outputBuffer + m * channels + ch, vcvtnq_s32_f32(acc));
+		}
+	}
+}
+
+cic_fir_stage cic_fir_stage_neon(void)
+{
+	return fir_stage;
+}
+
+#else
+
+cic_fir_stage cic_fir_stage_neon(void)
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "cic_gate.h"
+#include "pcm_kernels.h"
+
+/* popcount amplitude of a full scale sine, half of the 32 bits of a word */
+#define POPCOUNT_FULL_SCALE                   16.0
+
+/* The integrators of the kernels of the cpu, the generic ones when not built. */
+static cic_gate_integrate integrate_for(const char *name)
+{
+	cic_gate_integrate fn = NULL;
+
+	if (strcmp(name, "neon") == 0)
+		fn = cic_gate_integrate_neon();
+	else if (strcmp(name, "avx2") == 0)
+		fn = cic_gate_integrate_avx2();
+
+	return fn ? fn : cic_gate_integrate_generic;
+}
+
+cic_gate *cic_gate_create(unsigned int frames, unsigned int word_rate, float threshold_db,
+		unsigned int hold)
+{
+	cic_gate *gate;
+	double amp;
+
+	gate = calloc(1, sizeof(*gate));
+	if (!gate)
+		return NULL;
+
+	gate->prev = calloc((size_t)frames * CIC_GATE_CHANNELS, sizeof(uint32_t));
+	if (!gate->prev) {
+		free(gate);
+		return NULL;
+	}
+
+	gate->frames = frames;
+	gate->decimation = word_rate / CIC_GATE_RATE;
+	if (gate->decimation == 0)
+		gate->decimation = 1;
+	amp = POPCOUNT_FULL_SCALE * pow(gate->decimation, CIC_GATE_ORDER);
+	gate->full_scale = amp * amp / 2;
+	gate->open_level = threshold_db;
+	gate->close_level = threshold_db - CIC_GATE_HYSTERESIS;
+	gate->hold = hold;
+	gate->integrate = integrate_for(pcm_kernels_get()->name);
+	cic_gate_reset(gate);
+
+	return gate;
+}
+
+void cic_gate_destroy(cic_gate *gate)
+{
+	if (!gate)
+		return;
+
+	free(gate->prev);
+	free(gate);
+}
+
+void cic_gate_reset(cic_gate *gate)
+{
+	gate->state = CIC_GATE_OPEN;
+	gate->idle = 0;
+	gate->phase = 0;
+	memset(gate->integ, 0, sizeof(gate->integ));
+	memset(gate->comb, 0, sizeof(gate->comb));
+}
+
+void cic_gate_comb(cic_gate *gate, cic_gate_activity *act)
+{
+	unsigned int ch, o;
+	uint32_t y, t;
+
+	for (ch = 0; ch < CIC_GATE_CHANNELS; ch++) {
+		y = gate->integ[CIC_GATE_ORDER - 1][ch];
+		for (o = 0; o < CIC_GATE_ORDER; o++) {
+			t = y - gate->comb[o][ch];
+			gate->comb[o][ch] = y;
+			y = t;
+		}
+		act->sum[ch] += (int32_t)y;
+		act->sq[ch] += (double)(int32_t)y * (int32_t)y;
+	}
+	act->count++;
+}
+
+void cic_gate_integrate_generic(cic_gate *gate, const uint32_t *pdm, cic_gate_activity *act)
+{
+	unsigned int f, ch;
+
+	for (f = 0; f < gate->frames; f++) {
+		for (ch = 0; ch < CIC_GATE_CHANNELS; ch++) {
+			gate->integ[0][ch] += __builtin_popcount(pdm[f * CIC_GATE_CHANNELS + ch]);
+			gate->integ[1][ch] += gate->integ[0][ch];
+			gate->integ[2][ch] += gate->integ[1][ch];
+		}
+		if (++gate->phase == gate->decimation) {
+			gate->phase = 0;
+			cic_gate_comb(gate, act);
+		}
+	}
+}
+
+void cic_gate_measure(cic_gate *gate, const uint32_t *pdm)
+{
+	cic_gate_activity act;
+	double mean, var;
+	unsigned int ch;
+
+	memset(&act, 0, sizeof(act));
+	gate->integrate(gate, pdm, &act);
+	/* a period shorter than an output keeps the last levels */
+	if (act.count == 0)
+		return;
+
+	for (ch = 0; ch < CIC_GATE_CHANNELS; ch++) {
+		mean = act.sum[ch] / act.count;
+		var = act.sq[ch] / act.count - mean * mean;
+		gate->level[ch] = 10.0 * log10(var / gate->full_scale + 1e-12);
+	}
+}
+
+int cic_gate_update(cic_gate *gate, const uint32_t *pdm)
+{
+	float max;
+	unsigned int ch;
+
+	cic_gate_measure(gate, pdm);
+	max = gate->level[0];
+	for (ch = 1; ch < CIC_GATE_CHANNELS; ch++)
+		if (gate->level[ch] > max)
+			max = gate->level[ch];
+
+	if (gate->state == CIC_GATE_CLOSED) {
+		if (max >= gate->open_level) {
+			gate->state = CIC_GATE_OPENING;
+			gate->idle = 0;
+			return gate->state;
+		}
+		/* the decoder is warmed up with it if the next period opens */
+		memcpy(gate->prev, pdm, (size_t)gate->frames * CIC_GATE_CHANNELS * sizeof(*pdm));
+		return gate->state;
+	}
+
+	gate->state = CIC_GATE_OPEN;
+	if (max >= gate->close_level)
+		gate->idle = 0;
+	else if (++gate->idle > gate->hold)
+		gate->state = CIC_GATE_CLOSED;
+	if (gate->state == CIC_GATE_CLOSED)
+		memcpy(gate->prev, pdm, (size_t)gate->frames * CIC_GATE_CHANNELS * sizeof(*pdm));
+
+	return gate->state;
+}
+
+void cic_gate_swap(cic_gate *gate, uint32_t *pdm)
+{
+	size_t i, n = (size_t)gate->frames * CIC_GATE_CHANNELS;
+	uint32_t t;
+
+	for (i = 0; i < n; i++) {
+		t = pdm[i];
+		pdm[i] = gate->prev[i];
+		gate->prev[i] = t;
+	}
+}
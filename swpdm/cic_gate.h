@@ -0,0 +1,101 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file cic_gate.h
+   @brief pdm activity gate, skips the decoding of idle microphones
+*/
+
+#ifndef CIC_GATE_H
+#define CIC_GATE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CIC_GATE_CHANNELS                     4 /* channels of a decoder group */
+#define CIC_GATE_HYSTERESIS                   6.0f /* dB below the threshold to close */
+#define CIC_GATE_ORDER                        3
+#define CIC_GATE_RATE                         8000 /* of the activity estimate */
+
+enum {
+	CIC_GATE_CLOSED,            /* skip the decoder, the period is idle */
+	CIC_GATE_OPENING,           /* decode the previous period first, then this one */
+	CIC_GATE_OPEN,
+};
+
+typedef struct cic_gate cic_gate;
+
+/* Sums of the CIC outputs of a period, for its activity. */
+typedef struct {
+	double sum[CIC_GATE_CHANNELS];
+	double sq[CIC_GATE_CHANNELS];
+	unsigned int count;
+} cic_gate_activity;
+
+/* Runs the integrators over a period, combing every decimated output into act. */
+typedef void (*cic_gate_integrate)(cic_gate *gate, const uint32_t *pdm, cic_gate_activity *act);
+
+/*
+ * One gate per decoder group. The popcount of every pdm word goes through
+ * a small CIC decimating to about CIC_GATE_RATE, the activity of a channel
+ * is the variance of its output over a period in dB of a full scale sine.
+ * The group is idle once every channel stays below the threshold less the
+ * hysteresis for hold periods in a row.
+ */
+struct cic_gate {
+	float open_level;           /* dB */
+	float close_level;
+	unsigned int hold;          /* idle periods before closing */
+	unsigned int idle;
+	int state;
+	unsigned int frames;        /* pdm frames of a period */
+	unsigned int decimation;    /* pdm frames per CIC output */
+	unsigned int phase;
+	uint32_t integ[CIC_GATE_ORDER][CIC_GATE_CHANNELS];
+	uint32_t comb[CIC_GATE_ORDER][CIC_GATE_CHANNELS];
+	double full_scale;          /* CIC output variance of a full scale sine */
+	uint32_t *prev;             /* last idle period, to warm up the decoder */
+	float level[CIC_GATE_CHANNELS];
+	cic_gate_integrate integrate; /* variant of the cpu, see cic_gate_create() */
+};
+
+/* word_rate is the rate of the pdm words, the slave rate. */
+cic_gate *cic_gate_create(unsigned int frames, unsigned int word_rate, float threshold_db,
+		unsigned int hold);
+
+void cic_gate_destroy(cic_gate *gate);
+
+/* Opens the gate for at least hold periods, e.g. while the decoders settle. */
+void cic_gate_reset(cic_gate *gate);
+
+/* Updates the activity of every channel with gate->frames interleaved pdm frames. */
+void cic_gate_measure(cic_gate *gate, const uint32_t *pdm);
+
+/* Measures the period in pdm and returns the CIC_GATE_ state to decode it with. */
+int cic_gate_update(cic_gate *gate, const uint32_t *pdm);
+
+/* Exchanges pdm and the last idle period, around the decoding of the latter. */
+void cic_gate_swap(cic_gate *gate, uint32_t *pdm);
+
+/* Combs of one decimated CIC output, accumulated in act. */
+void cic_gate_comb(cic_gate *gate, cic_gate_activity *act);
+
+/*
+ * The integrator variants give the same activity. The SIMD ones are built
+ * with their own flags in cic_gate_neon.c and cic_gate_avx2.c, NULL when
+ * not built for this target, and the one of the pcm kernels chosen for
+ * the cpu is used, see pcm_kernels_get().
+ */
+void cic_gate_integrate_generic(cic_gate *gate, const uint32_t *pdm, cic_gate_activity *act);
+cic_gate_integrate cic_gate_integrate_neon(void);
+cic_gate_integrate cic_gate_integrate_avx2(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * AVX2 integrators of the activity gate, built with -mavx2 and only
+ * called when the cpu has it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cic_gate.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+static inline void integrate_frame(cic_gate *gate, __m128i p, __m128i *i0, __m128i *i1,
+				   __m128i *i2, cic_gate_activity *act)
+{
+	*i0 = _mm_add_epi32(*i0, p);
+	*i1 = _mm_add_epi32(*i1, *i0);
+	*i2 = _mm_add_epi32(*i2, *i1);
+	if (++gate->phase == gate->decimation) {
+		gate->phase = 0;
+		_mm_storeu_si128((__m128i *)gate->integ[2], *i2);
+		cic_gate_comb(gate, act);
+	}
+}
+
+/* Popcount of every 32 bit word with a nibble lookup. */
+static inline __m256i popcount32(__m256i v)
+{
+	const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+					     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+	__m256i cnt;
+
+	cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, nibble)),
+			      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+	/* bytes to 32 bit words */
+	return _mm256_madd_epi16(_mm256_maddubs_epi16(cnt, _mm256_set1_epi8(1)), _mm256_set1_epi16(1));
+}
+
+/* Two frames at a time, four channels per 128 bit lane. */
+static void integrate(cic_gate *gate, const uint32_t *pdm, cic_gate_activity *act)
+{
+	__m128i i0 = _mm_loadu_si128((const __m128i *)gate->integ[0]);
+	__m128i i1 = _mm_loadu_si128((const __m128i *)gate->integ[1]);
+	__m128i i2 = _mm_loadu_si128((const __m128i *)gate->integ[2]);
+	__m256i cnt;
+	unsigned int f;
+
+	for (f = 0; f + 1 < gate->frames; f += 2) {
+		cnt = popcount32(_mm256_loadu_si256((const __m256i *)(pdm + f * CIC_GATE_CHANNELS)));
+		integrate_frame(gate, _mm256_castsi256_si128(cnt), &i0, &i1, &i2, act);
+		integrate_frame(gate, _mm256_extracti128_si256(cnt, 1), &i0, &i1, &i2, act);
+	}
+	if (f < gate->frames) {
+		cnt = popcount32(_mm256_castsi128_si256(
+			_mm_loadu_si128((const __m128i *)(pdm + f * CIC_GATE_CHANNELS))));
+		integrate_frame(gate, _mm256_castsi256_si128(cnt), &i0, &i1, &i2, act);
+	}
+	_mm_storeu_si128((__m128i *)gate->integ[0], i0);
+	_mm_storeu_si128((__m128i *)gate->integ[1], i1);
+	_mm_storeu_si128((__m128i *)gate->integ[2], i2);
+}
+
+cic_gate_integrate cic_gate_integrate_avx2(void)
+{
+	return integrate;
+}
+
+#else
+
+cic_gate_integrate cic_gate_integrate_avx2(void)
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * NEON integrators of the activity gate, native on ARMv8 and built with
+ * -mfpu=neon on ARMv7 where they are only called when the cpu has NEON.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cic_gate.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+/* One frame at a time, the four channels in one vector. */
+static void integrate(cic_gate *gate, const uint32_t *pdm, cic_gate_activity *act)
+{
+	uint32x4_t i0 = vld1q_u32(gate->integ[0]);
+	uint32x4_t i1 = vld1q_u32(gate->integ[1]);
+	uint32x4_t i2 = vld1q_u32(gate->integ[2]);
+	unsigned int f;
+
+	for (f = 0; f < gate->frames; f++) {
+		i0 = vaddq_u32(i0, vpaddlq_u16(vpaddlq_u8(vcntq_u8(
+			vld1q_u8((const uint8_t *)(pdm + f * CIC_GATE_CHANNELS))))));
+		i1 = vaddq_u32(i1, i0);
+		i2 = vaddq_u32(i2, i1);
+		if (++gate->phase == gate->decimation) {
+			gate->phase = 0;
+			vst1q_u32(gate->integ[2], i2);
+			cic_gate_comb(gate, act);
+		}
+	}
+	vst1q_u32(gate->integ[0], i0);
+	vst1q_u32(gate->integ[1], i1);
+	vst1q_u32(gate->integ[2], i2);
+}
+
+cic_gate_integrate cic_gate_integrate_neon(void)
+{
+	return integrate;
+}
+
+#else
+
+cic_gate_integrate cic_gate_integrate_neon(void)
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "cic_share.h"
+
+static size_t share_size(const shm_share *hdr)
+{
+	const cic_share *sh = (const cic_share *)hdr;
+
+	return sizeof(cic_share) + (size_t)sh->channels * sh->capacity * sizeof(int32_t);
+}
+
+static const shm_share_kind share_kind = {
+	.magic = CIC_SHARE_MAGIC,
+	.version = CIC_SHARE_VERSION,
+	.mode = CIC_SHARE_MODE,
+	.header = sizeof(cic_share),
+	.size = share_size,
+};
+
+cic_share *cic_share_attach(const char *name, unsigned int osr, unsigned int rate,
+		unsigned int channels, unsigned int block, unsigned int capacity, int *owner)
+{
+	size_t size = sizeof(cic_share) + (size_t)channels * capacity * sizeof(int32_t);
+	cic_share *sh;
+
+	sh = (cic_share *)shm_share_attach(name, &share_kind, size, owner);
+	if (!sh || !*owner)
+		return sh;
+
+	sh->osr = osr;
+	sh->rate = rate;
+	sh->channels = channels;
+	sh->block = block;
+	sh->capacity = capacity;
+	sh->started = 0;
+	sh->write_pos = 0;
+	sh->xruns = 0;
+	shm_share_publish(&sh->hdr, &share_kind);
+
+	return sh;
+}
+
+void cic_share_detach(cic_share *sh, const char *name, int owner)
+{
+	if (sh)
+		shm_share_detach(&sh->hdr, name, share_size(&sh->hdr), owner);
+}
@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file cic_share.h
+   @brief shared memory ring of decoded pdm frames, one writer and many readers
+*/
+
+#ifndef CIC_SHARE_H
+#define CIC_SHARE_H
+
+#include <stdint.h>
+
+#include "shm_share.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CIC_SHARE_MAGIC                       0x52484353 /* "SCHR" */
+#define CIC_SHARE_VERSION                     2
+#define CIC_SHARE_MODE                        0660 /* the user and group of the owner */
+
+/*
+ * Layout of the shared memory segment. The owner fills the header before
+ * setting magic, then only write_pos, xruns, started and the fields of hdr
+ * change. Readers keep their own read position and never write to the
+ * ring, the owner decodes while at least one of them is started.
+ */
+typedef struct {
+	shm_share hdr;              /* running until the decoding failed */
+	uint32_t osr;
+	uint32_t rate;              /* of the decoded frames */
+	uint32_t channels;          /* mics, interleaved S32 */
+	uint32_t block;             /* frames published at once */
+	uint32_t capacity;          /* frames of the ring */
+	uint32_t started;           /* pcms started */
+	uint32_t reserved;
+	uint64_t write_pos;         /* frames published since the start */
+	uint64_t xruns;             /* overruns of the pdm slave */
+	int32_t data[];
+} cic_share;
+
+/*
+ * Attaches to the segment name, creating it when it doesn't exist. *owner
+ * is set when the caller created it and has to publish, the other
+ * parameters are then used to size it, else the ones of the owner are
+ * kept.
+ */
+cic_share *cic_share_attach(const char *name, unsigned int osr, unsigned int rate,
+		unsigned int channels, unsigned int block, unsigned int capacity, int *owner);
+
+/* Whether the frames keep coming, see shm_share_running(). */
+static inline int cic_share_running(const cic_share *sh)
+{
+	return shm_share_running(&sh->hdr);
+}
+
+/* Takes over the decoding of an owner that left, see shm_share_adopt(). */
+static inline int cic_share_adopt(cic_share *sh)
+{
+	return shm_share_adopt(&sh->hdr);
+}
+
+/* Counts the pcm as reading, or not anymore, the owner idles without. */
+static inline void cic_share_start(cic_share *sh, int on)
+{
+	if (on)
+		__atomic_add_fetch(&sh->started, 1, __ATOMIC_ACQ_REL);
+	else
+		__atomic_sub_fetch(&sh->started, 1, __ATOMIC_ACQ_REL);
+}
+
+static inline int cic_share_started(const cic_share *sh)
+{
+	return __atomic_load_n(&sh->started, __ATOMIC_ACQUIRE) != 0;
+}
+
+void cic_share_detach(cic_share *sh, const char *name, int owner);
+
+static inline int32_t *cic_share_frame(cic_share *sh, uint64_t pos)
+{
+	return sh->data + (pos % sh->capacity) * sh->channels;
+}
+
+static inline uint64_t cic_share_write_pos(const cic_share *sh)
+{
+	return __atomic_load_n(&sh->write_pos, __ATOMIC_ACQUIRE);
+}
+
+/* Makes the frames written after write_pos visible to the readers. */
+static inline void cic_share_commit(cic_share *sh, unsigned int frames)
+{
+	__atomic_store_n(&sh->write_pos, sh->write_pos + frames, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cic_stats.h"
+
+#define TRACE_RING_SIZE                       1024 /* power of two */
+#define TRACE_FLUSH_NS                        50000000
+
+struct cic_trace {
+	FILE *file;
+	pthread_t thread;
+	int exit;
+	unsigned int head;          /* written by the capture thread only */
+	unsigned int tail;          /* written by the trace thread only */
+	cic_trace_record ring[TRACE_RING_SIZE];
+};
+
+/*
+ * Only the pcm creating the page resets it, the others add to the counts
+ * already there. A page of another version, or one still being created,
+ * is sized and reset again.
+ */
+cic_stats *cic_stats_open(const char *shm_name)
+{
+	cic_stats *st;
+	struct stat sb;
+	int fd, create = 1;
+
+	if (!shm_name) {
+		st = calloc(1, sizeof(*st));
+		if (!st)
+			return NULL;
+		cic_stats_reset(st);
+		return st;
+	}
+
+	fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0660);
+	if (fd < 0 && errno == EEXIST) {
+		create = 0;
+		fd = shm_open(shm_name, O_RDWR, 0);
+	}
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &sb) < 0 || ((size_t)sb.st_size != sizeof(*st) && ftruncate(fd, sizeof(*st)) < 0)) {
+		close(fd);
+		return NULL;
+	}
+	st = mmap(NULL, sizeof(*st), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (st == MAP_FAILED)
+		return NULL;
+
+	/* left by another version of the plugin, its users are not counted here */
+	if (st->magic == CIC_STATS_MAGIC && st->version != CIC_STATS_VERSION) {
+		__atomic_store_n(&st->users, 0, __ATOMIC_RELAXED);
+		create = 1;
+	}
+	__atomic_add_fetch(&st->users, 1, __ATOMIC_ACQ_REL);
+	if (create || st->magic != CIC_STATS_MAGIC) {
+		/* left odd by a writer that died in an update */
+		st->seq &= ~1u;
+		cic_stats_reset(st);
+	}
+	return st;
+}
+
+void cic_stats_close(cic_stats *st, const char *shm_name)
+{
+	if (!st)
+		return;
+
+	if (!shm_name) {
+		free(st);
+		return;
+	}
+
+	if (__atomic_sub_fetch(&st->users, 1, __ATOMIC_ACQ_REL) == 0)
+		shm_unlink(shm_name);
+	munmap(st, sizeof(*st));
+}
+
+void cic_stats_reset(cic_stats *st)
+{
+	cic_stats_begin(st);
+	memset(&st->periods, 0, sizeof(*st) - offsetof(cic_stats, periods));
+	st->magic = CIC_STATS_MAGIC;
+	st->version = CIC_STATS_VERSION;
+	st->pid = getpid();
+	cic_stats_end(st);
+}
+
+void cic_stats_time(cic_stats *st, unsigned int which, uint64_t ns)
+{
+	struct cic_stat_time *t = &st->time[which];
+	uint64_t us = ns / 1000;
+	unsigned int b = 0;
+
+	while (us > 0 && b < CIC_STATS_BUCKETS - 1) {
+		us >>= 1;
+		b++;
+	}
+
+	t->count++;
+	t->total_ns += ns;
+	if (ns > t->max_ns)
+		t->max_ns = ns;
+	t->hist[b]++;
+}
+
+int cic_stats_read(const cic_stats *st, cic_stats *copy)
+{
+	unsigned int tries;
+	uint32_t seq;
+
+	for (tries = 0; tries < CIC_STATS_READ_TRIES; tries++) {
+		seq = __atomic_load_n(&st->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+		memcpy(copy, st, sizeof(*copy));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&st->seq, __ATOMIC_RELAXED) == seq)
+			return 0;
+	}
+
+	return -1;
+}
+
+static void trace_drain(cic_trace *tr)
+{
+	unsigned int head = __atomic_load_n(&tr->head, __ATOMIC_ACQUIRE);
+	unsigned int tail = tr->tail;
+	unsigned int n;
+
+	while (tail != head) {
+		/* contiguous part of the ring up to head or its end */
+		n = (head & (TRACE_RING_SIZE - 1)) > (tail & (TRACE_RING_SIZE - 1)) ?
+		    head - tail : TRACE_RING_SIZE - (tail & (TRACE_RING_SIZE - 1));
+		if (fwrite(&tr->ring[tail & (TRACE_RING_SIZE - 1)], sizeof(tr->ring[0]), n, tr->file) != n)
+			fprintf(stderr, "cicFilter: trace write failed: %s\n", strerror(errno));
+		tail += n;
+		__atomic_store_n(&tr->tail, tail, __ATOMIC_RELEASE);
+	}
+	fflush(tr->file);
+}
+
+static void *trace_thread(void *arg)
+{
+	cic_trace *tr = arg;
+	struct timespec ts = { 0, TRACE_FLUSH_NS };
+
+	while (!__atomic_load_n(&tr->exit, __ATOMIC_ACQUIRE)) {
+		trace_drain(tr);
+		nanosleep(&ts, NULL);
+	}
+	trace_drain(tr);
+
+	return NULL;
+}
+
+cic_trace *cic_trace_open(const char *path)
+{
+	cic_trace *tr;
+
+	tr = calloc(1, sizeof(*tr));
+	if (!tr)
+		return NULL;
+
+	tr->file = fopen(path, "wb");
+	if (!tr->file) {
+		free(tr);
+		return NULL;
+	}
+
+	if (pthread_create(&tr->thread, NULL, trace_thread, tr) != 0) {
+		fclose(tr->file);
+		free(tr);
+		return NULL;
+	}
+
+	return tr;
+}
+
+int cic_trace_push(cic_trace *tr, const cic_trace_record *rec)
+{
+	unsigned int tail = __atomic_load_n(&tr->tail, __ATOMIC_ACQUIRE);
+
+	if (tr->head - tail == TRACE_RING_SIZE)
+		return -1;
+
+	tr->ring[tr->head & (TRACE_RING_SIZE - 1)] = *rec;
+	__atomic_store_n(&tr->head, tr->head + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+void cic_trace_close(cic_trace *tr)
+{
+	if (!tr)
+		return;
+
+	__atomic_store_n(&tr->exit, 1, __ATOMIC_RELEASE);
+	pthread_join(tr->thread, NULL);
+	fclose(tr->file);
+	free(tr);
+}
@@ -0,0 +1,134 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file cic_stats.h
+   @brief per period timing, xrun counters and binary trace of cicFilter
+*/
+
+#ifndef CIC_STATS_H
+#define CIC_STATS_H
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CIC_STATS_MAGIC                       0x4d445053 /* "SPDM" */
+#define CIC_STATS_VERSION                     6
+/* bucket b counts times below 2^b us, the last one everything above */
+#define CIC_STATS_BUCKETS                     16
+/* copies cic_stats_read() tries before giving up on a page always in an update */
+#define CIC_STATS_READ_TRIES                  1000
+
+enum {
+	CIC_STAT_READ,              /* snd_pcm_mmap_readi() of the slave */
+	CIC_STAT_DECODE,            /* decoders of every pdm group */
+	CIC_STAT_COPY,              /* mixing, resampling and copy to the app */
+	CIC_STAT_TIMES
+};
+
+struct cic_stat_time {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t hist[CIC_STATS_BUCKETS];
+};
+
+/*
+ * Layout of the shared memory stats page. The plugin makes seq odd while
+ * it updates the page, readers retry until they see the same even seq
+ * before and after their copy. The page is 0660, reset by the pcm which
+ * creates it and removed by the last one to close it.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t seq;
+	uint32_t pid;
+	uint32_t users;             /* pcms with the page open, a reset keeps it */
+	uint32_t reserved0;
+	uint64_t periods;           /* slave periods read */
+	uint64_t discarded;         /* of which discarded while settling */
+	uint64_t xruns;             /* slave overruns */
+	uint64_t recoveries;        /* prepares following an overrun */
+	uint64_t lost_frames;       /* app frames missing after the overruns */
+	uint64_t trace_dropped;     /* records lost on a full trace ring */
+	uint64_t gated;             /* periods with a pdm group skipped by its gate */
+	uint64_t caught_up;         /* slave periods skipped past the catch-up watermark */
+	uint64_t tap_dropped;       /* slave periods lost on a full tap ring */
+	uint32_t tap_request;       /* seconds of raw pdm asked by cicstat -c, cleared once armed */
+	uint32_t reserved;
+	struct cic_stat_time time[CIC_STAT_TIMES];
+} cic_stats;
+
+#define CIC_TRACE_DISCARD                     (1 << 0)
+#define CIC_TRACE_XRUN                        (1 << 1)
+#define CIC_TRACE_GATED                       (1 << 2)
+
+/* One record per slave period in the trace file, host endian. */
+typedef struct {
+	uint64_t tstamp_ns;         /* CLOCK_MONOTONIC at the end of the period */
+	uint32_t time_ns[CIC_STAT_TIMES];
+	uint32_t slave_avail;       /* frames left in the slave after the read */
+	uint32_t flags;
+} cic_trace_record;
+
+typedef struct cic_trace cic_trace;
+
+/* Stats in the named shared memory page, or private ones when name is NULL. */
+cic_stats *cic_stats_open(const char *shm_name);
+
+void cic_stats_close(cic_stats *st, const char *shm_name);
+
+void cic_stats_reset(cic_stats *st);
+
+static inline uint64_t cic_stats_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * A seqlock: the fence keeps the updates after begin from being seen
+ * before the odd seq, the release of end keeps them before the even one.
+ * cic_stats_read() pairs them with acquires.
+ */
+static inline void cic_stats_begin(cic_stats *st)
+{
+	__atomic_add_fetch(&st->seq, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void cic_stats_end(cic_stats *st)
+{
+	__atomic_add_fetch(&st->seq, 1, __ATOMIC_RELEASE);
+}
+
+/* Accounts ns in the histogram of which, between begin and end. */
+void cic_stats_time(cic_stats *st, unsigned int which, uint64_t ns);
+
+/*
+ * Consistent copy of a page updated by another process, -1 when none was
+ * got in CIC_STATS_READ_TRIES tries.
+ */
+int cic_stats_read(const cic_stats *st, cic_stats *copy);
+
+/* Starts the thread appending the pushed records to path. */
+cic_trace *cic_trace_open(const char *path);
+
+/* Never blocks, returns -1 when the ring is full and the record dropped. */
+int cic_trace_push(cic_trace *tr, const cic_trace_record *rec);
+
+void cic_trace_close(cic_trace *tr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* SCHED_IDLE */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "cic_tap.h"
+
+#define TAP_DRAIN_NS                          20000000
+#define TAP_MAX_FILES                         10000
+
+struct cic_tap {
+	char *path;
+	int fd;
+	unsigned int seq;           /* number of the last file written */
+	pthread_t thread;
+	int exit;
+	uint8_t *ring;
+	size_t size;
+	uint64_t head;              /* written by the capture thread only */
+	uint64_t tail;              /* written by the tap thread only */
+	uint64_t remaining;         /* bytes of the capture still to push */
+	int capturing;              /* set when armed, cleared once the file is written */
+	int done;                   /* the last period of the capture was pushed */
+};
+
+/* Creates the first path.N not taken yet, no capture overwrites an earlier one. */
+static int tap_create(cic_tap *tap)
+{
+	char name[PATH_MAX];
+	unsigned int n;
+	int fd = -1;
+
+	for (n = tap->seq + 1; n <= tap->seq + TAP_MAX_FILES; n++) {
+		snprintf(name, sizeof(name), "%s.%u", tap->path, n);
+		fd = open(name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+		if (fd >= 0 || errno != EEXIST)
+			break;
+	}
+	if (fd < 0) {
+		fprintf(stderr, "cicFilter: unable to create the tap %s: %s\n", name, strerror(errno));
+		return open("/dev/null", O_WRONLY | O_CLOEXEC);
+	}
+
+	tap->seq = n;
+	return fd;
+}
+
+/* Writes what the ring holds, in at most two contiguous parts. */
+static void tap_drain(cic_tap *tap)
+{
+	uint64_t head = __atomic_load_n(&tap->head, __ATOMIC_ACQUIRE);
+	uint64_t tail = tap->tail;
+	size_t off, n;
+	ssize_t w;
+
+	while (tail != head) {
+		off = tail % tap->size;
+		n = head - tail < tap->size - off ? head - tail : tap->size - off;
+		w = write(tap->fd, tap->ring + off, n);
+		if (w < 0 && errno == EINTR)
+			continue;
+		/* a full disk only drops the capture, the ring keeps going */
+		if (w <= 0) {
+			fprintf(stderr, "cicFilter: tap write to %s failed: %s\n", tap->path, strerror(errno));
+			w = n;
+		}
+		tail += w;
+		__atomic_store_n(&tap->tail, tail, __ATOMIC_RELEASE);
+	}
+}
+
+static void *tap_thread(void *arg)
+{
+	cic_tap *tap = arg;
+	struct timespec ts = { 0, TAP_DRAIN_NS };
+	struct sched_param sp = { 0 };
+	int done;
+
+	/* only runs when the cpu has nothing else to do */
+	pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp);
+
+	while (!__atomic_load_n(&tap->exit, __ATOMIC_ACQUIRE)) {
+		nanosleep(&ts, NULL);
+		if (!__atomic_load_n(&tap->capturing, __ATOMIC_ACQUIRE))
+			continue;
+
+		if (tap->fd < 0)
+			tap->fd = tap_create(tap);
+
+		/* done is read before the head that holds the last period */
+		done = __atomic_load_n(&tap->done, __ATOMIC_ACQUIRE);
+		tap_drain(tap);
+		if (done && tap->tail == __atomic_load_n(&tap->head, __ATOMIC_ACQUIRE)) {
+			close(tap->fd);
+			tap->fd = -1;
+			__atomic_store_n(&tap->capturing, 0, __ATOMIC_RELEASE);
+		}
+	}
+
+	if (tap->fd >= 0) {
+		tap_drain(tap);
+		close(tap->fd);
+	}
+
+	return NULL;
+}
+
+cic_tap *cic_tap_open(const char *path, size_t ring_size)
+{
+	cic_tap *tap;
+
+	tap = calloc(1, sizeof(*tap));
+	if (!tap)
+		return NULL;
+
+	tap->fd = -1;
+	tap->size = ring_size < CIC_TAP_MIN_RING ? CIC_TAP_MIN_RING : ring_size;
+	tap->path = strdup(path);
+	tap->ring = malloc(tap->size);
+	if (!tap->path || !tap->ring)
+		goto fail;
+	/* touch the ring now, not from the capture thread */
+	memset(tap->ring, 0, tap->size);
+
+	if (pthread_create(&tap->thread, NULL, tap_thread, tap) != 0)
+		goto fail;
+
+	return tap;
+
+fail:
+	free(tap->ring);
+	free(tap->path);
+	free(tap);
+	return NULL;
+}
+
+void cic_tap_close(cic_tap *tap)
+{
+	if (!tap)
+		return;
+
+	__atomic_store_n(&tap->exit, 1, __ATOMIC_RELEASE);
+	pthread_join(tap->thread, NULL);
+	free(tap->ring);
+	free(tap->path);
+	free(tap);
+}
+
+int cic_tap_arm(cic_tap *tap, uint64_t bytes)
+{
+	if (__atomic_load_n(&tap->capturing, __ATOMIC_ACQUIRE) || bytes == 0)
+		return -1;
+
+	tap->remaining = bytes;
+	tap->done = 0;
+	__atomic_store_n(&tap->capturing, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int cic_tap_push(cic_tap *tap, const void *data, size_t bytes)
+{
+	uint64_t tail;
+	size_t off, n;
+
+	if (tap->remaining == 0)
+		return 0;
+
+	/* the capture lasts as long as armed for, dropped periods included */
+	tap->remaining = tap->remaining > bytes ? tap->remaining - bytes : 0;
+
+	tail = __atomic_load_n(&tap->tail, __ATOMIC_ACQUIRE);
+	if (tap->size - (tap->head - tail) < bytes) {
+		if (tap->remaining == 0)
+			__atomic_store_n(&tap->done, 1, __ATOMIC_RELEASE);
+		return -1;
+	}
+
+	off = tap->head % tap->size;
+	n = bytes < tap->size - off ? bytes : tap->size - off;
+	memcpy(tap->ring + off, data, n);
+	memcpy(tap->ring, (const uint8_t *)data + n, bytes - n);
+	__atomic_store_n(&tap->head, tap->head + bytes, __ATOMIC_RELEASE);
+	if (tap->remaining == 0)
+		__atomic_store_n(&tap->done, 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
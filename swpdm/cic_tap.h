@@ -0,0 +1,45 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file cic_tap.h
+   @brief raw pdm tap of cicFilter, written to a file off the capture thread
+*/
+
+#ifndef CIC_TAP_H
+#define CIC_TAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CIC_TAP_MIN_RING                      (256 * 1024)
+
+/*
+ * The capture thread copies every slave period into a ring of fixed size
+ * while a capture is armed, a background thread of idle priority writes
+ * the ring to the file. Nothing is allocated nor blocks once opened: a
+ * period that doesn't fit the ring is dropped and counted.
+ */
+typedef struct cic_tap cic_tap;
+
+/* Ring of ring_size bytes for path, each capture creates a new path.N file. */
+cic_tap *cic_tap_open(const char *path, size_t ring_size);
+
+void cic_tap_close(cic_tap *tap);
+
+/* Captures the next bytes pushed to a new file, -1 while the last one is still written. */
+int cic_tap_arm(cic_tap *tap, uint64_t bytes);
+
+/* Copies one period while armed, returns -1 when it is dropped on a full ring. */
+int cic_tap_push(cic_tap *tap, const void *data, size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Cycles per sample benchmark of the built-in CIC decimator.
+ *
+ * A sine is sigma-delta modulated to DSD_U32_LE, decimated block by block
+ * and fitted back to measure its level and SINAD. The FIR variant of the
+ * cpu must give the samples of the generic one bit for bit. When built
+ * against libimxswpdm the same stream is also run through processAfeCic()
+ * and the two decoders are checked to agree within the given tolerances,
+ * on the level and on the difference of their samples, once aligned.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#ifdef HAVE_IMXSWPDM
+#include <imx-mm/audio-codec/swpdm/imx-swpdm.h>
+#endif
+
+#include "cic_decimator.h"
+#include "pcm_kernels.h"
+
+#define BENCH_TONE_HZ                         1000.0
+#define BENCH_TONE_LEVEL                      0.25
+#define BENCH_SETTLE_BLOCKS                   8
+#define BENCH_MAX_LAG                         64
+
+struct bench_result {
+	double ns_per_sample;
+	double cycles_per_sample;
+	double level_db;
+	double sinad_db;
+};
+
+static int open_cycle_counter(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Second order sigma-delta modulator, one sine per channel. */
+static void modulate(uint32_t *pdm, unsigned int words, unsigned int channels,
+		     unsigned int bit_rate, double *state, uint64_t *t)
+{
+	unsigned int f, ch, b;
+	double x, y;
+	uint32_t w;
+
+	for (f = 0; f < words; f++) {
+		for (ch = 0; ch < channels; ch++) {
+			w = 0;
+			for (b = 0; b < 32; b++) {
+				x = BENCH_TONE_LEVEL * sin(2.0 * M_PI * BENCH_TONE_HZ *
+							   (double)(t[ch] + b) / bit_rate);
+				y = state[2 * ch + 1] >= 0.0 ? 1.0 : -1.0;
+				state[2 * ch] += x - y;
+				state[2 * ch + 1] += state[2 * ch] - y;
+				w = (w << 1) | (y > 0.0);
+			}
+			t[ch] += 32;
+			pdm[f * channels + ch] = w;
+		}
+	}
+}
+
+/* Least squares fit of the tone of channel ch, returns level and SINAD. */
+static void fit_tone(const int32_t *pcm, unsigned int frames, unsigned int channels,
+		     unsigned int ch, unsigned int rate, double *level_db, double *sinad_db)
+{
+	double s, c, x, a = 0, b = 0, dc = 0, amp, err = 0;
+	double w = 2.0 * M_PI * BENCH_TONE_HZ / rate;
+	unsigned int n;
+
+	for (n = 0; n < frames; n++)
+		dc += pcm[n * channels + ch];
+	dc /= frames;
+	for (n = 0; n < frames; n++) {
+		x = pcm[n * channels + ch] - dc;
+		a += x * sin(w * n);
+		b += x * cos(w * n);
+	}
+	a *= 2.0 / frames;
+	b *= 2.0 / frames;
+	for (n = 0; n < frames; n++) {
+		s = a * sin(w * n);
+		c = b * cos(w * n);
+		x = pcm[n * channels + ch] - dc - s - c;
+		err += x * x;
+	}
+	amp = sqrt(a * a + b * b);
+	*level_db = 20.0 * log10(amp / 2147483648.0);
+	*sinad_db = 10.0 * log10((amp * amp / 2.0) / (err / frames + 1e-30));
+}
+
+/*
+ * Power of the difference of the samples of test and ref, both of channels
+ * channels, relative to the one of ref in dB, at the lag of test up to
+ * BENCH_MAX_LAG frames where it is the lowest.
+ */
+static double compare_samples(const int32_t *test, const int32_t *ref, unsigned int frames,
+			      unsigned int channels, int *lag)
+{
+	double d, err, sig = 0, best = INFINITY;
+	unsigned int n, ch;
+	int l;
+
+	for (n = BENCH_MAX_LAG; n < frames - BENCH_MAX_LAG; n++)
+		for (ch = 0; ch < channels; ch++)
+			sig += (double)ref[n * channels + ch] * ref[n * channels + ch];
+
+	for (l = -BENCH_MAX_LAG; l <= BENCH_MAX_LAG; l++) {
+		err = 0;
+		for (n = BENCH_MAX_LAG; n < frames - BENCH_MAX_LAG; n++) {
+			for (ch = 0; ch < channels; ch++) {
+				d = (double)test[(n + l) * channels + ch] - ref[n * channels + ch];
+				err += d * d;
+			}
+		}
+		if (err < best) {
+			best = err;
+			*lag = l;
+		}
+	}
+
+	return 10.0 * log10((best + 1e-30) / (sig + 1e-30));
+}
+
+/* The FIR variant of the cpu, or the generic one. */
+static void run_builtin(unsigned int osr, unsigned int rate, unsigned int channels,
+			unsigned int period, unsigned int blocks, const uint32_t *pdm,
+			int32_t *pcm, int generic, struct bench_result *res)
+{
+	cic_decimator *dec;
+	double gain = (double)(1 << 30) / pow(osr / 4, 5);
+	unsigned int in_words, i;
+	long long cycles = 0;
+	double t0, t = 0;
+	int fd;
+
+	dec = cic_decimator_create(osr, channels, period, gain);
+	if (!dec) {
+		fprintf(stderr, "Unable to create the decimator\n");
+		exit(1);
+	}
+	if (generic)
+		dec->fir_stage = cic_fir_stage_generic;
+	in_words = dec->inputBufferSizePerChannel * channels;
+
+	fd = open_cycle_counter();
+	for (i = 0; i < blocks; i++) {
+		memcpy(dec->inputBuffer, pdm + i * in_words, in_words * sizeof(*pdm));
+		if (fd >= 0)
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		t0 = now_ns();
+		cic_decimator_process(dec);
+		t += now_ns() - t0;
+		if (fd >= 0)
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		memcpy(pcm + i * period * channels, dec->outputBuffer, period * channels * sizeof(*pcm));
+	}
+	if (fd >= 0) {
+		if (read(fd, &cycles, sizeof(cycles)) != sizeof(cycles))
+			cycles = 0;
+		close(fd);
+	}
+
+	res->ns_per_sample = t / ((double)blocks * period * channels);
+	res->cycles_per_sample = cycles / ((double)blocks * period * channels);
+	fit_tone(pcm + BENCH_SETTLE_BLOCKS * period * channels, (blocks - BENCH_SETTLE_BLOCKS) * period,
+		 channels, 0, rate, &res->level_db, &res->sinad_db);
+
+	cic_decimator_destroy(dec);
+}
+
+#ifdef HAVE_IMXSWPDM
+static int run_library(unsigned int osr, unsigned int rate, unsigned int period,
+		       unsigned int blocks, const uint32_t *pdm, int32_t *pcm,
+		       struct bench_result *res)
+{
+	cic_t type;
+	afe_t afe;
+	float gain = (double)(1 << 30) / pow(osr / 4, 5);
+	unsigned int in_words, i;
+	double t0, t = 0;
+
+	switch (osr) {
+	case 48: type = CIC_pdmToPcmType_cic_order_5_cic_downsample_12; break;
+	case 64: type = CIC_pdmToPcmType_cic_order_5_cic_downsample_16; break;
+	case 96: type = CIC_pdmToPcmType_cic_order_5_cic_downsample_24; break;
+	case 128: type = CIC_pdmToPcmType_cic_order_5_cic_downsample_32; break;
+	default: type = CIC_pdmToPcmType_cic_order_5_cic_downsample_48; break;
+	}
+
+	memset(&afe, 0, sizeof(afe));
+	if (!constructAfeCicDecoder(type, &afe, gain, period / 16) ||
+	    afe.outputBufferSizePerChannel != period)
+		return -1;
+	in_words = afe.inputBufferSizePerChannel * 4;
+
+	for (i = 0; i < blocks; i++) {
+		memcpy(afe.inputBuffer, pdm + i * in_words, in_words * sizeof(*pdm));
+		t0 = now_ns();
+		processAfeCic(&afe);
+		t += now_ns() - t0;
+		memcpy(pcm + i * period * 4, afe.outputBuffer, period * 4 * sizeof(*pcm));
+	}
+	deleteAfeCicDecoder(&afe);
+
+	res->ns_per_sample = t / ((double)blocks * period * 4);
+	res->cycles_per_sample = 0;
+	fit_tone(pcm + BENCH_SETTLE_BLOCKS * period * 4, (blocks - BENCH_SETTLE_BLOCKS) * period,
+		 4, 0, rate, &res->level_db, &res->sinad_db);
+	return 0;
+}
+#endif
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-o osr] [-r rate] [-c channels] [-p period] [-n blocks] [-t tolerance_db] [-s min_sinad_db]\n"
+	       "       [-d max_difference_db]\n"
+	       "  without -o and -r every OSR/rate pair of the support table is run\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	static const unsigned int osrs[] = { 48, 64, 96, 128, 192 };
+	static const unsigned int rates[] = { 8000, 16000, 32000, 48000, 64000 };
+	unsigned int osr = 0, rate = 0, channels = 4, period = 256, blocks = 200;
+	double tolerance = 0.5, min_sinad = 50.0, max_diff = -40.0;
+	struct bench_result res, ref;
+	unsigned int i, j, n, words, mismatch;
+	uint32_t *pdm;
+	int32_t *pcm, *pcm_ref;
+	double state[16];
+	uint64_t t[8];
+	int opt, failed = 0;
+
+	while ((opt = getopt(argc, argv, "o:r:c:p:n:t:s:d:h")) != -1) {
+		switch (opt) {
+		case 'o': osr = atoi(optarg); break;
+		case 'r': rate = atoi(optarg); break;
+		case 'c': channels = atoi(optarg); break;
+		case 'p': period = atoi(optarg); break;
+		case 'n': blocks = atoi(optarg); break;
+		case 't': tolerance = atof(optarg); break;
+		case 's': min_sinad = atof(optarg); break;
+		case 'd': max_diff = atof(optarg); break;
+		default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (channels == 0 || channels > 8 || blocks <= BENCH_SETTLE_BLOCKS ||
+	    (blocks - BENCH_SETTLE_BLOCKS) * period <= 2 * BENCH_MAX_LAG) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	printf("FIR stage: %s\n", pcm_kernels_get()->name);
+
+	printf("%-5s %-7s %-4s %12s %12s %10s %10s\n",
+	       "OSR", "rate", "ch", "ns/sample", "cyc/sample", "level dB", "SINAD dB");
+
+	for (i = 0; i < sizeof(osrs) / sizeof(osrs[0]); i++) {
+		for (j = 0; j < sizeof(rates) / sizeof(rates[0]); j++) {
+			if ((osr && osrs[i] != osr) || (rate && rates[j] != rate))
+				continue;
+			/* the PDM clock of the slave is limited to 4.8MHz */
+			if (!rate && rates[j] * osrs[i] > 4800000)
+				continue;
+
+			words = period * osrs[i] / 32 * blocks;
+			pdm = malloc(words * channels * sizeof(*pdm));
+			pcm = malloc(period * blocks * channels * sizeof(*pcm));
+			pcm_ref = malloc(period * blocks * channels * sizeof(*pcm_ref));
+			if (!pdm || !pcm || !pcm_ref)
+				return 1;
+			memset(state, 0, sizeof(state));
+			memset(t, 0, sizeof(t));
+			modulate(pdm, words, channels, rates[j] * osrs[i], state, t);
+
+			run_builtin(osrs[i], rates[j], channels, period, blocks, pdm, pcm, 0, &res);
+			printf("%-5u %-7u %-4u %12.2f %12.2f %10.2f %10.2f\n", osrs[i], rates[j], channels,
+			       res.ns_per_sample, res.cycles_per_sample, res.level_db, res.sinad_db);
+			if (res.sinad_db < min_sinad) {
+				printf("  FAIL: SINAD below %.1f dB\n", min_sinad);
+				failed = 1;
+			}
+
+			run_builtin(osrs[i], rates[j], channels, period, blocks, pdm, pcm_ref, 1, &ref);
+			for (n = 0, mismatch = 0; n < period * blocks * channels; n++)
+				if (pcm[n] != pcm_ref[n])
+					mismatch++;
+			if (mismatch) {
+				printf("  FAIL: %u samples differ from the generic FIR stage\n", mismatch);
+				failed = 1;
+			}
+#ifdef HAVE_IMXSWPDM
+			if (channels == 4) {
+				struct bench_result lib;
+				double diff;
+				int lag = 0;
+				if (run_library(osrs[i], rates[j], period, blocks, pdm, pcm_ref, &lib) == 0) {
+					diff = compare_samples(pcm + BENCH_SETTLE_BLOCKS * period * 4,
+							       pcm_ref + BENCH_SETTLE_BLOCKS * period * 4,
+							       (blocks - BENCH_SETTLE_BLOCKS) * period, 4, &lag);
+					printf("%-5s %-7s %-4s %12.2f %12s %10.2f %10.2f  diff %.2f dB at lag %d\n",
+					       "  lib", "", "", lib.ns_per_sample, "-", lib.level_db, lib.sinad_db,
+					       diff, lag);
+					if (fabs(lib.level_db - res.level_db) > tolerance) {
+						printf("  FAIL: level differs from libimxswpdm by more than %.2f dB\n", tolerance);
+						failed = 1;
+					}
+					if (diff > max_diff) {
+						printf("  FAIL: samples differ from libimxswpdm by more than %.1f dB\n", max_diff);
+						failed = 1;
+					}
+				}
+			}
+#endif
+			free(pdm);
+			free(pcm);
+			free(pcm_ref);
+		}
+	}
+#ifndef HAVE_IMXSWPDM
+	(void)tolerance;
+	(void)max_diff;
+	(void)compare_samples;
+#endif
+
+	return failed;
+}
@@ -0,0 +1,530 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Offline replay of DSD_U32_LE captures through the cicFilter plugin.
+ *
+ * The plugin is opened with a file plugin over the null pcm as its slave,
+ * so every period goes through hw_params, sw_params, transfer and pointer
+ * like on the imxswpdmaudio card, only as fast as the cpu decodes it. The
+ * capture is either a recorded file or, without one, a tone modulated
+ * with sdm_modulator for every combination run. For each of them the time
+ * and cycles spent in snd_pcm_readi() per app period, the decode time per
+ * slave period from the stats page of the plugin, the speed relative to
+ * real time and a checksum of the decoded frames are printed.
+ *
+ * With -R the plugin runs in its rt mode and the heap functions of glibc
+ * are wrapped: a run fails when the plugin allocates or frees anything
+ * in snd_pcm_readi() after the first period.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <math.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <alsa/asoundlib.h>
+
+#include "cic_stats.h"
+#include "pdm_rates.h"
+#include "sdm_modulator.h"
+
+#define ARRAY_SIZE(ary)                       (sizeof(ary)/sizeof(ary[0]))
+
+#define REPLAY_PCM                            "cicreplay"
+#define REPLAY_SLAVE                          "cicreplay_slave"
+#define REPLAY_PERIODS                        4
+#define REPLAY_TONE_HZ                        1000.0
+#define REPLAY_TONE_STEP_HZ                   100.0
+#define REPLAY_TONE_LEVEL                     0.25
+#define REPLAY_BLOCK                          256
+#define MAX_CHANNELS                          8
+
+struct replay_opts {
+	const char *lib;
+	const char *decoder;
+	const char *input;
+	unsigned int slave_channels;    /* of the input file */
+	unsigned int period;
+	unsigned int seconds;
+	int delay_us;                   /* -1 for the default of the plugin */
+	int rt;
+	int quiet;
+};
+
+struct replay_result {
+	snd_pcm_uframes_t frames;
+	unsigned int periods;
+	double ns_per_period;
+	double max_ns_per_period;
+	double cycles_per_period;
+	double decode_us;               /* per slave period */
+	double realtime;
+	uint64_t checksum;
+	unsigned long heap_calls;       /* in snd_pcm_readi(), with -R */
+};
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static volatile int heap_watch;
+static unsigned long heap_calls;
+
+/* The plugin is loaded by the application, its heap calls resolve to these. */
+static void heap_call(void)
+{
+	if (heap_watch)
+		__atomic_add_fetch(&heap_calls, 1, __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size)
+{
+	heap_call();
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	heap_call();
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	heap_call();
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	if (ptr)
+		heap_call();
+	__libc_free(ptr);
+}
+#else
+static volatile int heap_watch;
+static unsigned long heap_calls;
+#endif
+
+static int open_cycle_counter(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* 64 bit FNV-1a, chained over every period read. */
+static uint64_t checksum(uint64_t h, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+
+	while (size--) {
+		h ^= *p++;
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+/* Writes seconds of one tone per slave channel modulated at osr. */
+static int synthesize(int fd, unsigned int osr, unsigned int rate,
+		      unsigned int channels, unsigned int seconds)
+{
+	sdm_modulator *mod;
+	unsigned int blocks, b, n, ch;
+	size_t size;
+	double w;
+	int err = 0;
+
+	mod = sdm_modulator_create(osr, channels, REPLAY_BLOCK, 1.0f);
+	if (!mod)
+		return -ENOMEM;
+
+	size = (size_t)mod->outputBufferSizePerChannel * channels * sizeof(uint32_t);
+	blocks = (rate * seconds + REPLAY_BLOCK - 1) / REPLAY_BLOCK;
+	for (b = 0; b < blocks && !err; b++) {
+		for (n = 0; n < REPLAY_BLOCK; n++) {
+			for (ch = 0; ch < channels; ch++) {
+				w = 2.0 * M_PI * (REPLAY_TONE_HZ + ch * REPLAY_TONE_STEP_HZ) / rate;
+				mod->inputBuffer[n * channels + ch] = REPLAY_TONE_LEVEL * 2147483647.0 *
+					sin(w * ((double)b * REPLAY_BLOCK + n));
+			}
+		}
+		sdm_modulator_process(mod);
+		if (write(fd, mod->outputBuffer, size) != (ssize_t)size)
+			err = -errno;
+	}
+
+	sdm_modulator_destroy(mod);
+	return err;
+}
+
+static void drop_config(const char *key)
+{
+	snd_config_t *node;
+
+	if (snd_config_search(snd_config, key, &node) == 0)
+		snd_config_delete(node);
+}
+
+/* Defines the replay pcm and its slave in the global configuration. */
+static int load_config(const struct replay_opts *opts, const char *input,
+		       unsigned int osr, const char *stats_shm)
+{
+	char text[1024], delay[32] = "";
+	snd_input_t *in;
+	int err, len;
+
+	err = snd_config_update();
+	if (err < 0)
+		return err;
+	drop_config("pcm." REPLAY_PCM);
+	drop_config("pcm." REPLAY_SLAVE);
+
+	if (opts->delay_us >= 0)
+		snprintf(delay, sizeof(delay), "delay %d", opts->delay_us);
+
+	len = snprintf(text, sizeof(text),
+		       "pcm." REPLAY_SLAVE " {\n"
+		       "	type file\n"
+		       "	slave.pcm null\n"
+		       "	file \"/dev/null\"\n"
+		       "	infile \"%s\"\n"
+		       "	format raw\n"
+		       "}\n"
+		       "pcm." REPLAY_PCM " {\n"
+		       "	type cicFilter\n"
+		       "	slave \"" REPLAY_SLAVE "\"\n"
+		       "	OSR %u\n"
+		       "	decoder \"%s\"\n"
+		       "	stats_shm \"%s\"\n"
+		       "	caps_cache false\n"
+		       "	rt %s\n"
+		       "	%s\n"
+		       "}\n",
+		       input, osr, opts->decoder, stats_shm, opts->rt ? "true" : "false", delay);
+	if (opts->lib)
+		len += snprintf(text + len, sizeof(text) - len,
+				"pcm_type.cicFilter.lib \"%s\"\n", opts->lib);
+	if (len >= (int)sizeof(text))
+		return -ENAMETOOLONG;
+
+	err = snd_input_buffer_open(&in, text, len);
+	if (err < 0)
+		return err;
+	err = snd_config_load(snd_config, in);
+	snd_input_close(in);
+
+	return err;
+}
+
+static int set_params(snd_pcm_t *pcm, unsigned int rate, unsigned int channels,
+		      snd_pcm_uframes_t period)
+{
+	snd_pcm_hw_params_t *params;
+	snd_pcm_uframes_t buffer = period * REPLAY_PERIODS;
+	int err;
+
+	snd_pcm_hw_params_alloca(&params);
+	err = snd_pcm_hw_params_any(pcm, params);
+	if (err < 0)
+		return err;
+	err = snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_RW_INTERLEAVED);
+	if (err < 0)
+		return err;
+	err = snd_pcm_hw_params_set_format(pcm, params, SND_PCM_FORMAT_S32_LE);
+	if (err < 0)
+		return err;
+	err = snd_pcm_hw_params_set_channels(pcm, params, channels);
+	if (err < 0)
+		return err;
+	err = snd_pcm_hw_params_set_rate(pcm, params, rate, 0);
+	if (err < 0)
+		return err;
+	err = snd_pcm_hw_params_set_period_size(pcm, params, period, 0);
+	if (err < 0)
+		return err;
+	err = snd_pcm_hw_params_set_buffer_size_near(pcm, params, &buffer);
+	if (err < 0)
+		return err;
+
+	return snd_pcm_hw_params(pcm, params);
+}
+
+/* Decode time per slave period, from the stats page of the plugin. */
+static double decode_us(const char *stats_shm)
+{
+	const cic_stats *st;
+	cic_stats copy;
+	int fd;
+
+	fd = shm_open(stats_shm, O_RDONLY, 0);
+	if (fd < 0)
+		return 0;
+	st = mmap(NULL, sizeof(*st), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (st == MAP_FAILED)
+		return 0;
+	if (cic_stats_read(st, &copy) < 0)
+		copy.magic = 0;
+	munmap((void *)st, sizeof(*st));
+
+	if (copy.magic != CIC_STATS_MAGIC || copy.time[CIC_STAT_DECODE].count == 0)
+		return 0;
+
+	return copy.time[CIC_STAT_DECODE].total_ns / 1000.0 / copy.time[CIC_STAT_DECODE].count;
+}
+
+static int replay(const struct replay_opts *opts, const char *input, size_t input_size,
+		  unsigned int osr, unsigned int rate, unsigned int channels,
+		  unsigned int slave_channels, struct replay_result *res)
+{
+	unsigned int dec_rate = pdm_pcm_rate(osr, rate);
+	unsigned int period = opts->period;
+	char stats_shm[64];
+	snd_pcm_t *pcm;
+	int32_t *buf;
+	long long cycles = 0;
+	double pdm_frames, t0, t, total = 0;
+	snd_pcm_sframes_t n;
+	int fd, err;
+
+	/* frames the input holds at the app rate, less the resampler and block carry */
+	pdm_frames = (double)input_size / (slave_channels * sizeof(uint32_t)) * 32 / osr;
+	res->frames = pdm_frames * rate / dec_rate;
+	res->frames = res->frames > 2 * period ? (res->frames / period - 2) * period : 0;
+	if (res->frames == 0)
+		return -ENODATA;
+
+	snprintf(stats_shm, sizeof(stats_shm), "/cicreplay-%d", getpid());
+	err = load_config(opts, input, osr, stats_shm);
+	if (err < 0)
+		return err;
+
+	err = snd_pcm_open(&pcm, REPLAY_PCM, SND_PCM_STREAM_CAPTURE, 0);
+	if (err < 0)
+		return err;
+	err = set_params(pcm, rate, channels, period);
+	if (err < 0)
+		goto out;
+
+	buf = malloc((size_t)period * channels * sizeof(*buf));
+	if (!buf) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	res->checksum = 0xcbf29ce484222325ULL;
+	heap_calls = 0;
+	fd = open_cycle_counter();
+	while (res->periods * period < res->frames) {
+		if (fd >= 0)
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		/* the first period starts the slave */
+		heap_watch = opts->rt && res->periods > 0;
+		t0 = now_ns();
+		n = snd_pcm_readi(pcm, buf, period);
+		t = now_ns() - t0;
+		heap_watch = 0;
+		if (fd >= 0)
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (n < 0) {
+			err = n;
+			break;
+		}
+		res->checksum = checksum(res->checksum, buf, (size_t)n * channels * sizeof(*buf));
+		total += t;
+		if (t > res->max_ns_per_period)
+			res->max_ns_per_period = t;
+		res->periods++;
+	}
+	if (fd >= 0) {
+		if (read(fd, &cycles, sizeof(cycles)) != sizeof(cycles))
+			cycles = 0;
+		close(fd);
+	}
+
+	if (res->periods != 0) {
+		res->ns_per_period = total / res->periods;
+		res->cycles_per_period = (double)cycles / res->periods;
+		res->realtime = (double)res->periods * period / rate * 1e9 / total;
+	}
+	res->decode_us = decode_us(stats_shm);
+	res->heap_calls = heap_calls;
+	free(buf);
+out:
+	snd_pcm_close(pcm);
+	return err;
+}
+
+/* Runs one combination on the input file, or on a tone synthesized for it. */
+static int run(const struct replay_opts *opts, unsigned int osr, unsigned int rate,
+	       unsigned int channels)
+{
+	unsigned int slave_channels = channels > 4 ? 8 : 4;
+	char path[] = "/tmp/cicreplay-XXXXXX";
+	const char *input = opts->input;
+	struct replay_result res;
+	struct stat st;
+	int fd = -1, err;
+
+	if (input) {
+		slave_channels = opts->slave_channels;
+	} else {
+		fd = mkstemp(path);
+		if (fd < 0)
+			return -errno;
+		unlink(path);
+		err = synthesize(fd, osr, pdm_pcm_rate(osr, rate), slave_channels, opts->seconds);
+		if (err < 0) {
+			close(fd);
+			return err;
+		}
+		/* the file plugin opens it by name, keep it alive through the fd */
+		snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+		input = path;
+	}
+
+	if (stat(input, &st) < 0) {
+		err = -errno;
+	} else {
+		memset(&res, 0, sizeof(res));
+		err = replay(opts, input, st.st_size, osr, rate, channels, slave_channels, &res);
+	}
+	if (fd >= 0)
+		close(fd);
+
+	if (err < 0) {
+		printf("%-5u %-7u %-4u FAIL: %s\n", osr, rate, channels, snd_strerror(err));
+		return err;
+	}
+	if (res.heap_calls) {
+		printf("%-5u %-7u %-4u FAIL: %lu heap calls in snd_pcm_readi()\n",
+		       osr, rate, channels, res.heap_calls);
+		return -EFAULT;
+	}
+
+	if (opts->quiet)
+		printf("%u %u %u %016llx\n", osr, rate, channels, (unsigned long long)res.checksum);
+	else
+		printf("%-5u %-7u %-4u %8u %10.1f %10.1f %12.0f %10.1f %8.1f  %016llx\n",
+		       osr, rate, channels, res.periods, res.ns_per_period / 1000,
+		       res.max_ns_per_period / 1000, res.cycles_per_period, res.decode_us,
+		       res.realtime, (unsigned long long)res.checksum);
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-o osr] [-r rate] [-c channels] [-p period] [-n seconds] [-D delay_us]\n"
+	       "          [-d imx|builtin] [-l plugin.so] [-s slave_channels] [-R] [-q] [capture.dsd]\n"
+	       "  capture.dsd is raw DSD_U32_LE at OSR with slave_channels (4 by default),\n"
+	       "  without it a tone is modulated for every run. Without -o, -r or -c every\n"
+	       "  OSR, rate or channel count accepted by the plugin is run. -q only prints\n"
+	       "  the checksums, to diff against the ones of a previous build. -R runs the\n"
+	       "  plugin in rt mode and fails on any heap call while it reads.\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	static const unsigned int osrs[] = { 48, 64, 96, 128, 192 };
+	/* the rates of constrains() in swpdm.c */
+	static const unsigned int rates[] = {
+		8000, 11025, 16000, 22050, 24000,
+		32000, 44100, 48000, 64000, 88200,
+		96000
+	};
+	struct replay_opts opts = {
+		.decoder = "builtin",
+		.slave_channels = 4,
+		.period = 256,
+		.seconds = 1,
+		.delay_us = -1,
+	};
+	unsigned int osr = 0, rate = 0, channels = 0, min_channels = 1, max_channels = MAX_CHANNELS;
+	unsigned int i, j, c;
+	int opt, failed = 0;
+
+	while ((opt = getopt(argc, argv, "o:r:c:p:n:D:d:l:s:Rqh")) != -1) {
+		switch (opt) {
+		case 'o': osr = atoi(optarg); break;
+		case 'r': rate = atoi(optarg); break;
+		case 'c': channels = atoi(optarg); break;
+		case 'p': opts.period = atoi(optarg); break;
+		case 'n': opts.seconds = atoi(optarg); break;
+		case 'D': opts.delay_us = atoi(optarg); break;
+		case 'd': opts.decoder = optarg; break;
+		case 'l': opts.lib = optarg; break;
+		case 's': opts.slave_channels = atoi(optarg); break;
+		case 'R': opts.rt = 1; break;
+		case 'q': opts.quiet = 1; break;
+		default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (optind < argc)
+		opts.input = argv[optind];
+
+	if (opts.period == 0 || opts.seconds == 0 || channels > MAX_CHANNELS ||
+	    (opts.slave_channels != 4 && opts.slave_channels != 8)) {
+		usage(argv[0]);
+		return 1;
+	}
+	/* a recorded capture is at a single OSR */
+	if (opts.input && osr == 0)
+		osr = 64;
+	/* and its slave channels are opened for 1 to 4 or 5 to 8 channels */
+	if (opts.input) {
+		min_channels = opts.slave_channels == 8 ? 5 : 1;
+		max_channels = opts.slave_channels;
+	}
+
+	if (!opts.quiet)
+		printf("%-5s %-7s %-4s %8s %10s %10s %12s %10s %8s  %-16s\n",
+		       "OSR", "rate", "ch", "periods", "us/period", "max us", "cyc/period",
+		       "decode us", "x rt", "checksum");
+
+	for (i = 0; i < ARRAY_SIZE(osrs); i++) {
+		if (osr && osrs[i] != osr)
+			continue;
+		for (j = 0; j < ARRAY_SIZE(rates); j++) {
+			if (rate && rates[j] != rate)
+				continue;
+			for (c = min_channels; c <= max_channels; c++) {
+				if (channels && c != channels)
+					continue;
+				if (run(&opts, osrs[i], rates[j], c) < 0)
+					failed = 1;
+			}
+		}
+	}
+
+	return failed;
+}
@@ -0,0 +1,183 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Reader of the cicFilter statistics.
+ *
+ * Prints the shared memory stats page given with the stats_shm option of
+ * the plugin, once or every interval, or the records of a trace file
+ * written with the trace_file option as text. With -c it asks the plugin
+ * to write that many seconds of raw pdm to its tap_file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "cic_stats.h"
+
+static const char *names[CIC_STAT_TIMES] = { "read", "decode", "copy" };
+
+static void print_stats(const cic_stats *st)
+{
+	const struct cic_stat_time *t;
+	unsigned int i, b;
+
+	printf("pid %u: %llu periods (%llu discarded, %llu gated, %llu skipped), %llu xruns (%llu recovered, "
+	       "%llu frames lost), %llu trace records dropped, %llu tap periods dropped\n",
+	       st->pid, (unsigned long long)st->periods, (unsigned long long)st->discarded,
+	       (unsigned long long)st->gated, (unsigned long long)st->caught_up, (unsigned long long)st->xruns,
+	       (unsigned long long)st->recoveries, (unsigned long long)st->lost_frames,
+	       (unsigned long long)st->trace_dropped, (unsigned long long)st->tap_dropped);
+
+	for (i = 0; i < CIC_STAT_TIMES; i++) {
+		t = &st->time[i];
+		if (t->count == 0)
+			continue;
+		printf("  %-8s avg %6llu us max %6llu us, <us:", names[i],
+		       (unsigned long long)(t->total_ns / t->count / 1000),
+		       (unsigned long long)(t->max_ns / 1000));
+		for (b = 0; b < CIC_STATS_BUCKETS; b++)
+			if (t->hist[b] != 0)
+				printf(" %u:%llu", 1u << b, (unsigned long long)t->hist[b]);
+		printf("\n");
+	}
+}
+
+static int watch_shm(const char *name, unsigned int interval)
+{
+	const cic_stats *st;
+	cic_stats copy;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		perror(name);
+		return 1;
+	}
+	st = mmap(NULL, sizeof(*st), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (st == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	for (;;) {
+		if (cic_stats_read(st, &copy) < 0) {
+			fprintf(stderr, "%s: no consistent copy in %d tries, a writer may be stuck\n", name,
+				CIC_STATS_READ_TRIES);
+			if (interval == 0)
+				return 1;
+			sleep(interval);
+			continue;
+		}
+		if (copy.magic != CIC_STATS_MAGIC || copy.version != CIC_STATS_VERSION) {
+			fprintf(stderr, "%s is not a cicFilter stats page\n", name);
+			return 1;
+		}
+		print_stats(&copy);
+		if (interval == 0)
+			break;
+		sleep(interval);
+	}
+
+	return 0;
+}
+
+/* The plugin arms its tap on the next slave period. */
+static int request_tap(const char *name, unsigned int seconds)
+{
+	cic_stats *st;
+	int fd, ret = 0;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0) {
+		perror(name);
+		return 1;
+	}
+	st = mmap(NULL, sizeof(*st), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (st == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	if (st->magic != CIC_STATS_MAGIC || st->version != CIC_STATS_VERSION) {
+		fprintf(stderr, "%s is not a cicFilter stats page\n", name);
+		ret = 1;
+	} else {
+		__atomic_store_n(&st->tap_request, seconds, __ATOMIC_RELEASE);
+	}
+	munmap(st, sizeof(*st));
+
+	return ret;
+}
+
+static int print_trace(const char *path)
+{
+	cic_trace_record rec;
+	uint64_t start = 0;
+	FILE *f;
+
+	f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+
+	printf("%12s %10s %10s %10s %8s %s\n", "time us", "read us", "decode us", "copy us", "avail", "flags");
+	while (fread(&rec, sizeof(rec), 1, f) == 1) {
+		if (start == 0)
+			start = rec.tstamp_ns;
+		printf("%12llu %10u %10u %10u %8u %s%s%s\n",
+		       (unsigned long long)((rec.tstamp_ns - start) / 1000),
+		       rec.time_ns[CIC_STAT_READ] / 1000, rec.time_ns[CIC_STAT_DECODE] / 1000,
+		       rec.time_ns[CIC_STAT_COPY] / 1000, rec.slave_avail,
+		       rec.flags & CIC_TRACE_DISCARD ? "discard " : "",
+		       rec.flags & CIC_TRACE_GATED ? "gated " : "",
+		       rec.flags & CIC_TRACE_XRUN ? "xrun" : "");
+	}
+	fclose(f);
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-i interval_s] /shm-name\n"
+	       "       %s -c seconds /shm-name\n"
+	       "       %s -t trace_file\n", name, name, name);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int interval = 0, tap = 0;
+	const char *trace = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:i:t:h")) != -1) {
+		switch (opt) {
+		case 'c': tap = atoi(optarg); break;
+		case 'i': interval = atoi(optarg); break;
+		case 't': trace = optarg; break;
+		default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (trace)
+		return print_trace(trace);
+
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (tap)
+		return request_tap(argv[optind], tap);
+
+	return watch_shm(argv[optind], interval);
+}
@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "pcm_resampler.h"
+
+#define RESAMPLER_TAPS                        24
+#define RESAMPLER_KAISER_BETA                 8.0
+#define RESAMPLER_BANDWIDTH                   0.9
+
+#define S32_FULL_SCALE                        2147483648.0f
+#define S32_MAX_FLOAT                         2147483520.0f
+
+static uint32_t get_max_divider(uint32_t x, uint32_t y)
+{
+	uint32_t t;
+
+	while (y != 0) {
+		t = x % y;
+		x = y;
+		y = t;
+	}
+
+	return x;
+}
+
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 32; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+/*
+ * Kaiser windowed sinc at the lowest of both Nyquist rates, designed at
+ * up * in_rate and split in up phases of taps coefficients.
+ */
+static void design_phases(pcm_resampler *rs)
+{
+	unsigned int len = rs->up * rs->taps;
+	unsigned int max = rs->up > rs->down ? rs->up : rs->down;
+	double fc = RESAMPLER_BANDWIDTH * 0.5 / max;
+	double c = (len - 1) / 2.0;
+	double t, w, h, sum = 0.0;
+	unsigned int n, ph, i;
+
+	for (n = 0; n < len; n++) {
+		t = n - c;
+		h = t == 0.0 ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+		w = 2.0 * n / (len - 1) - 1.0;
+		h *= bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - w * w)) / bessel_i0(RESAMPLER_KAISER_BETA);
+		/* phase ph holds h[ph + j * up] reversed, see pcm_resampler_process() */
+		ph = n % rs->up;
+		i = rs->taps - 1 - n / rs->up;
+		rs->coefs[ph * rs->taps + i] = (float)h;
+		sum += h;
+	}
+
+	for (n = 0; n < len; n++)
+		rs->coefs[n] = (float)(rs->coefs[n] * rs->up / sum);
+}
+
+pcm_resampler *pcm_resampler_create(unsigned int channels, unsigned int in_rate,
+		unsigned int out_rate, unsigned int in_frames)
+{
+	pcm_resampler *rs;
+	uint32_t div;
+
+	if (channels == 0 || in_rate == 0 || out_rate == 0)
+		return NULL;
+
+	div = get_max_divider(in_rate, out_rate);
+	if (((uint64_t)in_frames * (out_rate / div)) % (in_rate / div)) {
+		fprintf(stderr, "%s: %u frames can't be resampled from %u to %u\n",
+			__func__, in_frames, in_rate, out_rate);
+		return NULL;
+	}
+
+	rs = calloc(1, sizeof(*rs));
+	if (!rs)
+		return NULL;
+
+	rs->channels = channels;
+	rs->up = out_rate / div;
+	rs->down = in_rate / div;
+	rs->taps = RESAMPLER_TAPS;
+	rs->in_frames = in_frames;
+	rs->out_frames = (uint64_t)in_frames * rs->up / rs->down;
+
+	rs->coefs = malloc(rs->up * rs->taps * sizeof(*rs->coefs));
+	rs->history = malloc((rs->taps - 1 + in_frames) * channels * sizeof(*rs->history));
+	if (!rs->coefs || !rs->history) {
+		pcm_resampler_destroy(rs);
+		return NULL;
+	}
+
+	design_phases(rs);
+	pcm_resampler_reset(rs);
+
+	return rs;
+}
+
+void pcm_resampler_destroy(pcm_resampler *rs)
+{
+	if (!rs)
+		return;
+
+	free(rs->coefs);
+	free(rs->history);
+	free(rs);
+}
+
+void pcm_resampler_reset(pcm_resampler *rs)
+{
+	memset(rs->history, 0, (rs->taps - 1) * rs->channels * sizeof(*rs->history));
+}
+
+double pcm_resampler_delay(const pcm_resampler *rs)
+{
+	return (rs->up * rs->taps - 1) / 2.0 / rs->down;
+}
+
+static inline int32_t to_s32(float v)
+{
+	v *= S32_FULL_SCALE;
+	if (v > S32_MAX_FLOAT)
+		v = S32_MAX_FLOAT;
+	else if (v < -S32_FULL_SCALE)
+		v = -S32_FULL_SCALE;
+	return (int32_t)lrintf(v);
+}
+
+void pcm_resampler_process(pcm_resampler *rs, const int32_t *in, int32_t *out)
+{
+	unsigned int channels = rs->channels;
+	float *x = rs->history + (rs->taps - 1) * channels;
+	const float *c, *p;
+	unsigned int k, ch, i, pos = 0;
+	float a0, a1, a2, a3;
+
+	for (i = 0; i < rs->in_frames * channels; i++)
+		x[i] = in[i] * (1.0f / S32_FULL_SCALE);
+
+	/* the block holds a whole number of periods of the phase sequence */
+	for (k = 0; k < rs->out_frames; k++, pos += rs->down, out += channels) {
+		x = rs->history + (pos / rs->up) * channels;
+		c = rs->coefs + (pos % rs->up) * rs->taps;
+
+		for (ch = 0; ch + 4 <= channels; ch += 4) {
+			a0 = a1 = a2 = a3 = 0.0f;
+			for (i = 0, p = x + ch; i < rs->taps; i++, p += channels) {
+				a0 += c[i] * p[0];
+				a1 += c[i] * p[1];
+				a2 += c[i] * p[2];
+				a3 += c[i] * p[3];
+			}
+			out[ch] = to_s32(a0);
+			out[ch + 1] = to_s32(a1);
+			out[ch + 2] = to_s32(a2);
+			out[ch + 3] = to_s32(a3);
+		}
+		for (; ch < channels; ch++) {
+			a0 = 0.0f;
+			for (i = 0, p = x + ch; i < rs->taps; i++, p += channels)
+				a0 += c[i] * p[0];
+			out[ch] = to_s32(a0);
+		}
+	}
+
+	memmove(rs->history, rs->history + rs->in_frames * channels,
+		(rs->taps - 1) * channels * sizeof(*rs->history));
+}
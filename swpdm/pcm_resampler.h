@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file pcm_resampler.h
+   @brief polyphase rational resampler for the decoded S32 stream
+*/
+
+#ifndef PCM_RESAMPLER_H
+#define PCM_RESAMPLER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	unsigned int channels;
+	unsigned int up;            /* interpolation L */
+	unsigned int down;          /* decimation M */
+	unsigned int taps;          /* taps of every phase */
+	float *coefs;               /* up * taps, one reversed kernel per phase */
+	float *history;             /* interleaved history + block of input */
+	unsigned int in_frames;
+	unsigned int out_frames;
+} pcm_resampler;
+
+pcm_resampler *pcm_resampler_create(unsigned int channels, unsigned int in_rate,
+		unsigned int out_rate, unsigned int in_frames);
+
+void pcm_resampler_destroy(pcm_resampler *rs);
+
+void pcm_resampler_reset(pcm_resampler *rs);
+
+/* Converts in_frames of in to out_frames of out, both S32 interleaved. */
+void pcm_resampler_process(pcm_resampler *rs, const int32_t *in, int32_t *out);
+
+/* Group delay of the resampler, in output frames. */
+double pcm_resampler_delay(const pcm_resampler *rs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
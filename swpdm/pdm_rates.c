@@ -0,0 +1,86 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stddef.h>
+
+#include "pdm_rates.h"
+
+#define ARRAY_SIZE(ary)                       (sizeof(ary)/sizeof(ary[0]))
+
+/* Rates decoded natively at each OSR, see the table in doc/swpdm.txt. */
+static const struct {
+	unsigned int osr;
+	unsigned int rates[8];
+} osr_rates[] = {
+	{ 48,  { 8000, 16000, 32000, 64000 } },
+	{ 64,  { 8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000 } },
+	{ 96,  { 8000, 16000, 32000 } },
+	{ 128, { 8000, 11025, 16000, 22050, 24000 } },
+	{ 192, { 8000, 16000 } },
+};
+
+static const unsigned int *osr_table(unsigned int osr)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(osr_rates); i++)
+		if (osr_rates[i].osr == osr)
+			return osr_rates[i].rates;
+
+	return NULL;
+}
+
+unsigned int pdm_pcm_rate(unsigned int osr, unsigned int rate)
+{
+	return pdm_pcm_rate_mask(osr, rate, ~0u);
+}
+
+unsigned int pdm_pcm_rate_mask(unsigned int osr, unsigned int rate, unsigned int mask)
+{
+	const unsigned int *rates = osr_table(osr);
+	unsigned int i, r, best = 0;
+
+	if (!rates)
+		return 0;
+
+	for (i = 0; i < ARRAY_SIZE(osr_rates[0].rates) && rates[i]; i++) {
+		if (!(mask & (1u << i)))
+			continue;
+		r = rates[i];
+		if (r == rate)
+			return r;
+		if (best == 0 ||
+		    (r > rate && (best < rate || r < best)) ||
+		    (r < rate && best < rate && r > best))
+			best = r;
+	}
+
+	return best;
+}
+
+unsigned int pdm_slave_rate(unsigned int osr, unsigned int pcm_rate)
+{
+	if (!osr_table(osr))
+		return 0;
+
+	/* 32 pdm bits per DSD_U32 word */
+	return pcm_rate * osr / 32;
+}
+
+unsigned int pdm_native_rates(unsigned int osr, unsigned int *rates, unsigned int size)
+{
+	const unsigned int *table = osr_table(osr);
+	unsigned int n = 0;
+
+	if (!table)
+		return 0;
+
+	while (n < size && n < ARRAY_SIZE(osr_rates[0].rates) && table[n]) {
+		rates[n] = table[n];
+		n++;
+	}
+
+	return n;
+}
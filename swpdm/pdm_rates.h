@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file pdm_rates.h
+   @brief pcm rates carried natively by the pdm slave at every OSR
+*/
+
+#ifndef PDM_RATES_H
+#define PDM_RATES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The rate natively supported at OSR closest to rate: rate itself when
+ * supported, otherwise the closest one above it, or below it when there is
+ * none. Returns 0 for an unknown OSR.
+ */
+unsigned int pdm_pcm_rate(unsigned int osr, unsigned int rate);
+
+/* Same among the native rates whose index in pdm_native_rates() is set in mask. */
+unsigned int pdm_pcm_rate_mask(unsigned int osr, unsigned int rate, unsigned int mask);
+
+/* Frame rate of the DSD_U32_LE slave carrying pcm_rate at OSR, 0 if unknown. */
+unsigned int pdm_slave_rate(unsigned int osr, unsigned int pcm_rate);
+
+/* Fills rates with the native rates of OSR, returns their count. */
+unsigned int pdm_native_rates(unsigned int osr, unsigned int *rates, unsigned int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
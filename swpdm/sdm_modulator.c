@@ -0,0 +1,241 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "sdm_modulator.h"
+#include "pcm_kernels.h"
+
+#define SDM_FIR_TAPS                          96
+#define SDM_FIR_KAISER_BETA                   8.0
+/* Modulator input at pcm full scale, well inside the stable range of the loop. */
+#define SDM_FULL_SCALE                        0.7f
+#define S32_FULL_SCALE                        2147483648.0f
+
+/*
+ * The pcm is interpolated by 4 with a Kaiser windowed FIR, then linearly
+ * up to the bit rate, OSR / 4 more, where the images left are far out of
+ * band. The second order modulator runs on two integrators and a one bit
+ * quantizer per channel, its quantization noise is shaped by (1 - z^-1)^2
+ * out of the audio band. The PDM words are DSD_U32_LE: the oldest bit is
+ * the MSB of the word, as read by cic_decimator.c.
+ */
+
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 32; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+/* Low pass at the input Nyquist rate, split in one reversed kernel per phase. */
+static void design_fir(float *coefs, unsigned int taps)
+{
+	const unsigned int len = taps * SDM_FIR_INTERPOLATION;
+	const double fc = 0.5 / SDM_FIR_INTERPOLATION;
+	double h, t, w, sum = 0.0;
+	unsigned int n, p, i;
+
+	for (n = 0; n < len; n++) {
+		t = n - (len - 1) / 2.0;
+		h = t == 0.0 ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+		w = 2.0 * n / (len - 1) - 1.0;
+		h *= bessel_i0(SDM_FIR_KAISER_BETA * sqrt(1.0 - w * w)) / bessel_i0(SDM_FIR_KAISER_BETA);
+		sum += h;
+
+		p = n % SDM_FIR_INTERPOLATION;
+		i = taps - 1 - n / SDM_FIR_INTERPOLATION;
+		coefs[p * taps + i] = (float)h;
+	}
+
+	/* unity gain of every phase */
+	for (n = 0; n < len; n++)
+		coefs[n] = (float)(coefs[n] * SDM_FIR_INTERPOLATION / sum);
+}
+
+/* The modulator of the kernels of the cpu, the generic one when not built. */
+static sdm_modulator_stage modulator_stage_for(const char *name)
+{
+	sdm_modulator_stage fn = NULL;
+
+	if (strcmp(name, "neon") == 0)
+		fn = sdm_modulator_stage_neon();
+	else if (strcmp(name, "avx2") == 0)
+		fn = sdm_modulator_stage_avx2();
+
+	return fn ? fn : sdm_modulator_stage_generic;
+}
+
+sdm_modulator *sdm_modulator_create(unsigned int osr, unsigned int channels,
+		unsigned int in_frames, float gain)
+{
+	sdm_modulator *mod;
+	unsigned int up_frames;
+
+	switch (osr) {
+	case 48:
+	case 64:
+	case 96:
+	case 128:
+	case 192:
+		break;
+	default:
+		fprintf(stderr, "%s: unsupported OSR %u\n", __func__, osr);
+		return NULL;
+	}
+
+	if (channels == 0 || channels > SDM_MODULATOR_MAX_CHANNELS || in_frames == 0 || (in_frames * osr) % 32) {
+		fprintf(stderr, "%s: %u frames can't be interpolated by %u\n", __func__, in_frames, osr);
+		return NULL;
+	}
+
+	mod = calloc(1, sizeof(*mod));
+	if (!mod)
+		return NULL;
+
+	mod->osr = osr;
+	mod->channels = channels;
+	mod->taps = SDM_FIR_TAPS / SDM_FIR_INTERPOLATION;
+	mod->ratio = osr / SDM_FIR_INTERPOLATION;
+	mod->scale = gain * SDM_FULL_SCALE / S32_FULL_SCALE;
+	mod->inputBufferSizePerChannel = in_frames;
+	mod->outputBufferSizePerChannel = in_frames * osr / 32;
+
+	up_frames = in_frames * SDM_FIR_INTERPOLATION;
+	mod->coefs = malloc(SDM_FIR_TAPS * sizeof(*mod->coefs));
+	mod->fir = malloc((mod->taps - 1 + in_frames) * channels * sizeof(*mod->fir));
+	mod->up = malloc((1 + up_frames) * channels * sizeof(*mod->up));
+	mod->state = malloc(2 * channels * sizeof(*mod->state));
+	mod->inputBuffer = calloc(in_frames * channels, sizeof(*mod->inputBuffer));
+	mod->outputBuffer = malloc(mod->outputBufferSizePerChannel * channels * sizeof(*mod->outputBuffer));
+	if (!mod->coefs || !mod->fir || !mod->up || !mod->state ||
+	    !mod->inputBuffer || !mod->outputBuffer) {
+		sdm_modulator_destroy(mod);
+		return NULL;
+	}
+
+	design_fir(mod->coefs, mod->taps);
+	mod->modulator_stage = modulator_stage_for(pcm_kernels_get()->name);
+	sdm_modulator_reset(mod);
+
+	return mod;
+}
+
+void sdm_modulator_destroy(sdm_modulator *mod)
+{
+	if (!mod)
+		return;
+
+	free(mod->coefs);
+	free(mod->fir);
+	free(mod->up);
+	free(mod->state);
+	free(mod->inputBuffer);
+	free(mod->outputBuffer);
+	free(mod);
+}
+
+void sdm_modulator_reset(sdm_modulator *mod)
+{
+	memset(mod->fir, 0, (mod->taps - 1) * mod->channels * sizeof(*mod->fir));
+	memset(mod->up, 0, mod->channels * sizeof(*mod->up));
+	/* integrators at rest, on silence the loop then outputs as many ones as zeros */
+	memset(mod->state, 0, 2 * mod->channels * sizeof(*mod->state));
+}
+
+static void fir_stage(sdm_modulator *mod)
+{
+	unsigned int channels = mod->channels;
+	unsigned int frames = mod->inputBufferSizePerChannel;
+	float *x = mod->fir + (mod->taps - 1) * channels;
+	float *up = mod->up + channels;
+	const float *c, *p;
+	unsigned int m, ph, ch, i;
+	float acc;
+
+	for (i = 0; i < frames * channels; i++)
+		x[i] = mod->inputBuffer[i] * mod->scale;
+
+	for (m = 0; m < frames; m++) {
+		for (ph = 0; ph < SDM_FIR_INTERPOLATION; ph++) {
+			c = mod->coefs + ph * mod->taps;
+			for (ch = 0; ch < channels; ch++) {
+				acc = 0.0f;
+				for (i = 0, p = mod->fir + m * channels + ch; i < mod->taps; i++, p += channels)
+					acc += c[i] * p[0];
+				up[(m * SDM_FIR_INTERPOLATION + ph) * channels + ch] = acc;
+			}
+		}
+	}
+}
+
+void sdm_modulator_stage_generic(sdm_modulator *mod, unsigned int first)
+{
+	unsigned int channels = mod->channels;
+	unsigned int up_frames = mod->inputBufferSizePerChannel * SDM_FIR_INTERPOLATION;
+	const float step = 1.0f / mod->ratio;
+	unsigned int ch, k, s, bits, w;
+	float i1, i2, y, x, d;
+	uint32_t word;
+
+	for (ch = first; ch < channels; ch++) {
+		i1 = mod->state[2 * ch];
+		i2 = mod->state[2 * ch + 1];
+		word = 0;
+		bits = 0;
+		w = 0;
+
+		for (k = 1; k <= up_frames; k++) {
+			x = mod->up[(k - 1) * channels + ch];
+			d = (mod->up[k * channels + ch] - x) * step;
+			for (s = 0; s < mod->ratio; s++) {
+				x += d;
+				y = i2 >= 0.0f ? 1.0f : -1.0f;
+				i1 += x - y;
+				i2 += i1 - y;
+				word = word << 1 | (i2 >= 0.0f);
+				if (++bits == 32) {
+					mod->outputBuffer[w++ * channels + ch] = word;
+					bits = 0;
+				}
+			}
+		}
+
+		mod->state[2 * ch] = i1;
+		mod->state[2 * ch + 1] = i2;
+	}
+}
+
+double sdm_modulator_delay(void)
+{
+	/* linear phase FIR at 4 times the input rate, plus one frame of the hold */
+	return (SDM_FIR_TAPS - 1) / 2.0 / SDM_FIR_INTERPOLATION +
+	       1.0 / SDM_FIR_INTERPOLATION;
+}
+
+void sdm_modulator_process(sdm_modulator *mod)
+{
+	unsigned int channels = mod->channels;
+	unsigned int frames = mod->inputBufferSizePerChannel;
+	unsigned int up_frames = frames * SDM_FIR_INTERPOLATION;
+
+	fir_stage(mod);
+	mod->modulator_stage(mod, 0);
+
+	memmove(mod->fir, mod->fir + frames * channels,
+		(mod->taps - 1) * mod->channels * sizeof(*mod->fir));
+	/* the last interpolated frame starts the hold of the next block */
+	memmove(mod->up, mod->up + up_frames * channels, channels * sizeof(*mod->up));
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ */
+/**
+   @file sdm_modulator.h
+   @brief pcm to pdm interpolator and sigma-delta modulator, the reverse of cic_decimator.h
+*/
+
+#ifndef SDM_MODULATOR_H
+#define SDM_MODULATOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SDM_FIR_INTERPOLATION                 4
+#define SDM_MODULATOR_MAX_CHANNELS            8
+
+typedef struct sdm_modulator sdm_modulator;
+
+/* Modulator stage from channel first to the last one. */
+typedef void (*sdm_modulator_stage)(sdm_modulator *mod, unsigned int first);
+
+struct sdm_modulator {
+	unsigned int osr;
+	unsigned int channels;
+	/* FIR stage, polyphase interpolation by 4 */
+	unsigned int taps;          /* of every phase */
+	float *coefs;               /* SDM_FIR_INTERPOLATION * taps, one reversed kernel per phase */
+	float *fir;                 /* interleaved history + block of input */
+	float *up;                  /* interleaved FIR output, one frame of history first */
+	/* hold stage and modulator, at the bit rate */
+	unsigned int ratio;         /* linear interpolation, OSR / 4 */
+	float *state;               /* two integrators per channel */
+	float scale;
+	sdm_modulator_stage modulator_stage; /* variant of the cpu, see sdm_modulator_create() */
+	/* Block buffers, S32_LE in and DSD_U32_LE out, channel interleaved. */
+	int32_t *inputBuffer;
+	uint32_t *outputBuffer;
+	unsigned int inputBufferSizePerChannel;
+	unsigned int outputBufferSizePerChannel;
+};
+
+/* in_frames * osr must be a multiple of 32, gain is linear, 1 for full scale. */
+sdm_modulator *sdm_modulator_create(unsigned int osr, unsigned int channels,
+		unsigned int in_frames, float gain);
+
+void sdm_modulator_destroy(sdm_modulator *mod);
+
+void sdm_modulator_reset(sdm_modulator *mod);
+
+void sdm_modulator_process(sdm_modulator *mod);
+
+/* Group delay of the interpolation, in input frames. */
+double sdm_modulator_delay(void);
+
+/*
+ * The modulator variants give the same bits. The SIMD ones are built with
+ * their own flags in sdm_modulator_neon.c and sdm_modulator_avx2.c, NULL
+ * when not built for this target, and the one of the pcm kernels chosen
+ * for the cpu is used, see pcm_kernels_get().
+ */
+void sdm_modulator_stage_generic(sdm_modulator *mod, unsigned int first);
+sdm_modulator_stage sdm_modulator_stage_neon(void);
+sdm_modulator_stage sdm_modulator_stage_avx2(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
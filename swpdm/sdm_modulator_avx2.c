@@ -0,0 +1,75 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * AVX2 modulator of sdmFilter, built with -mavx2 and only called when
+ * the cpu has it. The loop only needs SSE4.1, it is built with the other
+ * AVX2 variants.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdm_modulator.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+/* Four channels per vector, the bits of each lane shifted in its own word. */
+static void modulator_stage(sdm_modulator *mod, unsigned int first)
+{
+	unsigned int channels = mod->channels;
+	unsigned int up_frames = mod->inputBufferSizePerChannel * SDM_FIR_INTERPOLATION;
+	const __m128 one = _mm_set1_ps(1.0f), mone = _mm_set1_ps(-1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 step = _mm_set1_ps(1.0f / mod->ratio);
+	__m128 i1, i2, x, d, y, ge;
+	__m128i word;
+	unsigned int ch, k, s, bits, w;
+	float *st;
+
+	for (ch = first; ch + 4 <= channels; ch += 4) {
+		st = mod->state + 2 * ch;
+		i1 = _mm_setr_ps(st[0], st[2], st[4], st[6]);
+		i2 = _mm_setr_ps(st[1], st[3], st[5], st[7]);
+		word = _mm_setzero_si128();
+		bits = 0;
+		w = 0;
+
+		for (k = 1; k <= up_frames; k++) {
+			x = _mm_loadu_ps(mod->up + (k - 1) * channels + ch);
+			d = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(mod->up + k * channels + ch), x), step);
+			for (s = 0; s < mod->ratio; s++) {
+				x = _mm_add_ps(x, d);
+				y = _mm_blendv_ps(mone, one, _mm_cmpge_ps(i2, zero));
+				i1 = _mm_add_ps(i1, _mm_sub_ps(x, y));
+				i2 = _mm_add_ps(i2, _mm_sub_ps(i1, y));
+				ge = _mm_cmpge_ps(i2, zero);
+				word = _mm_or_si128(_mm_slli_epi32(word, 1), _mm_srli_epi32(_mm_castps_si128(ge), 31));
+				if (++bits == 32) {
+					_mm_storeu_si128((__m128i *)(mod->outputBuffer + w++ * channels + ch), word);
+					bits = 0;
+				}
+			}
+		}
+
+		_mm_storeu_ps(st, _mm_unpacklo_ps(i1, i2));
+		_mm_storeu_ps(st + 4, _mm_unpackhi_ps(i1, i2));
+	}
+
+	sdm_modulator_stage_generic(mod, ch);
+}
+
+sdm_modulator_stage sdm_modulator_stage_avx2(void)
+{
+	return modulator_stage;
+}
+
+#else
+
+sdm_modulator_stage sdm_modulator_stage_avx2(void)
+{
+	return NULL;
+}
+
+#endif
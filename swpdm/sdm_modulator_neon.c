@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * NEON modulator of sdmFilter, native on ARMv8 and built with -mfpu=neon
+ * on ARMv7 where it is only called when the cpu has NEON.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdm_modulator.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+/* Four channels per vector, the bits of each lane shifted in its own word. */
+static void modulator_stage(sdm_modulator *mod, unsigned int first)
+{
+	unsigned int channels = mod->channels;
+	unsigned int up_frames = mod->inputBufferSizePerChannel * SDM_FIR_INTERPOLATION;
+	const float32x4_t one = vdupq_n_f32(1.0f), mone = vdupq_n_f32(-1.0f);
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float step = 1.0f / mod->ratio;
+	float32x4_t i1, i2, x, d, y;
+	uint32x4_t word, ge;
+	unsigned int ch, k, s, bits, w;
+
+	for (ch = first; ch + 4 <= channels; ch += 4) {
+		i1 = (float32x4_t){ mod->state[2 * ch], mod->state[2 * ch + 2], mod->state[2 * ch + 4], mod->state[2 * ch + 6] };
+		i2 = (float32x4_t){ mod->state[2 * ch + 1], mod->state[2 * ch + 3], mod->state[2 * ch + 5], mod->state[2 * ch + 7] };
+		word = vdupq_n_u32(0);
+		bits = 0;
+		w = 0;
+
+		for (k = 1; k <= up_frames; k++) {
+			x = vld1q_f32(mod->up + (k - 1) * channels + ch);
+			d = vmulq_n_f32(vsubq_f32(vld1q_f32(mod->up + k * channels + ch), x), step);
+			for (s = 0; s < mod->ratio; s++) {
+				x = vaddq_f32(x, d);
+				y = vbslq_f32(vcgeq_f32(i2, zero), one, mone);
+				i1 = vaddq_f32(i1, vsubq_f32(x, y));
+				i2 = vaddq_f32(i2, vsubq_f32(i1, y));
+				ge = vcgeq_f32(i2, zero);
+				word = vorrq_u32(vshlq_n_u32(word, 1), vshrq_n_u32(ge, 31));
+				if (++bits == 32) {
+					vst1q_u32(mod->outputBuffer + w++ * channels + ch, word);
+					bits = 0;
+				}
+			}
+		}
+
+		mod->state[2 * ch] = vgetq_lane_f32(i1, 0);
+		mod->state[2 * ch + 2] = vgetq_lane_f32(i1, 1);
+		mod->state[2 * ch + 4] = vgetq_lane_f32(i1, 2);
+		mod->state[2 * ch + 6] = vgetq_lane_f32(i1, 3);
+		mod->state[2 * ch + 1] = vgetq_lane_f32(i2, 0);
+		mod->state[2 * ch + 3] = vgetq_lane_f32(i2, 1);
+		mod->state[2 * ch + 5] = vgetq_lane_f32(i2, 2);
+		mod->state[2 * ch + 7] = vgetq_lane_f32(i2, 3);
+	}
+
+	sdm_modulator_stage_generic(mod, ch);
+}
+
+sdm_modulator_stage sdm_modulator_stage_neon(void)
+{
+	return modulator_stage;
+}
+
+#else
+
+sdm_modulator_stage sdm_modulator_stage_neon(void)
+{
+	return NULL;
+}
+
+#endif
@@ -3,16 +3,75 @@
  * Copyright 2022 NXP
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* CPU_SET, pthread_setaffinity_np */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
 
 #include <alsa/asoundlib.h>
 #include <alsa/pcm_external.h>
 #include <alsa/global.h>
 
+#ifdef HAVE_IMXSWPDM
 #include <imx-mm/audio-codec/swpdm/imx-swpdm.h>
+#else
+#include <stdbool.h>
+
+/*
+ * Built without libimxswpdm only the built-in decoder is there. The afe
+ * types keep the names of the library so that the rest of the plugin
+ * reads the same, an afe decoder is never created.
+ */
+#define SWPDM_ERR                             -1
+
+typedef enum {
+	CIC_pdmToPcmType_cic_order_5_cic_downsample_12,
+	CIC_pdmToPcmType_cic_order_5_cic_downsample_16,
+	CIC_pdmToPcmType_cic_order_5_cic_downsample_24,
+	CIC_pdmToPcmType_cic_order_5_cic_downsample_32,
+	CIC_pdmToPcmType_cic_order_5_cic_downsample_48,
+	CIC_pdmToPcmType_cic_order_5_cic_downsample_unavailable
+} cic_t;
+
+typedef struct {
+	void *inputBuffer;
+	void *outputBuffer;
+	unsigned int inputBufferSizePerChannel;
+	unsigned int outputBufferSizePerChannel;
+} afe_t;
+
+static inline bool constructAfeCicDecoder(cic_t type, afe_t *afe, float gain, unsigned int samples) {
+	return false;
+}
+
+static inline void processAfeCic(afe_t *afe) {
+}
+
+static inline void deleteAfeCicDecoder(afe_t *afe) {
+}
+#endif
+
+#include "cic_decimator.h"
+#include "pcm_resampler.h"
+#include "cic_stats.h"
+#include "cic_share.h"
+#include "cic_gate.h"
+#include "cic_caps.h"
+#include "cic_tap.h"
+#include "cic_ctl.h"
+#include "pdm_rates.h"
+#include "pcm_kernels.h"
+#include "rt_arena.h"
 
 #define PLUG_NAME                               cicFilter
 
@@ -21,13 +80,34 @@
 
 #define MAX_IN_BUFFER_SIZE                    8192
 #define MAX_IN_PERIOD_SIZE                    4096
+#define MIN_PERIOD_BYTES                      64
+#define MAX_PERIOD_BYTES                      65536
+#define DECODER_BLOCK_UNIT                    16 /* afe decoders work on 16 frames */
+#define MAX_PDM_CLOCK                         4800000
 
-#define PDM_CHANNELS                          4
+#define PDM_CHANNELS                          4 /* channels per afe decoder */
+#define MAX_PDM_GROUPS                        2
 #define FORMAT                                4
-#define MAX_PCM_CHANNELS                      4
+#define MAX_PCM_CHANNELS                      (PDM_CHANNELS * MAX_PDM_GROUPS)
 #define MIN_PCM_CHANNELS                      1
 #define MAX_PERIODS                           8
 #define DIV_BY_8(x)                           ((x) >> 3)
+#define SETTLE_PERIODS                        2
+#define SETTLE_THRESHOLD                      -60
+#define PRIME_FRAMES                          32 /* decoder memory of the gap after an overrun */
+#define MIX_SHIFT                             20 /* Q20 mixing coefficients */
+#define DC_BLOCK_SHIFT                        10 /* dc pole at rate / 6434 */
+#define MIC_GAIN_MIN                          -60.0
+#define MIC_GAIN_MAX                          24.0
+#define MATRIX_COEF_MAX                       16.0
+#define SHARE_BLOCK_MS                        10
+#define SHARE_RING_MS                         500
+#define SHARE_SLAVE_PERIODS                   4
+#define GATE_THRESHOLD                        -50
+#define GATE_HOLD_MS                          500
+#define TAP_TIME_S                            10
+#define TAP_BUFFER_KB                         4096
+#define RT_LOCKED_MAX                         8
 
 typedef struct snd_pcm_cic_filter {
 	/* internal plug elements */
@@ -37,22 +117,147 @@ typedef struct snd_pcm_cic_filter {
 	snd_pcm_uframes_t ptr;
 	snd_pcm_uframes_t boundary;
 	/* afe elements */
-	afe_t *afe;
+	afe_t *afe[MAX_PDM_GROUPS];
+	unsigned int groups;
+	unsigned int *pdm_buffer;
 	cic_t type;
+	/* built-in decoder, used instead of the afe ones when selected */
+	int builtin;
+	cic_decimator *dec[MAX_PDM_GROUPS];
 	float gain;
 	unsigned out_samples_per_channel;
 	snd_pcm_uframes_t out_period_size;
 	snd_pcm_uframes_t in_period_size;
+	/* rate conversion of the decoded stream to the app rate */
+	unsigned int dec_rate;
+	snd_pcm_uframes_t dec_period_size;
+	pcm_resampler *rs;
+	unsigned int *pcm_buffer;
+	/* decoded frames of the last block not read by the app yet */
+	unsigned int *carry;
+	snd_pcm_uframes_t carry_offset;
+	snd_pcm_uframes_t carry_frames;
 	/* external plug elements */
 	int inval_iterations;
 	int iterations;
 	unsigned int delay;
+	/* adaptive end of the discard window */
+	int settle_adaptive;
+	int settle_threshold;
+	double settle_level;
+	double dc[MAX_PCM_CHANNELS];
+	int settle_count;
+	/* overrun recovery, only the decoder memory of the gap is discarded when fast */
+	int recovery_full;
+	int prime_iterations;
+	snd_htimestamp_t xrun_tstamp;
+	int gap_pending;
+	/* latency of the decoding chain, in app frames */
+	snd_pcm_sframes_t group_delay;
+	unsigned int decoder_delay;
+	snd_htimestamp_t tstamp;
+	snd_pcm_uframes_t tstamp_ptr;
+	/* per mic calibration and mixing, applied while writing the app buffer */
+	unsigned int mics;
+	int mix;
+	int diagonal;
+	int dc_block;
+	double mic_gain[MAX_PCM_CHANNELS];
+	double matrix[MAX_PCM_CHANNELS][MAX_PCM_CHANNELS];
+	unsigned int matrix_rows;
+	unsigned int matrix_cols;
+	int32_t mix_coefs[MAX_PCM_CHANNELS * MAX_PCM_CHANNELS];
+	int64_t dc_est[MAX_PCM_CHANNELS];
+	/* live controls, see cic_ctl.h, mixing changes ramp in over a block */
+	char *ctl_name;
+	cic_ctl *ctl;
+	uint32_t ctl_gen;
+	unsigned int map[MAX_PCM_CHANNELS];
+	int32_t ramp_coefs[MAX_PCM_CHANNELS * MAX_PCM_CHANNELS];
+	int ramp;
+	/* instrumentation, see cic_stats.h */
+	cic_stats *stats;
+	char *stats_shm;
+	cic_trace *trace;
+	char *trace_file;
+	cic_trace_record rec;
+	int xrun_pending;
+	/* raw slave periods written to tap_file when asked, see cic_tap.h */
+	char *tap_file;
+	unsigned int tap_time;
+	unsigned int tap_buffer;
+	unsigned int tap_pending;
+	cic_tap *tap;
+	/* pdm activity gates, one per group, see cic_gate.h */
+	int gate_enabled;
+	int gate_threshold;
+	unsigned int gate_hold;
+	cic_gate *gate[MAX_PDM_GROUPS];
+	/* setup kept across hw_params cycles, redone only when it changes */
+	cic_t built_type;
+	int built_builtin;
+	float built_gain;
+	snd_pcm_uframes_t built_block;
+	unsigned int built_groups;
+	unsigned int slave_rate;
+	unsigned int slave_channels;
+	/* rates and periods the slave accepts at the OSR, see cic_caps.h */
+	int caps_cache;
+	int caps_cached;
+	cic_caps_entry caps;
+	snd_pcm_uframes_t slave_period;
+	snd_pcm_uframes_t slave_buffer;
+	/* slave buffer deeper than the app one, drained in bursts or skipped */
+	unsigned int slave_periods;
+	unsigned int slave_buffer_time;
+	unsigned int catchup_time;
+	snd_pcm_uframes_t catchup_high;
+	snd_pcm_uframes_t catchup_low;
+	/* real-time mode: working buffers in a locked arena, the rest locked in place */
+	int rt;
+	int rt_huge;
+	rt_arena *arena;
+	struct {
+		void *addr;
+		size_t size;
+	} locked[RT_LOCKED_MAX];
+	unsigned int nlocked;
+	int lock_err;
+	/* decoded stream shared by several pcms, see cic_share.h */
+	char *share_name;
+	unsigned int share_rate;
+	unsigned int share_channels;
+	char *share_slave;
+	cic_share *share;
+	int share_owner;
+	int share_started;
+	struct snd_pcm_cic_filter *share_dec;
+	pthread_t share_thread;
+	int share_exit;
+	uint64_t share_pos;
+	int32_t *share_out[MAX_PDM_GROUPS];
+	int share_timer;
 	unsigned int OSR;
+	/* parallel decoding of the second pdm group */
+	pthread_t worker;
+	sem_t work;
+	sem_t done;
+	int worker_running;
+	int worker_exit;
+	int worker_cpu;
 }snd_pcm_cic_filter_t;
 
+/* Where every app channel goes, interleaved or planar, steps in samples. */
+typedef struct {
+	int32_t *addr[MAX_PCM_CHANNELS];
+	unsigned int step[MAX_PCM_CHANNELS];
+	int interleaved;
+} pcm_dest_t;
+
 static int cic_start(snd_pcm_ioplug_t *io);
 static int cic_stop(snd_pcm_ioplug_t *io);
 static snd_pcm_sframes_t cic_pointer(snd_pcm_ioplug_t *io);
+static int cic_delay(snd_pcm_ioplug_t *io, snd_pcm_sframes_t *delayp);
 static snd_pcm_sframes_t cic_transfer(snd_pcm_ioplug_t *io, const snd_pcm_channel_area_t *areas,
                                       snd_pcm_uframes_t offset, snd_pcm_uframes_t size);
 static int cic_close(snd_pcm_ioplug_t *io);
@@ -64,9 +269,12 @@ static int cic_poll_descriptors_count(snd_pcm_ioplug_t *io);
 static int cic_poll_descriptors(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int space);
 static int cic_poll_revents(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int nfds, unsigned short *revents);
 static void cic_dump(snd_pcm_ioplug_t *io, snd_output_t *out);
+static void dump_stats(snd_pcm_cic_filter_t *cic, snd_output_t *out);
 static inline int parse_struct(snd_config_t **conf, const char **devname, snd_pcm_cic_filter_t *cic);
 static void destroy(snd_pcm_cic_filter_t **cic);
 static int constrains(snd_pcm_ioplug_t *io);
+static int start_worker(snd_pcm_cic_filter_t *cic);
+static void stop_worker(snd_pcm_cic_filter_t *cic);
 static inline int compute_delay(snd_pcm_hw_params_t *params, snd_pcm_cic_filter_t *cic);
 
 static const snd_pcm_ioplug_callback_t cic_funcs  = {
@@ -82,29 +290,205 @@ static const snd_pcm_ioplug_callback_t cic_funcs  = {
 	.poll_descriptors_count = cic_poll_descriptors_count,
 	.poll_descriptors = cic_poll_descriptors,
 	.poll_revents = cic_poll_revents,
-	.dump = cic_dump
+	.dump = cic_dump,
+	.delay = cic_delay
 };
 
+static inline void *group_input(snd_pcm_cic_filter_t *cic, unsigned int g) {
+	return cic->builtin ? (void *)cic->dec[g]->inputBuffer : cic->afe[g]->inputBuffer;
+}
+
+static inline void *group_output(snd_pcm_cic_filter_t *cic, unsigned int g) {
+	if(cic->share != NULL)
+		return cic->share_out[g];
+	return cic->builtin ? (void *)cic->dec[g]->outputBuffer : cic->afe[g]->outputBuffer;
+}
+
+static inline void decode_group(snd_pcm_cic_filter_t *cic, unsigned int g) {
+	if(cic->builtin)
+		cic_decimator_process(cic->dec[g]);
+	else
+		processAfeCic(cic->afe[g]);
+}
+
+/* Decode a group, or output silence while its gate finds the mics idle. */
+static inline void group_process(snd_pcm_cic_filter_t *cic, unsigned int g) {
+	cic_gate *gate = cic->gate[g];
+
+	if(gate != NULL) {
+		switch(cic_gate_update(gate, group_input(cic, g))) {
+		case CIC_GATE_CLOSED:
+			memset(group_output(cic, g), 0, cic->dec_period_size * PDM_CHANNELS * FORMAT);
+			return;
+		case CIC_GATE_OPENING:
+			/* warm the decoder up with the idle period before, its output is dropped */
+			cic_gate_swap(gate, group_input(cic, g));
+			decode_group(cic, g);
+			cic_gate_swap(gate, group_input(cic, g));
+			break;
+		}
+	}
+	decode_group(cic, g);
+}
+
+static unsigned int gcd(unsigned int a, unsigned int b) {
+	unsigned int t;
+
+	while(b != 0) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+/*
+ * Frames decoded at once, independent of the app period. The app period
+ * itself when the decoders can produce it, so that aligned reads go
+ * straight to the app buffer, otherwise the largest block below it. A
+ * block is a multiple of 16 frames and, when resampling, of the decimation
+ * of the resampler. Returns 0 when no block fits in a slave period of
+ * max_in frames.
+ */
+static snd_pcm_uframes_t decoder_block(unsigned int OSR, unsigned int dec_rate, unsigned int rate,
+				       snd_pcm_uframes_t period_size, snd_pcm_uframes_t max_in) {
+	snd_pcm_uframes_t unit = DECODER_BLOCK_UNIT, block, max;
+	unsigned int down;
+
+	if(dec_rate != rate) {
+		down = dec_rate / gcd(dec_rate, rate);
+		unit = unit / gcd(unit, down) * down;
+	}
+
+	max = max_in * 32 / OSR / unit * unit;
+	block = period_size * dec_rate / rate / unit * unit;
+	if(block < unit)
+		block = unit;
+	if(block > max)
+		block = max;
+
+	return block;
+}
+
+/* Largest slave period of the layout of groups, the static one until probed. */
+static snd_pcm_uframes_t slave_max_period(snd_pcm_cic_filter_t *cic, unsigned int groups) {
+	if(cic->caps.osr == 0 || cic->caps.max_period[groups - 1] >= MAX_IN_PERIOD_SIZE)
+		return MAX_IN_PERIOD_SIZE;
+
+	return cic->caps.max_period[groups - 1];
+}
+
+/* Rate decoded for an app rate, among the ones the slave captures with groups. */
+static unsigned int dec_rate_for(snd_pcm_cic_filter_t *cic, unsigned int rate, unsigned int groups) {
+	if(cic->share != NULL)
+		return cic->share->rate;
+
+	return pdm_pcm_rate_mask(cic->OSR, rate, cic->caps.osr != 0 ? cic->caps.rates[groups - 1] : ~0u);
+}
+
+/* Discard the decoder output again, until settled or for the whole delay. */
+static inline void arm_discard(snd_pcm_cic_filter_t *cic) {
+	cic->inval_iterations = cic->iterations;
+	cic->settle_count = -1;
+}
+
+/*
+ * Blocks discarded after an overrun. The decoders keep their state, only
+ * the blocks whose CIC and FIR history spans the gap are dropped, unless
+ * the recovery is full.
+ */
+static inline int recovery_iterations(snd_pcm_cic_filter_t *cic) {
+	if(cic->recovery_full || cic->prime_iterations > cic->iterations)
+		return cic->iterations;
+	return cic->prime_iterations;
+}
+
+static inline void arm_recovery(snd_pcm_cic_filter_t *cic) {
+	int n = recovery_iterations(cic);
+
+	/* an overrun while still settling from the start */
+	if(cic->inval_iterations < n)
+		cic->inval_iterations = n;
+	cic->settle_count = -1;
+}
+
+/*
+ * The decoders start from an empty state, the step response of the
+ * CIC/FIR shows up as a DC transient in the first periods. The output is
+ * settled once the mean of every channel moves less than the threshold
+ * between SETTLE_PERIODS consecutive periods.
+ */
+static int decoder_settled(snd_pcm_cic_filter_t *cic, unsigned int channels) {
+	int *pcm_samples;
+	unsigned int g, c, n;
+	snd_pcm_uframes_t j;
+	double mean;
+	int stable = 1;
+
+	for(g = 0; g < cic->groups; g++) {
+		pcm_samples = (int *)group_output(cic, g);
+		n = channels - g * PDM_CHANNELS;
+		if(n > PDM_CHANNELS)
+			n = PDM_CHANNELS;
+
+		for(c = 0; c < n; c++) {
+			mean = 0;
+			for(j = 0; j < cic->dec_period_size; j++)
+				mean += pcm_samples[j * PDM_CHANNELS + c];
+			mean /= cic->dec_period_size;
+
+			if(fabs(mean - cic->dc[g * PDM_CHANNELS + c]) > cic->settle_level)
+				stable = 0;
+			cic->dc[g * PDM_CHANNELS + c] = mean;
+		}
+	}
+
+	/* the first period only gives the reference level */
+	if(cic->settle_count < 0 || !stable)
+		cic->settle_count = 0;
+	else
+		cic->settle_count++;
+
+	return cic->settle_count >= SETTLE_PERIODS;
+}
+
 /* Trigger slave  PCM */
 static inline int compute_delay(snd_pcm_hw_params_t *params, snd_pcm_cic_filter_t *cic) {
-	unsigned int period_time;
+	unsigned int rate;
 	int err, dir;
 	double n;
 
-	err = snd_pcm_hw_params_get_period_time(params, &period_time, &dir);
+	err = snd_pcm_hw_params_get_rate(params, &rate, &dir);
 	if(err < 0)
 		return err;
 
-	n = (double)((double)cic->delay / (double)period_time);
-	cic->inval_iterations = (int)ceil(n);
-	cic->iterations = cic->inval_iterations;
+	/* the discard goes by decoded blocks */
+	n = (double)cic->delay * rate / 1000000 / cic->out_period_size;
+	cic->iterations = (int)ceil(n);
+	cic->prime_iterations = (PRIME_FRAMES + cic->out_period_size - 1) / cic->out_period_size;
+	arm_discard(cic);
 
 	return err;
 }
 
+static snd_pcm_sframes_t shared_avail(snd_pcm_cic_filter_t *cic);
+static void arm_share_timer(snd_pcm_cic_filter_t *cic, int on);
+
 static int cic_start(snd_pcm_ioplug_t *io) {
 	snd_pcm_cic_filter_t *cic = io->private_data;
 
+	/* a shared stream is read from its current position, the owner decodes while a pcm is started */
+	if(cic->share != NULL) {
+		cic->share_pos = cic_share_write_pos(cic->share);
+		if(!cic->share_started) {
+			cic_share_start(cic->share, 1);
+			cic->share_started = 1;
+		}
+		arm_share_timer(cic, 1);
+		return 0;
+	}
+
 	if(snd_pcm_state(cic->slave) == SND_PCM_STATE_RUNNING)
 		return 0;
 
@@ -113,484 +497,2562 @@ static int cic_start(snd_pcm_ioplug_t *io) {
 
 static int cic_stop(snd_pcm_ioplug_t *io) {
 	snd_pcm_cic_filter_t *cic = io->private_data;
-	snd_pcm_drop(cic->slave);
+
+	if(cic->share != NULL) {
+		arm_share_timer(cic, 0);
+		if(cic->share_started) {
+			cic_share_start(cic->share, 0);
+			cic->share_started = 0;
+		}
+	} else
+		snd_pcm_drop(cic->slave);
 	return 0;
 }
 
-static snd_pcm_sframes_t cic_pointer(snd_pcm_ioplug_t *io) {
-	snd_pcm_cic_filter_t *cic = io->private_data;
+static int discard_settling(snd_pcm_cic_filter_t *cic, unsigned int channels,
+			    snd_pcm_sframes_t *avail);
+static void note_xrun(snd_pcm_cic_filter_t *cic);
+
+/*
+ * The slave holds more than the catch-up watermark after a stall: skip its
+ * oldest periods, down to an app period and the blocks that prime the
+ * decoders again across the gap, as after an overrun.
+ */
+static int catch_up(snd_pcm_cic_filter_t *cic, snd_pcm_sframes_t *avail) {
+	snd_pcm_sframes_t frames, keep;
+
+	keep = cic->catchup_low + (snd_pcm_sframes_t)recovery_iterations(cic) * cic->in_period_size;
+	frames = (*avail - keep) / (snd_pcm_sframes_t)cic->in_period_size * cic->in_period_size;
+	if(frames <= 0)
+		return 0;
+
+	frames = snd_pcm_forward(cic->slave, frames);
+	if(frames < 0)
+		return frames;
+	*avail -= frames;
+	arm_recovery(cic);
+
+	cic_stats_begin(cic->stats);
+	cic->stats->caught_up += frames / cic->in_period_size;
+	cic_stats_end(cic->stats);
+
+	return 0;
+}
+
+/*
+ * Frames the slave holds, before the settling discard. The position of the
+ * slave is the one of its last period interrupt, no hwsync is needed since
+ * only whole periods are decoded anyway.
+ */
+static snd_pcm_sframes_t slave_frames(snd_pcm_cic_filter_t *cic) {
 	snd_pcm_sframes_t avail;
 
-	avail = snd_pcm_avail(cic->slave);
+	avail = cic->share != NULL ? shared_avail(cic) : snd_pcm_avail_update(cic->slave);
 	if(avail < 0) {
-		cic->inval_iterations = cic->iterations;
-		return avail;
+		if(avail == -EPIPE)
+			note_xrun(cic);
+		arm_recovery(cic);
 	}
 
-	avail = avail * cic->out_period_size / cic->in_period_size;
+	return avail;
+}
+
+/*
+ * Frames the slave holds for the app: the settling periods never reach it
+ * nor move its position. Only counts, the pointer and the poll events
+ * neither read nor move the slave, see service_slave().
+ */
+static snd_pcm_sframes_t slave_avail(snd_pcm_cic_filter_t *cic) {
+	snd_pcm_sframes_t avail, discard;
 
-	avail = (cic->ptr + avail) % cic->boundary;
+	avail = slave_frames(cic);
+	if(avail < 0)
+		return avail;
 
-	return avail;
+	discard = (snd_pcm_sframes_t)cic->inval_iterations * cic->in_period_size;
+	return avail > discard ? avail - discard : 0;
 }
 
-static snd_pcm_sframes_t cic_transfer(snd_pcm_ioplug_t *io, const snd_pcm_channel_area_t *areas, 
-				      snd_pcm_uframes_t offset, snd_pcm_uframes_t size) {
-	snd_pcm_cic_filter_t *cic = io->private_data;
-	unsigned int *pcm_samples;
-	unsigned int *pdm_samples;
-	snd_pcm_sframes_t slave_frames;
-	unsigned int j;
+/* Drop the settling periods before a read, they wait in the slave until then. */
+static snd_pcm_sframes_t service_slave(snd_pcm_cic_filter_t *cic, unsigned int channels) {
+	snd_pcm_sframes_t avail;
+	int err;
 
-	/* PCM output */
-	pcm_samples = (unsigned int *)(areas->addr + DIV_BY_8(areas->first));
-	pcm_samples = (void *)pcm_samples + offset * DIV_BY_8(areas->step);
+	avail = slave_frames(cic);
+	if(avail < 0)
+		return avail;
 
-	/* PDM output */
-	pdm_samples = (unsigned int *)cic->afe->outputBuffer;
+	if(cic->catchup_high != 0 && cic->share == NULL && avail > (snd_pcm_sframes_t)cic->catchup_high) {
+		err = catch_up(cic, &avail);
+		if(err < 0)
+			return err;
+	}
 
-	/*Read from the slave and saved to the afe input buffer.*/
-	slave_frames = snd_pcm_mmap_readi(cic->slave, cic->afe->inputBuffer, cic->in_period_size);
-	if(slave_frames < 0)
-		return slave_frames;
-	/*pdm2pcm*/
-	processAfeCic(cic->afe);
-	/*Save to the app buffer.*/
 	if(cic->inval_iterations > 0) {
-		cic->inval_iterations--;
-		size = 0;
-	} else {
-		/*This work but the porcentage table with the -vv parameters doesnt work.*/
-		if (io->channels == PDM_CHANNELS) {
-			memcpy(pcm_samples, cic->afe->outputBuffer, cic->out_period_size * PDM_CHANNELS * FORMAT);
-		} else if (io->channels == 1) {
-			for(j=0; j < io->period_size; j++) {
-					*pcm_samples++ = *pdm_samples++;
-					pdm_samples = (void *)pdm_samples + 12;
-			}
-		}else if (io->channels == 2) {
-			for(j=0; j < io->period_size; j++) {
-					*pcm_samples++ = *pdm_samples++;
-					*pcm_samples++ = *pdm_samples++;
-					pdm_samples = (void *)pdm_samples + 8;
-			}
-		}else if (io->channels == 3) {
-			for(j=0; j < io->period_size; j++) {
-					*pcm_samples++ = *pdm_samples++;
-					*pcm_samples++ = *pdm_samples++;
-					*pcm_samples++ = *pdm_samples++;
-					pdm_samples = (void *)pdm_samples + 4;
-			}
-		}
+		err = discard_settling(cic, channels, &avail);
+		if(err < 0)
+			return err;
 	}
 
-	cic->ptr = cic->ptr + cic->out_period_size;
-	cic->ptr %= cic->boundary;
-
-	return size;
+	return avail;
 }
 
-static int cic_close(snd_pcm_ioplug_t *io) {
+static snd_pcm_sframes_t cic_pointer(snd_pcm_ioplug_t *io) {
 	snd_pcm_cic_filter_t *cic = io->private_data;
+	snd_pcm_sframes_t avail;
 
-	destroy(&cic);
-	return 0;
+	avail = slave_avail(cic);
+	if(avail < 0)
+		return avail;
+
+	/* only whole decoded blocks can be read, a deeper slave keeps the rest */
+	avail = avail / cic->in_period_size * cic->out_period_size + cic->carry_frames;
+	if(avail > (snd_pcm_sframes_t)io->buffer_size)
+		avail = io->buffer_size;
+
+	avail = (cic->ptr + avail) % cic->boundary;
+
+	return avail;
 }
 
-static int cic_hw(snd_pcm_ioplug_t *io, snd_pcm_hw_params_t *params) {
+/* Samples wait in the slave buffer, then go through the decoder group delay. */
+static int cic_delay(snd_pcm_ioplug_t *io, snd_pcm_sframes_t *delayp) {
 	snd_pcm_cic_filter_t *cic = io->private_data;
-	snd_pcm_format_t format;
-	unsigned int rate, refine_rate;
-	unsigned int samples_per_channel, periods;
+	snd_pcm_sframes_t slave_delay;
 	int err;
-	int dir;
 
-	/* Filter configuration */
-	/* The Cic Decoder request to divide the samples by 16. */
-	samples_per_channel = io->period_size / 16;
+	if(cic->share != NULL) {
+		slave_delay = shared_avail(cic);
+		if(slave_delay < 0)
+			return slave_delay;
+	} else {
+		err = snd_pcm_delay(cic->slave, &slave_delay);
+		if(err < 0)
+			return err;
+	}
 
-	/* refine the gain 1 ~ 101.0 */
-	cic->gain = (1 + cic->gain) * (double)(1 << 30) / pow(cic->OSR/4, 5);
+	*delayp = slave_delay * (snd_pcm_sframes_t)cic->out_period_size / (snd_pcm_sframes_t)cic->in_period_size +
+		  cic->carry_frames + cic->group_delay;
+	return 0;
+}
 
-	/* Init the afe object */
-	err = constructAfeCicDecoder(cic->type, cic->afe, cic->gain, samples_per_channel);
-	if (err == false) {
-		SNDERR("Fail to create AfeCicDecoder");
-		return SWPDM_ERR;
-	}
+/*
+ * Latency added by the decoders and the resampler, in app frames. The afe
+ * decoder has the same CIC by OSR / 4 and FIR by 4 structure as the built-in
+ * one, its delay is estimated the same way unless set with decoder_delay.
+ */
+static snd_pcm_sframes_t decoding_delay(snd_pcm_cic_filter_t *cic, unsigned int rate) {
+	double frames;
 
-	/* These values are in frame size. */
-	cic->in_period_size = cic->afe->inputBufferSizePerChannel;
-	cic->out_period_size = cic->afe->outputBufferSizePerChannel;
-	if(cic->out_period_size != io->period_size) {
-		SNDERR("Mismatch on AfeCicDecoder output buffer size and User buffer size."
-		" Set a power of two to the --period_size parameter.");
-		return SWPDM_ERR;
-	}
+	if(cic->decoder_delay != 0 && !cic->builtin)
+		frames = (double)cic->decoder_delay * cic->dec_rate / 1000000;
+	else
+		frames = cic_decimator_delay(cic->OSR);
 
-	if(cic->slave_params == NULL) {
-		err = snd_pcm_hw_params_malloc(&cic->slave_params);
-		if (err < 0)
-			return err;
-	}
+	frames = frames * rate / cic->dec_rate;
+	if(cic->rs != NULL)
+		frames += pcm_resampler_delay(cic->rs);
 
-	err = snd_pcm_hw_params_any(cic->slave, cic->slave_params);
-	if (err < 0) {
-		SNDERR("Broken configuration for capture: no configurations available: %s\n", snd_strerror(err));
-		return err;
-	}
+	return (snd_pcm_sframes_t)(frames + 0.5);
+}
 
-	/* set the interleaved read/write format */
-	err = snd_pcm_hw_params_set_access(cic->slave, cic->slave_params, SND_PCM_ACCESS_MMAP_INTERLEAVED );
-	if (err < 0) {
-		SNDERR("Access type not available for capture: %s\n", snd_strerror(err));
-		return err;
+/* Split the slave pdm frames in groups of 4 channels, one per afe decoder. */
+static void split_pdm_groups(snd_pcm_cic_filter_t *cic) {
+	unsigned int *pdm_samples = cic->pdm_buffer;
+	unsigned int *group_samples[MAX_PDM_GROUPS];
+	unsigned int g;
+	snd_pcm_uframes_t j;
+
+	for(g = 0; g < cic->groups; g++)
+		group_samples[g] = (unsigned int *)group_input(cic, g);
+
+	for(j = 0; j < cic->in_period_size; j++) {
+		for(g = 0; g < cic->groups; g++) {
+			memcpy(group_samples[g], pdm_samples, PDM_CHANNELS * FORMAT);
+			group_samples[g] += PDM_CHANNELS;
+			pdm_samples += PDM_CHANNELS;
+		}
 	}
+}
 
-	/* set channels */
-	err = snd_pcm_hw_params_set_channels(cic->slave, cic->slave_params, PDM_CHANNELS);
-	if (err < 0) {
-		SNDERR("Unable to set numbers of channels: %s\n", snd_strerror(err));
-		return err;
+/* Decode every pdm group, all but the first one on the worker thread. */
+static void process_pdm_groups(snd_pcm_cic_filter_t *cic) {
+	if(cic->groups == 1) {
+		group_process(cic, 0);
+		return;
 	}
 
-	/* set stream rate */
-	err = snd_pcm_hw_params_get_rate(params, &rate, &dir);
-	if (err < 0) {
-		SNDERR("unable to get device rate\n");
-		return err;
-	}
+	sem_post(&cic->work);
+	group_process(cic, 0);
+	sem_wait(&cic->done);
+}
 
-	switch (cic->OSR) {
-	case 48:
-		format = SND_PCM_FORMAT_DSD_U32_LE;
-		refine_rate = rate * 3 / 2;
-		break;
-	case 64:
-		format = SND_PCM_FORMAT_DSD_U32_LE;
-		refine_rate = rate * 2;
-		break;
-	case 96:
-		format = SND_PCM_FORMAT_DSD_U32_LE;
-		refine_rate = rate * 3;
-		break;
-	case 128:
-		format = SND_PCM_FORMAT_DSD_U32_LE;
-		refine_rate = rate * 4;
-		break;
-	case 192:
-		format = SND_PCM_FORMAT_DSD_U32_LE;
-		refine_rate = rate * 6;
-		break;
-	default:
-		SNDERR("Unsupported OSR: %d\n", cic->OSR);
-		return -EINVAL;
+/* Count a slave overrun once, until the stream is prepared again. */
+static void note_xrun(snd_pcm_cic_filter_t *cic) {
+	if(cic->xrun_pending)
+		return;
+	cic->xrun_pending = 1;
+	/* the frames missed from the last timestamp are counted once it runs again */
+	if(cic->tstamp.tv_sec != 0 || cic->tstamp.tv_nsec != 0) {
+		cic->xrun_tstamp = cic->tstamp;
+		cic->gap_pending = 1;
 	}
 
-	if (refine_rate * snd_pcm_format_width(format) > 4800000) {
-		SNDERR("max frequency can't exceed 4.8MHz\n");
-		return -EINVAL;
-	}
+	memset(&cic->rec, 0, sizeof(cic->rec));
+	cic->rec.tstamp_ns = cic_stats_now();
+	cic->rec.flags = CIC_TRACE_XRUN;
 
-	/* set the sample format */
-	err = snd_pcm_hw_params_set_format(cic->slave, cic->slave_params, format);
-	if (err < 0) {
-		SNDERR("Sample format not available for capture: %s\n", snd_strerror(err));
-		return err;
-	}
+	cic_stats_begin(cic->stats);
+	cic->stats->xruns++;
+	if(cic->trace != NULL && cic_trace_push(cic->trace, &cic->rec) < 0)
+		cic->stats->trace_dropped++;
+	cic_stats_end(cic->stats);
+}
 
-	err = snd_pcm_hw_params_set_rate(cic->slave, cic->slave_params, refine_rate, dir);
-	if(err < 0) {
-		SNDERR("Unable to set rate: %s\n", snd_strerror(err));
-		return err;
+/*
+ * App frames lost to the last overrun: the time between the last timestamp
+ * before it and the first one after the restart, less the frames the app
+ * got since, i.e. the frames of the gap and the ones primed out.
+ */
+static void account_gap(snd_pcm_cic_filter_t *cic, unsigned int rate) {
+	int64_t ns;
+	double lost;
+
+	ns = (int64_t)(cic->tstamp.tv_sec - cic->xrun_tstamp.tv_sec) * 1000000000 +
+	     (cic->tstamp.tv_nsec - cic->xrun_tstamp.tv_nsec);
+	lost = (double)ns * rate / 1000000000 - cic->tstamp_ptr;
+	cic->gap_pending = 0;
+	if(lost <= 0)
+		return;
+
+	cic_stats_begin(cic->stats);
+	cic->stats->lost_frames += (uint64_t)lost;
+	cic_stats_end(cic->stats);
+}
+
+/* Account the times of the period in cic->rec, copy time unless discarded. */
+static void account_period(snd_pcm_cic_filter_t *cic, uint32_t flags) {
+	cic_stats *st = cic->stats;
+	unsigned int i;
+
+	cic->rec.tstamp_ns = cic_stats_now();
+	cic->rec.flags = flags;
+
+	for(i = 0; i < cic->groups; i++)
+		if(cic->gate[i] != NULL && cic->gate[i]->state == CIC_GATE_CLOSED)
+			cic->rec.flags |= CIC_TRACE_GATED;
+
+	cic_stats_begin(st);
+	st->periods++;
+	if(flags & CIC_TRACE_DISCARD)
+		st->discarded++;
+	if(cic->rec.flags & CIC_TRACE_GATED)
+		st->gated++;
+	for(i = 0; i < CIC_STAT_TIMES; i++)
+		if(i != CIC_STAT_COPY || !(flags & CIC_TRACE_DISCARD))
+			cic_stats_time(st, i, cic->rec.time_ns[i]);
+	if(cic->trace != NULL && cic_trace_push(cic->trace, &cic->rec) < 0)
+		st->trace_dropped++;
+	cic_stats_end(st);
+}
+
+/*
+ * Frames of the shared ring not read yet. The owner writes a block past
+ * its write position before publishing it, the frames of the client are
+ * lost once they are within a block of being overwritten.
+ */
+static snd_pcm_sframes_t shared_avail(snd_pcm_cic_filter_t *cic) {
+	cic_share *sh = cic->share;
+	uint64_t avail;
+
+	if(!cic_share_running(sh))
+		return -ENODEV;
+
+	avail = cic_share_write_pos(sh) - cic->share_pos;
+	if(avail > sh->capacity - sh->block) {
+		note_xrun(cic);
+		return -EPIPE;
 	}
 
-	/* set the buffer size */
-	snd_pcm_hw_params_get_periods(params, &periods, &dir);
-	err = snd_pcm_hw_params_set_buffer_size(cic->slave, cic->slave_params, cic->in_period_size * periods);
-	if (err < 0) {
-		SNDERR("Unable to set buffer size.\n");
-		return err;
+	return avail;
+}
+
+/*
+ * Copy one block of the shared ring to the group outputs, the owner
+ * decoded it already. Waits for the owner like a slave read would, or for
+ * the pcm adopting the share when it left.
+ */
+static snd_pcm_sframes_t read_shared(snd_pcm_cic_filter_t *cic) {
+	struct timespec ts = { 0, cic->in_period_size * 250000000ull / cic->dec_rate };
+	const int32_t *frame;
+	snd_pcm_sframes_t avail;
+	snd_pcm_uframes_t j;
+	unsigned int c;
+	uint64_t t0, t1;
+
+	t0 = cic_stats_now();
+	while((avail = shared_avail(cic)) < (snd_pcm_sframes_t)cic->in_period_size) {
+		if(avail < 0)
+			return avail;
+		nanosleep(&ts, NULL);
 	}
+	t1 = cic_stats_now();
 
-	/* set period size */
-	err = snd_pcm_hw_params_set_period_size(cic->slave, cic->slave_params, cic->in_period_size, 0);
-	if (err < 0) {
-		SNDERR("Unable to set period time\n");
-		return err;
+	for(j = 0; j < cic->in_period_size; j++) {
+		frame = cic_share_frame(cic->share, cic->share_pos + j);
+		for(c = 0; c < cic->mics; c++)
+			cic->share_out[c / PDM_CHANNELS][j * PDM_CHANNELS + c % PDM_CHANNELS] = frame[c];
 	}
 
-	err = snd_pcm_hw_params(cic->slave, cic->slave_params);
-	if(err < 0) {
-		SNDERR("Couldnt set hw params\n");
-		return err;
+	/* the owner may have overwritten the block while it was copied */
+	avail = shared_avail(cic);
+	if(avail < 0)
+		return avail;
+	cic->share_pos += cic->in_period_size;
+
+	cic->rec.time_ns[CIC_STAT_READ] = t1 - t0;
+	cic->rec.time_ns[CIC_STAT_DECODE] = cic_stats_now() - t1;
+	cic->rec.time_ns[CIC_STAT_COPY] = 0;
+
+	return cic->in_period_size;
+}
+
+/*
+ * Copy the slave period to the tap while a capture is armed, from the
+ * open with tap_time or for the seconds asked in the stats page.
+ */
+static void tap_period(snd_pcm_cic_filter_t *cic, const void *pdm, snd_pcm_uframes_t frames) {
+	size_t frame_bytes = cic->groups * PDM_CHANNELS * FORMAT;
+
+	if(__atomic_load_n(&cic->stats->tap_request, __ATOMIC_RELAXED) != 0)
+		cic->tap_pending = __atomic_exchange_n(&cic->stats->tap_request, 0, __ATOMIC_ACQ_REL);
+	if(cic->tap_pending != 0 &&
+	   cic_tap_arm(cic->tap, (uint64_t)cic->tap_pending * pdm_slave_rate(cic->OSR, cic->dec_rate) * frame_bytes) == 0)
+		cic->tap_pending = 0;
+
+	if(cic_tap_push(cic->tap, pdm, frames * frame_bytes) < 0) {
+		cic_stats_begin(cic->stats);
+		cic->stats->tap_dropped++;
+		cic_stats_end(cic->stats);
 	}
+}
 
-	if(cic->delay != 0) {
-		if(compute_delay(params, cic) < 0)
-			SNDERR("WARNING: Unable to set requested delay");
+/* Read one slave period and decode it. */
+static snd_pcm_sframes_t read_pdm_groups(snd_pcm_cic_filter_t *cic) {
+	void *slave_samples;
+	snd_pcm_sframes_t slave_frames;
+	uint64_t t0, t1;
+
+	if(cic->share != NULL)
+		return read_shared(cic);
+
+	slave_samples = cic->groups == 1 ? group_input(cic, 0) : (void *)cic->pdm_buffer;
+	t0 = cic_stats_now();
+	slave_frames = snd_pcm_mmap_readi(cic->slave, slave_samples, cic->in_period_size);
+	t1 = cic_stats_now();
+	if(slave_frames < 0) {
+		if(slave_frames == -EPIPE)
+			note_xrun(cic);
+		return slave_frames;
 	}
+	if(cic->tap != NULL)
+		tap_period(cic, slave_samples, slave_frames);
+	if(cic->groups > 1)
+		split_pdm_groups(cic);
+	/*pdm2pcm*/
+	process_pdm_groups(cic);
 
-	return err;
+	cic->rec.time_ns[CIC_STAT_READ] = t1 - t0;
+	cic->rec.time_ns[CIC_STAT_DECODE] = cic_stats_now() - t1;
+	cic->rec.time_ns[CIC_STAT_COPY] = 0;
+
+	return slave_frames;
 }
 
-static int cic_hw_free(snd_pcm_ioplug_t *io) {
-	snd_pcm_cic_filter_t *cic = io->private_data;
+/*
+ * Decode and drop the startup periods already captured by the slave, so
+ * that they are not counted in the app avail nor in its delay.
+ */
+static int discard_settling(snd_pcm_cic_filter_t *cic, unsigned int channels,
+			    snd_pcm_sframes_t *avail) {
+	snd_pcm_sframes_t frames;
+
+	while(cic->inval_iterations > 0 && *avail >= (snd_pcm_sframes_t)cic->in_period_size) {
+		frames = read_pdm_groups(cic);
+		if(frames < 0)
+			return frames;
+		*avail -= frames;
+		cic->rec.slave_avail = *avail;
+		account_period(cic, CIC_TRACE_DISCARD);
+		if(cic->settle_adaptive && decoder_settled(cic, cic->mics))
+			cic->inval_iterations = 0;
+		else
+			cic->inval_iterations--;
+	}
 
-	free(cic->slave_params);
-	cic->slave_params = NULL;
-	snd_pcm_hw_free(cic->slave);
-	cic->slave = NULL;
 	return 0;
 }
 
-static int cic_sw(snd_pcm_ioplug_t *io, snd_pcm_sw_params_t *params) {
-	snd_pcm_cic_filter_t *cic = io->private_data;
-	snd_pcm_sw_params_t *sparams;
-	int err;
+/* Destination of an interleaved buffer. */
+static void interleaved_dest(pcm_dest_t *dest, void *buf, unsigned int channels) {
+	unsigned int c;
 
-	err = snd_pcm_sw_params_malloc(&sparams);
-	if(err < 0) {
-		//todo: move to hw_free;
-		return err;
+	for(c = 0; c < channels; c++) {
+		dest->addr[c] = (int32_t *)buf + c;
+		dest->step[c] = channels;
 	}
+	dest->interleaved = 1;
+}
 
-	/* get the current swparams */
-	err = snd_pcm_sw_params_current(cic->slave, sparams);
-	if (err < 0) {
-		SNDERR("Unable to determine current swparams for capture: %s\n", snd_strerror(err));
-		return err;
+/* Destination of the app areas at offset, any access type. */
+static void areas_dest(pcm_dest_t *dest, const snd_pcm_channel_area_t *areas,
+		       snd_pcm_uframes_t offset, unsigned int channels) {
+	unsigned int c;
+
+	dest->interleaved = 1;
+	for(c = 0; c < channels; c++) {
+		dest->addr[c] = (int32_t *)((char *)areas[c].addr + DIV_BY_8(areas[c].first) +
+					    offset * DIV_BY_8(areas[c].step));
+		dest->step[c] = areas[c].step / 32;
+		if(dest->step[c] != channels || dest->addr[c] != dest->addr[0] + c)
+			dest->interleaved = 0;
 	}
+}
 
-	/* start the transfer when the buffer has one period to process: */
-	err = snd_pcm_sw_params_set_start_threshold(cic->slave, sparams, cic->in_period_size);
-	err = err == 0 ? snd_pcm_sw_params_set_start_threshold(io->pcm, params, cic->in_period_size) : err;
-	if (err < 0) {
-		SNDERR("Unable to set start threshold mode for capture: %s\n", snd_strerror(err));
-		return err;
+static inline void advance_dest(pcm_dest_t *dest, unsigned int channels, snd_pcm_uframes_t frames) {
+	unsigned int c;
+
+	for(c = 0; c < channels; c++)
+		dest->addr[c] += frames * dest->step[c];
+}
+
+/* Copy interleaved frames to a destination, deinterleaving when planar. */
+static void copy_to_dest(const pcm_dest_t *dest, const int32_t *src,
+			 unsigned int channels, snd_pcm_uframes_t frames) {
+	const pcm_kernels *k = pcm_kernels_get();
+	unsigned int c;
+
+	if(dest->interleaved) {
+		memcpy(dest->addr[0], src, frames * channels * FORMAT);
+		return;
 	}
 
-	/* allow the transfer when at least period_size samples can be processed */
-	err = snd_pcm_sw_params_set_avail_min(cic->slave, sparams, cic->in_period_size);
-	err = err == 0 ? snd_pcm_sw_params_set_avail_min(io->pcm, params, cic->out_period_size) : err;
-	if (err < 0) {
-		SNDERR("Unable to set avail min for capture: %s\n", snd_strerror(err));
-		return err;
+	for(c = 0; c < channels; c++)
+		k->gather_s32(dest->addr[c], dest->step[c], src + c, channels, frames);
+}
+
+/* Interleave the output of every afe decoder in the app buffer, or split it per channel. */
+static void merge_pcm_groups(snd_pcm_cic_filter_t *cic, const pcm_dest_t *dest,
+			     unsigned int channels, snd_pcm_uframes_t frames) {
+	const pcm_kernels *k = pcm_kernels_get();
+	const int32_t *pdm_samples;
+	unsigned int g, c, n, o;
+
+	for(g = 0; g < cic->groups; g++) {
+		n = channels - g * PDM_CHANNELS;
+		if(n > PDM_CHANNELS)
+			n = PDM_CHANNELS;
+
+		for(c = 0; c < n; c++) {
+			pdm_samples = (const int32_t *)group_output(cic, g) + c;
+			o = g * PDM_CHANNELS + c;
+			k->gather_s32(dest->addr[o], dest->step[o], pdm_samples, PDM_CHANNELS, frames);
+		}
 	}
+}
 
-	snd_pcm_sw_params_get_boundary(params, &cic->boundary);
+/* Same with the gain of every mic, when each channel is its own mic and nothing else is mixed. */
+static void gain_pcm_groups(snd_pcm_cic_filter_t *cic, const pcm_dest_t *dest,
+			    unsigned int channels, snd_pcm_uframes_t frames) {
+	const pcm_kernels *k = pcm_kernels_get();
+	const int32_t *pdm_samples;
+	unsigned int o;
+
+	for(o = 0; o < channels; o++) {
+		pdm_samples = (const int32_t *)group_output(cic, o / PDM_CHANNELS) + o % PDM_CHANNELS;
+		k->gain_s32(dest->addr[o], dest->step[o], pdm_samples, PDM_CHANNELS, frames,
+			    cic->mix_coefs[o * cic->mics + o]);
+	}
+}
 
-	return snd_pcm_sw_params(cic->slave, sparams);
+/*
+ * Mixing coefficients in Q20, the gain of every mic folded in its column.
+ * Without a matrix every channel gets its own mic, a channel mapped by the
+ * controls gets only the mic it is mapped to.
+ */
+static void mix_coefs(snd_pcm_cic_filter_t *cic, unsigned int channels) {
+	double coef;
+	unsigned int o, i;
+
+	cic->mix = cic->dc_block || cic->matrix_rows != 0;
+	cic->diagonal = !cic->mix && channels <= cic->mics;
+	for(o = 0; o < channels; o++) {
+		if(cic->map[o] != 0 && cic->map[o] <= cic->mics) {
+			cic->mix = 1;
+			cic->diagonal = 0;
+		}
+		for(i = 0; i < cic->mics; i++) {
+			if(cic->map[o] != 0 && cic->map[o] <= cic->mics)
+				coef = i == cic->map[o] - 1;
+			else if(cic->matrix_rows != 0)
+				coef = cic->matrix[o][i];
+			else
+				coef = o == i;
+			coef *= pow(10, cic->mic_gain[i] / 20);
+			if(cic->mic_gain[i] != 0)
+				cic->mix = 1;
+			cic->mix_coefs[o * cic->mics + i] = (int32_t)lrint(coef * (1 << MIX_SHIFT));
+		}
+	}
 }
 
-static int cic_prepare(snd_pcm_ioplug_t *io) {
-	snd_pcm_cic_filter_t *cic = io->private_data;
-	cic->ptr = 0;
-	return snd_pcm_prepare(cic->slave);
+static void setup_mix(snd_pcm_cic_filter_t *cic, unsigned int channels) {
+	mix_coefs(cic, channels);
+	cic->ramp = 0;
+	memset(cic->dc_est, 0, sizeof(cic->dc_est));
 }
 
-static int cic_poll_descriptors_count(snd_pcm_ioplug_t *io) {
-	snd_pcm_cic_filter_t *cic = io->private_data;
-	return snd_pcm_poll_descriptors_count(cic->slave);
+/*
+ * Values of the controls changed since the last block. The new mixing
+ * coefficients ramp in over the next block, the settle window applies to
+ * the next discard, after a start or an overrun.
+ */
+static void apply_controls(snd_pcm_cic_filter_t *cic, unsigned int channels) {
+	cic_ctl *ctl = cic->ctl;
+	uint32_t gen = __atomic_load_n(&ctl->hdr.gen, __ATOMIC_ACQUIRE);
+	unsigned int i;
+	int32_t gain;
+	int room;
+
+	if(gen == cic->ctl_gen)
+		return;
+	cic->ctl_gen = gen;
+
+	for(i = 0; i < MAX_PCM_CHANNELS; i++) {
+		gain = ctl->mic_gain[i];
+		if(gain < CIC_CTL_GAIN_MIN)
+			gain = CIC_CTL_GAIN_MIN;
+		else if(gain > CIC_CTL_GAIN_MAX)
+			gain = CIC_CTL_GAIN_MAX;
+		cic->mic_gain[i] = gain / 10.0;
+		cic->map[i] = ctl->map[i];
+	}
+
+	if(ctl->settle_us != cic->delay && ctl->settle_us <= CIC_CTL_SETTLE_MAX) {
+		cic->delay = ctl->settle_us;
+		cic->iterations = (int)ceil((double)cic->delay * cic->io.rate / 1000000 / cic->out_period_size);
+		cic->prime_iterations = (PRIME_FRAMES + cic->out_period_size - 1) / cic->out_period_size;
+		/* the slave keeps its buffer until hw_params, the discard has to fit beside the app buffer */
+		room = (int)(cic->slave_buffer / cic->in_period_size) -
+		       (int)((cic->io.buffer_size + cic->out_period_size - 1) / cic->out_period_size);
+		if(cic->slave != NULL && cic->iterations > room)
+			cic->iterations = room > 0 ? room : 0;
+	}
+
+	memcpy(cic->ramp_coefs, cic->mix_coefs, sizeof(cic->ramp_coefs));
+	mix_coefs(cic, channels);
+	cic->ramp = 1;
 }
 
-static int cic_poll_descriptors(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int space) {
-	snd_pcm_cic_filter_t *cic = io->private_data;
-	return snd_pcm_poll_descriptors(cic->slave, pfd, space);
+/*
+ * Single pass from the decoder outputs to the app buffer: dc removal and
+ * gain of every mic, then each app channel as a weighted sum of the mics.
+ */
+static void mix_pcm_groups(snd_pcm_cic_filter_t *cic, const pcm_dest_t *dest,
+			   unsigned int channels, snd_pcm_uframes_t frames) {
+	const int32_t *pdm_samples[MAX_PDM_GROUPS];
+	int64_t in[MAX_PCM_CHANNELS];
+	int32_t ramp[MAX_PCM_CHANNELS * MAX_PCM_CHANNELS];
+	const int32_t *coefs;
+	unsigned int g, i, o, k, mics = cic->mics;
+	snd_pcm_uframes_t j;
+	int64_t acc;
+
+	for(g = 0; g < cic->groups; g++)
+		pdm_samples[g] = group_output(cic, g);
+
+	for(j = 0; j < frames; j++) {
+		for(i = 0; i < mics; i++) {
+			in[i] = pdm_samples[i / PDM_CHANNELS][j * PDM_CHANNELS + i % PDM_CHANNELS];
+			if(cic->dc_block) {
+				in[i] -= cic->dc_est[i] >> DC_BLOCK_SHIFT;
+				cic->dc_est[i] += in[i];
+			}
+		}
+
+		coefs = cic->mix_coefs;
+		/* linear from the last coefficients to the new ones */
+		if(cic->ramp) {
+			for(k = 0; k < channels * mics; k++)
+				ramp[k] = cic->ramp_coefs[k] + (int32_t)((int64_t)(cic->mix_coefs[k] - cic->ramp_coefs[k]) *
+									 (int64_t)j / (int64_t)frames);
+			coefs = ramp;
+		}
+		for(o = 0; o < channels; o++, coefs += mics) {
+			acc = 0;
+			for(i = 0; i < mics; i++)
+				acc += coefs[i] * in[i];
+			acc >>= MIX_SHIFT;
+			if(acc > INT32_MAX)
+				acc = INT32_MAX;
+			else if(acc < INT32_MIN)
+				acc = INT32_MIN;
+			dest->addr[o][j * dest->step[o]] = (int32_t)acc;
+		}
+	}
+	cic->ramp = 0;
 }
 
-static int cic_poll_revents(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int nfds, unsigned short *revents) {
+/* Read one slave period and write the decoded block to dest. */
+static snd_pcm_sframes_t decode_block(snd_pcm_cic_filter_t *cic, unsigned int channels,
+				      const pcm_dest_t *dest) {
+	snd_pcm_sframes_t slave_frames;
+	pcm_dest_t buf;
+	uint64_t t0;
+
+	if(cic->ctl != NULL)
+		apply_controls(cic, channels);
+
+	/*Read from the slave and saved to the afe input buffer.*/
+	slave_frames = read_pdm_groups(cic);
+	if(slave_frames < 0)
+		return slave_frames;
+	/*Save to the app buffer.*/
+	t0 = cic_stats_now();
+	/*This work but the porcentage table with the -vv parameters doesnt work.*/
+	if (cic->rs != NULL) {
+		interleaved_dest(&buf, cic->pcm_buffer, channels);
+		if (cic->ramp || (cic->mix && !cic->diagonal))
+			mix_pcm_groups(cic, &buf, channels, cic->dec_period_size);
+		else if (cic->mix)
+			gain_pcm_groups(cic, &buf, channels, cic->dec_period_size);
+		else
+			merge_pcm_groups(cic, &buf, channels, cic->dec_period_size);
+		/* the resampler writes interleaved frames only */
+		if (dest->interleaved) {
+			pcm_resampler_process(cic->rs, (int32_t *)cic->pcm_buffer, dest->addr[0]);
+		} else {
+			pcm_resampler_process(cic->rs, (int32_t *)cic->pcm_buffer, (int32_t *)cic->carry);
+			copy_to_dest(dest, (int32_t *)cic->carry, channels, cic->out_period_size);
+		}
+	} else if (cic->ramp || (cic->mix && !cic->diagonal))
+		mix_pcm_groups(cic, dest, channels, cic->out_period_size);
+	else if (cic->mix)
+		gain_pcm_groups(cic, dest, channels, cic->out_period_size);
+	else if (dest->interleaved && channels == PDM_CHANNELS && cic->groups == 1)
+		memcpy(dest->addr[0], group_output(cic, 0), cic->out_period_size * PDM_CHANNELS * FORMAT);
+	else
+		merge_pcm_groups(cic, dest, channels, cic->out_period_size);
+	cic->rec.time_ns[CIC_STAT_COPY] = cic_stats_now() - t0;
+	cic->rec.slave_avail = cic->share != NULL ? shared_avail(cic) : snd_pcm_avail_update(cic->slave);
+	account_period(cic, 0);
+
+	return slave_frames;
+}
+
+/*
+ * Any number of frames is read: first what is left of the last block, then
+ * whole blocks decoded straight to the app buffer, and a last block decoded
+ * to the carry buffer when the app wants less than a block. The app buffer
+ * is written through its areas, interleaved or one buffer per channel, and
+ * in mmap mode it is the mmap area itself.
+ */
+static snd_pcm_sframes_t cic_transfer(snd_pcm_ioplug_t *io, const snd_pcm_channel_area_t *areas,
+				      snd_pcm_uframes_t offset, snd_pcm_uframes_t size) {
 	snd_pcm_cic_filter_t *cic = io->private_data;
-	return snd_pcm_poll_descriptors_revents(cic->slave, pfd, nfds, revents);
+	pcm_dest_t dest, carry;
+	snd_pcm_sframes_t err = 0;
+	snd_pcm_uframes_t n, pos, skip, done = 0;
+	snd_pcm_uframes_t tstamp_avail;
+
+	/*
+	 * In mmap mode every avail update passes the whole uncommitted part of
+	 * the buffer, skip the frames already written there.
+	 */
+	if(io->access == SND_PCM_ACCESS_MMAP_INTERLEAVED || io->access == SND_PCM_ACCESS_MMAP_NONINTERLEAVED) {
+		pos = io->appl_ptr + (offset + io->buffer_size - io->appl_ptr % io->buffer_size) % io->buffer_size;
+		skip = (cic->ptr + cic->boundary - pos) % cic->boundary;
+		if(skip >= size)
+			return 0;
+		offset += skip;
+		size -= skip;
+	}
+
+	err = service_slave(cic, io->channels);
+	if(err < 0)
+		return err;
+
+	/* PCM output */
+	areas_dest(&dest, areas, offset, io->channels);
+
+	while(done < size) {
+		if(cic->carry_frames > 0) {
+			n = size - done < cic->carry_frames ? size - done : cic->carry_frames;
+			copy_to_dest(&dest, (int32_t *)cic->carry + cic->carry_offset * io->channels,
+				     io->channels, n);
+			advance_dest(&dest, io->channels, n);
+			cic->carry_offset += n;
+			cic->carry_frames -= n;
+			done += n;
+			continue;
+		}
+
+		/* the slave is blocking, don't let it wait for a period in nonblock mode */
+		if(io->nonblock) {
+			err = slave_avail(cic);
+			if(err >= 0 && err < (snd_pcm_sframes_t)cic->in_period_size)
+				err = -EAGAIN;
+			if(err < 0)
+				break;
+		}
+
+		if(size - done >= cic->out_period_size) {
+			err = decode_block(cic, io->channels, &dest);
+			if(err < 0)
+				break;
+			advance_dest(&dest, io->channels, cic->out_period_size);
+			done += cic->out_period_size;
+		} else {
+			interleaved_dest(&carry, cic->carry, io->channels);
+			err = decode_block(cic, io->channels, &carry);
+			if(err < 0)
+				break;
+			cic->carry_offset = 0;
+			cic->carry_frames = cic->out_period_size;
+		}
+	}
+
+	/* an error is returned again on the next call when some frames were read */
+	if(done == 0 && err < 0)
+		return err;
+
+	cic->ptr = cic->ptr + done;
+	cic->ptr %= cic->boundary;
+
+	/* slave timestamp of the last captured frame, in the app time base */
+	if(cic->slave != NULL && snd_pcm_htimestamp(cic->slave, &tstamp_avail, &cic->tstamp) == 0) {
+		cic->tstamp_ptr = (cic->ptr + cic->carry_frames +
+				   tstamp_avail * cic->out_period_size / cic->in_period_size) % cic->boundary;
+		if(cic->gap_pending)
+			account_gap(cic, io->rate);
+	}
+
+	return done;
 }
 
-void cic_dump(snd_pcm_ioplug_t *io, snd_output_t *out) {
-	char *filter[] = {
-		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_12),
-		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_16),
-		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_24),
-		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_32),
-		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_48),
-		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_unavailable)
-	};
+static int cic_close(snd_pcm_ioplug_t *io) {
 	snd_pcm_cic_filter_t *cic = io->private_data;
 
-	snd_output_printf(out, "%s\n", io->name);
-	snd_output_printf(out, "Its setup is:\n");
-	snd_pcm_dump_setup(io->pcm, out);
-	snd_output_printf(out, "Filter Settings: \n");
-	snd_output_printf(out, "  Type:             %s\n", filter[cic->type]);
-	snd_output_printf(out, "  Gain:             %f%s\n", cic->gain, cic->gain == 0 ? " (default)" : "");
-	snd_output_printf(out, "  delay:            %u\n", cic->delay);
-	snd_output_printf(out, "  exact delay:      %lu\n", cic->inval_iterations * io->period_size * 1000000 / io->rate);
-	snd_output_printf(out, "  OSR:       %u\n", cic->OSR);
-	snd_output_printf(out, "Slave: ");
-	snd_pcm_dump(cic->slave, out);
+	destroy(&cic);
+	return 0;
 }
 
-static void destroy(snd_pcm_cic_filter_t **cic) {
-	if(*cic != NULL) {
-		if((*cic)->afe != NULL) {
-			deleteAfeCicDecoder((*cic)->afe);
-			free((*cic)->afe);
-			(*cic)->afe = NULL;
+/* The gates follow the slave period and rate, they are cheap to rebuild. */
+static int create_gates(snd_pcm_cic_filter_t *cic) {
+	unsigned int g, hold;
+
+	for(g = 0; g < MAX_PDM_GROUPS; g++) {
+		cic_gate_destroy(cic->gate[g]);
+		cic->gate[g] = NULL;
+	}
+	if(!cic->gate_enabled)
+		return 0;
+
+	hold = ((uint64_t)cic->gate_hold * cic->dec_rate / 1000 + cic->dec_period_size - 1) /
+	       cic->dec_period_size;
+	for(g = 0; g < cic->groups; g++) {
+		cic->gate[g] = cic_gate_create(cic->in_period_size, pdm_slave_rate(cic->OSR, cic->dec_rate),
+					       cic->gate_threshold, hold);
+		if(cic->gate[g] == NULL) {
+			SNDERR("Cannot allocate the gate");
+			return -ENOMEM;
 		}
-		if((*cic)->slave != NULL) {
-			snd_pcm_close((*cic)->slave);
-			(*cic)->slave = NULL;
+	}
+
+	return 0;
+}
+
+/*
+ * One decoder for each group of 4 pdm channels, for blocks of
+ * dec_period_size. The decoders built by a previous call are kept when
+ * their type, gain and block size are the same, only missing groups are
+ * added then.
+ */
+static int create_decoders(snd_pcm_cic_filter_t *cic) {
+	/* The Cic Decoder request to divide the samples by 16. */
+	unsigned int samples_per_channel = cic->dec_period_size / 16;
+	unsigned int g;
+	float gain;
+	int err;
+
+	/* refine the gain 1 ~ 101.0 */
+	gain = (1 + cic->gain) * (double)(1 << 30) / pow(cic->OSR/4, 5);
+
+	if(cic->built_type != cic->type || cic->built_builtin != cic->builtin ||
+	   cic->built_gain != gain || cic->built_block != cic->dec_period_size) {
+		for(g = 0; g < cic->built_groups; g++)
+			if(!cic->built_builtin)
+				deleteAfeCicDecoder(cic->afe[g]);
+		cic->built_groups = 0;
+	}
+
+	/* Init the decoder objects */
+	for(g = cic->built_groups; g < cic->groups; g++) {
+		if(cic->builtin) {
+			cic_decimator_destroy(cic->dec[g]);
+			cic->dec[g] = cic_decimator_create(cic->OSR, PDM_CHANNELS, cic->dec_period_size, gain);
+			if (cic->dec[g] == NULL) {
+				SNDERR("Fail to create the built-in decoder");
+				cic->built_groups = g;
+				return SWPDM_ERR;
+			}
+			continue;
+		}
+
+		err = constructAfeCicDecoder(cic->type, cic->afe[g], gain, samples_per_channel);
+		if (err == false) {
+			SNDERR("Fail to create AfeCicDecoder");
+			cic->built_groups = g;
+			return SWPDM_ERR;
+		}
+	}
+	if(cic->groups > cic->built_groups)
+		cic->built_groups = cic->groups;
+	cic->built_type = cic->type;
+	cic->built_builtin = cic->builtin;
+	cic->built_gain = gain;
+	cic->built_block = cic->dec_period_size;
+
+	/* These values are in frame size. */
+	if(cic->builtin) {
+		cic->in_period_size = cic->dec[0]->inputBufferSizePerChannel;
+		cic->out_period_size = cic->dec[0]->outputBufferSizePerChannel;
+	} else {
+		cic->in_period_size = cic->afe[0]->inputBufferSizePerChannel;
+		cic->out_period_size = cic->afe[0]->outputBufferSizePerChannel;
+	}
+	if(cic->out_period_size != cic->dec_period_size) {
+		SNDERR("Mismatch on AfeCicDecoder output buffer size and decoder block size %lu.",
+		       cic->dec_period_size);
+		return SWPDM_ERR;
+	}
+
+	return create_gates(cic);
+}
+
+/*
+ * Slave periods of a buffer of at least min_periods, deeper when set with
+ * slave_periods or slave_buffer_time, whatever the app buffer.
+ */
+static unsigned int slave_periods(snd_pcm_cic_filter_t *cic, unsigned int min_periods) {
+	unsigned int periods = min_periods, n;
+
+	if(cic->slave_periods > periods)
+		periods = cic->slave_periods;
+	if(cic->slave_buffer_time != 0) {
+		n = (unsigned int)ceil((double)cic->slave_buffer_time * pdm_slave_rate(cic->OSR, cic->dec_rate) /
+				       1000000 / cic->in_period_size);
+		if(n > periods)
+			periods = n;
+	}
+
+	return periods;
+}
+
+/*
+ * The slave runs at the pdm rate of dec_rate, one period of in_period_size
+ * per decoder block, as many as it takes up to periods. Its hw params are
+ * kept by cic_hw_free() and only set again when they change.
+ */
+static int configure_slave(snd_pcm_cic_filter_t *cic, unsigned int min_periods, unsigned int periods) {
+	snd_pcm_uframes_t buffer = cic->in_period_size * periods;
+	snd_pcm_format_t format;
+	unsigned int refine_rate;
+	int err;
+
+	if(cic->slave_period == cic->in_period_size && cic->slave_buffer == buffer &&
+	   cic->slave_rate == cic->dec_rate && cic->slave_channels == cic->groups * PDM_CHANNELS &&
+	   snd_pcm_state(cic->slave) != SND_PCM_STATE_OPEN)
+		return 0;
+	cic->slave_period = 0;
+
+	if(cic->slave_params == NULL) {
+		err = snd_pcm_hw_params_malloc(&cic->slave_params);
+		if (err < 0)
+			return err;
+	}
+
+	err = snd_pcm_hw_params_any(cic->slave, cic->slave_params);
+	if (err < 0) {
+		SNDERR("Broken configuration for capture: no configurations available: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* set the interleaved read/write format */
+	err = snd_pcm_hw_params_set_access(cic->slave, cic->slave_params, SND_PCM_ACCESS_MMAP_INTERLEAVED );
+	if (err < 0) {
+		SNDERR("Access type not available for capture: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* set channels */
+	err = snd_pcm_hw_params_set_channels(cic->slave, cic->slave_params, cic->groups * PDM_CHANNELS);
+	if (err < 0) {
+		SNDERR("Unable to set numbers of channels: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	format = SND_PCM_FORMAT_DSD_U32_LE;
+	refine_rate = pdm_slave_rate(cic->OSR, cic->dec_rate);
+	if (refine_rate == 0) {
+		SNDERR("Unsupported OSR: %d\n", cic->OSR);
+		return -EINVAL;
+	}
+
+	if (refine_rate * snd_pcm_format_width(format) > MAX_PDM_CLOCK) {
+		SNDERR("max frequency can't exceed 4.8MHz\n");
+		return -EINVAL;
+	}
+
+	/* set the sample format */
+	err = snd_pcm_hw_params_set_format(cic->slave, cic->slave_params, format);
+	if (err < 0) {
+		SNDERR("Sample format not available for capture: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_rate(cic->slave, cic->slave_params, refine_rate, 0);
+	if(err < 0) {
+		SNDERR("Unable to set rate: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* set period size */
+	err = snd_pcm_hw_params_set_period_size(cic->slave, cic->slave_params, cic->in_period_size, 0);
+	if (err < 0) {
+		SNDERR("Unable to set period time\n");
+		return err;
+	}
+
+	/* at least the app buffer, as deep as the slave allows up to periods */
+	err = snd_pcm_hw_params_set_periods_min(cic->slave, cic->slave_params, &min_periods, NULL);
+	err = err == 0 ? snd_pcm_hw_params_set_periods_near(cic->slave, cic->slave_params, &periods, NULL) : err;
+	if (err < 0) {
+		SNDERR("Unable to set buffer size.\n");
+		return err;
+	}
+
+	err = snd_pcm_hw_params(cic->slave, cic->slave_params);
+	if(err < 0) {
+		SNDERR("Couldnt set hw params\n");
+		return err;
+	}
+
+	cic->slave_rate = cic->dec_rate;
+	cic->slave_channels = cic->groups * PDM_CHANNELS;
+	cic->slave_period = cic->in_period_size;
+	cic->slave_buffer = buffer;
+
+	return err;
+}
+
+/*
+ * In rt mode the working buffers of a setup are cut from one locked arena,
+ * reserved for all of them before the first one is taken.
+ */
+static int rt_reserve(snd_pcm_cic_filter_t *cic, size_t size) {
+	if(!cic->rt)
+		return 0;
+
+	if(cic->arena != NULL && cic->arena->size >= size) {
+		rt_arena_reset(cic->arena);
+		return 0;
+	}
+
+	rt_arena_destroy(cic->arena);
+	cic->arena = rt_arena_create(size, cic->rt_huge ? RT_ARENA_HUGE : 0);
+	if(cic->arena == NULL)
+		return -ENOMEM;
+	if(!cic->arena->locked)
+		SNDERR("WARNING: rt buffers not locked: %s", strerror(cic->arena->lock_err));
+
+	return 0;
+}
+
+/* Bytes of the working buffers of the setup done by cic_hw(). */
+static size_t working_set(snd_pcm_cic_filter_t *cic, unsigned int channels, unsigned int rate) {
+	size_t size = rt_arena_block(cic->out_period_size * channels * FORMAT);
+
+	if(cic->dec_rate != rate)
+		size += rt_arena_block(cic->dec_period_size * channels * FORMAT);
+	if(cic->share != NULL)
+		size += cic->groups * rt_arena_block(cic->dec_period_size * PDM_CHANNELS * FORMAT);
+	else if(cic->groups > 1)
+		size += rt_arena_block(cic->in_period_size * cic->groups * PDM_CHANNELS * FORMAT);
+
+	return size;
+}
+
+static void rt_lock_buffer(snd_pcm_cic_filter_t *cic, void *addr, size_t size) {
+	int err;
+
+	if(addr == NULL || cic->nlocked == RT_LOCKED_MAX)
+		return;
+
+	err = rt_lock(addr, size);
+	if(err < 0)
+		cic->lock_err = -err;
+	cic->locked[cic->nlocked].addr = addr;
+	cic->locked[cic->nlocked].size = size;
+	cic->nlocked++;
+}
+
+static void rt_unlock_buffers(snd_pcm_cic_filter_t *cic) {
+	unsigned int i;
+
+	for(i = 0; i < cic->nlocked; i++)
+		rt_unlock(cic->locked[i].addr, cic->locked[i].size);
+	cic->nlocked = 0;
+	cic->lock_err = 0;
+}
+
+/*
+ * Faults in and locks what the decoders, gates and resampler allocated
+ * themselves, the afe buffers of libimxswpdm included.
+ */
+static void rt_lock_buffers(snd_pcm_cic_filter_t *cic) {
+	size_t in_size = cic->in_period_size * PDM_CHANNELS * FORMAT;
+	size_t out_size = cic->dec_period_size * PDM_CHANNELS * FORMAT;
+	unsigned int g;
+
+	rt_unlock_buffers(cic);
+	if(!cic->rt)
+		return;
+
+	for(g = 0; g < cic->groups && cic->share == NULL; g++) {
+		rt_lock_buffer(cic, group_input(cic, g), in_size);
+		rt_lock_buffer(cic, group_output(cic, g), out_size);
+		if(cic->gate[g] != NULL)
+			rt_lock_buffer(cic, cic->gate[g]->prev, in_size);
+	}
+	if(cic->rs != NULL) {
+		rt_lock_buffer(cic, cic->rs->coefs, cic->rs->up * cic->rs->taps * sizeof(float));
+		rt_lock_buffer(cic, cic->rs->history,
+			       (cic->rs->taps - 1 + cic->rs->in_frames) * cic->rs->channels * sizeof(float));
+	}
+}
+
+/* Grow or shrink a buffer, kept as is when its size doesn't change. */
+static int resize_buffer(snd_pcm_cic_filter_t *cic, unsigned int **buf, size_t size) {
+	unsigned int *p;
+
+	if(cic->arena != NULL) {
+		*buf = rt_arena_alloc(cic->arena, size);
+		return *buf == NULL ? -ENOMEM : 0;
+	}
+
+	p = realloc(*buf, size);
+	if(p == NULL)
+		return -ENOMEM;
+	*buf = p;
+
+	return 0;
+}
+
+/* Group outputs the client copies the shared frames to. */
+static int share_buffers(snd_pcm_cic_filter_t *cic) {
+	unsigned int g;
+
+	for(g = 0; g < cic->groups; g++) {
+		if(cic->arena != NULL) {
+			cic->share_out[g] = rt_arena_alloc(cic->arena, cic->dec_period_size * PDM_CHANNELS * FORMAT);
+			if(cic->share_out[g] == NULL)
+				return -ENOMEM;
+			continue;
+		}
+		free(cic->share_out[g]);
+		cic->share_out[g] = calloc(cic->dec_period_size * PDM_CHANNELS, FORMAT);
+		if(cic->share_out[g] == NULL)
+			return -ENOMEM;
+	}
+	cic->in_period_size = cic->dec_period_size;
+
+	return 0;
+}
+
+static int cic_hw(snd_pcm_ioplug_t *io, snd_pcm_hw_params_t *params) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	unsigned int rate, periods;
+	int err;
+	int dir;
+
+	/* set stream rate */
+	err = snd_pcm_hw_params_get_rate(params, &rate, &dir);
+	if (err < 0) {
+		SNDERR("unable to get device rate\n");
+		return err;
+	}
+
+	/* One afe decoder for each group of 4 pdm channels. */
+	cic->mics = cic->matrix_rows != 0 ? cic->matrix_cols : io->channels;
+	cic->groups = (cic->mics + PDM_CHANNELS - 1) / PDM_CHANNELS;
+	setup_mix(cic, io->channels);
+
+	/* Rates the decoders or the slave can't produce go through the resampler. */
+	cic->dec_rate = dec_rate_for(cic, rate, cic->groups);
+	cic->dec_period_size = cic->dec_rate != 0 ? decoder_block(cic->OSR, cic->dec_rate, rate, io->period_size,
+								   slave_max_period(cic, cic->groups)) : 0;
+	if (cic->dec_period_size == 0) {
+		SNDERR("Rate %u can't be produced with OSR %u\n", rate, cic->OSR);
+		return -EINVAL;
+	}
+
+	if(cic->share != NULL) {
+		if(cic->mics > cic->share->channels) {
+			SNDERR("The share %s has only %u mics", cic->share_name, cic->share->channels);
+			return -EINVAL;
+		}
+	} else {
+		err = create_decoders(cic);
+		if(err < 0)
+			return err;
+	}
+	cic->out_period_size = cic->dec_period_size * rate / cic->dec_rate;
+
+	err = rt_reserve(cic, working_set(cic, io->channels, rate));
+	if(err < 0)
+		return err;
+	if(cic->share != NULL) {
+		err = share_buffers(cic);
+		if(err < 0)
+			return err;
+	}
+
+	cic->carry_frames = 0;
+	err = resize_buffer(cic, &cic->carry, cic->out_period_size * io->channels * FORMAT);
+	if(err < 0)
+		return err;
+
+	/* the resampler only depends on the rates and the block */
+	if(cic->rs != NULL && (cic->dec_rate == rate || cic->rs->channels != io->channels ||
+	   cic->rs->in_frames != cic->dec_period_size || cic->rs->out_frames != cic->out_period_size)) {
+		pcm_resampler_destroy(cic->rs);
+		cic->rs = NULL;
+	}
+	if(cic->dec_rate != rate) {
+		if(cic->rs == NULL)
+			cic->rs = pcm_resampler_create(io->channels, cic->dec_rate, rate, cic->dec_period_size);
+		err = resize_buffer(cic, &cic->pcm_buffer, cic->dec_period_size * io->channels * FORMAT);
+		if(cic->rs == NULL || err < 0) {
+			SNDERR("Unable to create the %u to %u resampler", cic->dec_rate, rate);
+			return -ENOMEM;
+		}
+	}
+
+	cic->group_delay = decoding_delay(cic, rate);
+
+	/* the owner of the share settles the decoders */
+	if(cic->share != NULL) {
+		rt_lock_buffers(cic);
+		return 0;
+	}
+
+	if(cic->groups > 1) {
+		err = resize_buffer(cic, &cic->pdm_buffer, cic->in_period_size * cic->groups * PDM_CHANNELS * FORMAT);
+		if(err < 0)
+			return err;
+
+		err = start_worker(cic);
+		if(err < 0) {
+			SNDERR("Unable to start the decoder thread: %s\n", snd_strerror(err));
+			return err;
+		}
+	}
+
+	if(cic->delay != 0) {
+		if(compute_delay(params, cic) < 0)
+			SNDERR("WARNING: Unable to set requested delay");
+	}
+
+	/* set the buffer size, at least as long as the app one and the settling periods waiting to be dropped */
+	snd_pcm_hw_params_get_periods(params, &periods, &dir);
+	if(periods < (io->buffer_size + cic->out_period_size - 1) / cic->out_period_size)
+		periods = (io->buffer_size + cic->out_period_size - 1) / cic->out_period_size;
+	periods += cic->iterations;
+	err = configure_slave(cic, periods, slave_periods(cic, periods));
+	if(err < 0)
+		return err;
+
+	/* catch-up watermarks in slave frames, the low one is an app period */
+	cic->catchup_high = 0;
+	if(cic->catchup_time != 0) {
+		cic->catchup_low = (io->period_size + cic->out_period_size - 1) / cic->out_period_size * cic->in_period_size;
+		cic->catchup_high = (snd_pcm_uframes_t)((double)cic->catchup_time *
+							pdm_slave_rate(cic->OSR, cic->dec_rate) / 1000000);
+		if(cic->catchup_high < cic->catchup_low + cic->in_period_size)
+			cic->catchup_high = cic->catchup_low + cic->in_period_size;
+	}
+
+	rt_lock_buffers(cic);
+
+	return err;
+}
+
+/*
+ * Decoders, buffers, worker and slave setup are kept for the next
+ * hw_params, which only redoes what changed, and released on close.
+ */
+static int cic_hw_free(snd_pcm_ioplug_t *io) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+
+	if(cic->slave != NULL)
+		snd_pcm_drop(cic->slave);
+	cic->carry_frames = 0;
+	return 0;
+}
+
+static int cic_sw(snd_pcm_ioplug_t *io, snd_pcm_sw_params_t *params) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	snd_pcm_sw_params_t *sparams;
+	int err;
+
+	snd_pcm_sw_params_get_boundary(params, &cic->boundary);
+
+	/* the slave of a share is configured by its owner */
+	if(cic->share != NULL) {
+		err = snd_pcm_sw_params_set_start_threshold(io->pcm, params, cic->in_period_size);
+		return err == 0 ? snd_pcm_sw_params_set_avail_min(io->pcm, params, io->period_size) : err;
+	}
+
+	snd_pcm_sw_params_alloca(&sparams);
+
+	/* get the current swparams */
+	err = snd_pcm_sw_params_current(cic->slave, sparams);
+	if (err < 0) {
+		SNDERR("Unable to determine current swparams for capture: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* start the transfer when the buffer has one period to process: */
+	err = snd_pcm_sw_params_set_start_threshold(cic->slave, sparams, cic->in_period_size);
+	err = err == 0 ? snd_pcm_sw_params_set_start_threshold(io->pcm, params, cic->in_period_size) : err;
+	if (err < 0) {
+		SNDERR("Unable to set start threshold mode for capture: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* allow the transfer when at least period_size samples can be processed */
+	err = snd_pcm_sw_params_set_avail_min(cic->slave, sparams, cic->in_period_size);
+	err = err == 0 ? snd_pcm_sw_params_set_avail_min(io->pcm, params, io->period_size) : err;
+	if (err < 0) {
+		SNDERR("Unable to set avail min for capture: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* timestamps of the slave on the same clock as the plugin ones */
+	snd_pcm_sw_params_set_tstamp_mode(cic->slave, sparams, SND_PCM_TSTAMP_ENABLE);
+#if SND_LIB_VERSION >= 0x01001d
+	snd_pcm_sw_params_set_tstamp_type(cic->slave, sparams, SND_PCM_TSTAMP_TYPE_MONOTONIC);
+#endif
+
+	return snd_pcm_sw_params(cic->slave, sparams);
+}
+
+static int cic_prepare(snd_pcm_ioplug_t *io) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	unsigned int g;
+
+	cic->ptr = 0;
+	cic->carry_frames = 0;
+	/* a fast recovery keeps the filters running across the gap */
+	if(!cic->xrun_pending || cic->recovery_full) {
+		if(cic->rs != NULL)
+			pcm_resampler_reset(cic->rs);
+		memset(cic->dc_est, 0, sizeof(cic->dc_est));
+		for(g = 0; g < MAX_PDM_GROUPS; g++)
+			if(cic->gate[g] != NULL)
+				cic_gate_reset(cic->gate[g]);
+	}
+	/* a stream prepared again, not after an overrun, settles again from scratch */
+	if(!cic->xrun_pending && cic->share == NULL)
+		arm_discard(cic);
+	if(cic->xrun_pending) {
+		cic_stats_begin(cic->stats);
+		cic->stats->recoveries++;
+		cic_stats_end(cic->stats);
+		cic->xrun_pending = 0;
+	}
+	if(cic->share != NULL) {
+		cic->share_pos = cic_share_write_pos(cic->share);
+		return 0;
+	}
+	return snd_pcm_prepare(cic->slave);
+}
+
+/* Wake the clients of a share up once per block, the ring has no fd to poll. */
+static void arm_share_timer(snd_pcm_cic_filter_t *cic, int on) {
+	struct itimerspec its;
+	uint64_t ns = 0;
+
+	if(on)
+		ns = cic->in_period_size * 1000000000ull / cic->dec_rate;
+	its.it_value.tv_sec = its.it_interval.tv_sec = ns / 1000000000;
+	its.it_value.tv_nsec = its.it_interval.tv_nsec = ns % 1000000000;
+	timerfd_settime(cic->share_timer, 0, &its, NULL);
+}
+
+static int cic_poll_descriptors_count(snd_pcm_ioplug_t *io) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	if(cic->share != NULL)
+		return 1;
+	return snd_pcm_poll_descriptors_count(cic->slave);
+}
+
+static int cic_poll_descriptors(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int space) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	if(cic->share != NULL) {
+		if(space < 1)
+			return -EINVAL;
+		pfd->fd = cic->share_timer;
+		pfd->events = POLLIN;
+		pfd->revents = 0;
+		return 1;
+	}
+	return snd_pcm_poll_descriptors(cic->slave, pfd, space);
+}
+
+/* POLLIN once a whole app period is decoded or can be, POLLERR on a slave overrun. */
+static int cic_poll_revents(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int nfds, unsigned short *revents) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	snd_pcm_sframes_t avail;
+	uint64_t expirations;
+	int err = 0;
+
+	if(cic->share != NULL) {
+		*revents = nfds > 0 ? pfd->revents : 0;
+		if((*revents & POLLIN) && read(cic->share_timer, &expirations, sizeof(expirations)) < 0)
+			*revents &= ~POLLIN;
+	} else
+		err = snd_pcm_poll_descriptors_revents(cic->slave, pfd, nfds, revents);
+	if(err < 0 || !(*revents & POLLIN))
+		return err;
+
+	avail = slave_avail(cic);
+	if(avail < 0)
+		*revents |= POLLERR;
+	else if(avail / cic->in_period_size * cic->out_period_size + cic->carry_frames < io->period_size)
+		*revents &= ~POLLIN;
+
+	return 0;
+}
+
+void cic_dump(snd_pcm_ioplug_t *io, snd_output_t *out) {
+	char *filter[] = {
+		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_12),
+		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_16),
+		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_24),
+		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_32),
+		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_48),
+		str(CIC_pdmToPcmType_cic_order_5_cic_downsample_unavailable)
+	};
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	unsigned int g;
+
+	snd_output_printf(out, "%s\n", io->name);
+	snd_output_printf(out, "Its setup is:\n");
+	snd_pcm_dump_setup(io->pcm, out);
+	snd_output_printf(out, "Filter Settings: \n");
+	snd_output_printf(out, "  Decoder:          %s\n", cic->builtin ? "builtin" : "imx");
+	snd_output_printf(out, "  Type:             %s\n", filter[cic->type]);
+	snd_output_printf(out, "  Gain:             %f%s\n", cic->gain, cic->gain == 0 ? " (default)" : "");
+	snd_output_printf(out, "  delay:            %u\n", cic->delay);
+	snd_output_printf(out, "  settle:           %s", cic->settle_adaptive ? "adaptive" : "fixed");
+	if(cic->settle_adaptive)
+		snd_output_printf(out, " (%d dB)", cic->settle_threshold);
+	snd_output_printf(out, "\n");
+	snd_output_printf(out, "  recovery:         %s (%d blocks)\n", cic->recovery_full ? "full" : "fast",
+			  recovery_iterations(cic));
+	snd_output_printf(out, "  exact delay:      %lu\n", cic->iterations * cic->out_period_size * 1000000 / io->rate);
+	snd_output_printf(out, "  decoder block:    %lu frames\n", cic->out_period_size);
+	if(cic->slave_periods != 0 || cic->slave_buffer_time != 0)
+		snd_output_printf(out, "  slave buffer:     %lu frames requested\n", cic->slave_buffer);
+	if(cic->catchup_high != 0)
+		snd_output_printf(out, "  catch-up:         above %lu, down to %lu slave frames\n",
+				  cic->catchup_high, cic->catchup_low);
+	snd_output_printf(out, "  group delay:      %ld frames\n", cic->group_delay);
+	snd_output_printf(out, "  last tstamp:      %ld.%09ld at %lu\n", (long)cic->tstamp.tv_sec,
+			  (long)cic->tstamp.tv_nsec, cic->tstamp_ptr);
+	snd_output_printf(out, "  OSR:       %u\n", cic->OSR);
+	if(cic->caps.osr != 0)
+		snd_output_printf(out, "  Slave caps:       rates 0x%x/0x%x, periods %u/%u frames with 4/8 mics (%s)\n",
+				  cic->caps.rates[0], cic->caps.rates[1], cic->caps.max_period[0],
+				  cic->caps.max_period[1], cic->caps_cached ? "cached" : "probed");
+	if(cic->arena != NULL)
+		snd_output_printf(out, "  rt:               %zu KB arena%s %s, %u buffers locked%s%s\n",
+				  cic->arena->size / 1024, cic->arena->huge ? " of huge pages" : "",
+				  cic->arena->locked ? "locked" : "not locked", cic->nlocked,
+				  cic->lock_err != 0 ? ", lock failed: " : "",
+				  cic->lock_err != 0 ? strerror(cic->lock_err) : "");
+	if(cic->mix)
+		snd_output_printf(out, "  Mixing:           %u mics -> %u channels%s\n", cic->mics, io->channels,
+				  cic->dc_block ? ", dc block" : "");
+	if(cic->gate_enabled) {
+		snd_output_printf(out, "  Gate:             %d dB, hold %u ms", cic->gate_threshold, cic->gate_hold);
+		for(g = 0; g < cic->groups; g++) {
+			if(cic->gate[g] == NULL)
+				continue;
+			snd_output_printf(out, ", %s %.1f %.1f %.1f %.1f dB",
+					  cic->gate[g]->state == CIC_GATE_CLOSED ? "idle" : "open",
+					  cic->gate[g]->level[0], cic->gate[g]->level[1],
+					  cic->gate[g]->level[2], cic->gate[g]->level[3]);
+		}
+		snd_output_printf(out, "\n");
+	}
+	if(cic->rs != NULL)
+		snd_output_printf(out, "  Resampler:        %u -> %u (%u/%u)\n", cic->dec_rate, io->rate,
+				  cic->rs->up, cic->rs->down);
+	if(cic->share != NULL)
+		snd_output_printf(out, "  Share:            %s %s, %u Hz %u mics, %llu xruns\n", cic->share_name,
+				  cic->share_owner ? "owner" : "client", cic->share->rate, cic->share->channels,
+				  (unsigned long long)cic->share->xruns);
+	dump_stats(cic, out);
+	if(cic->share_dec != NULL && cic->share_dec->slave != NULL) {
+		snd_output_printf(out, "Shared slave: ");
+		snd_pcm_dump(cic->share_dec->slave, out);
+	} else if(cic->slave != NULL) {
+		snd_output_printf(out, "Slave: ");
+		snd_pcm_dump(cic->slave, out);
+	}
+}
+
+static void dump_stats(snd_pcm_cic_filter_t *cic, snd_output_t *out) {
+	static const char *names[CIC_STAT_TIMES] = { "read", "decode", "copy" };
+	const struct cic_stat_time *t;
+	cic_stats st;
+	unsigned int i, b;
+
+	if(cic_stats_read(cic->stats, &st) < 0) {
+		snd_output_printf(out, "Statistics: busy, try again\n");
+		return;
+	}
+	snd_output_printf(out, "Statistics:%s%s\n", cic->stats_shm ? " shm " : "",
+			  cic->stats_shm ? cic->stats_shm : "");
+	snd_output_printf(out, "  periods:          %llu (%llu discarded)\n",
+			  (unsigned long long)st.periods, (unsigned long long)st.discarded);
+	snd_output_printf(out, "  xruns:            %llu (%llu recovered, %llu frames lost)\n",
+			  (unsigned long long)st.xruns, (unsigned long long)st.recoveries,
+			  (unsigned long long)st.lost_frames);
+	if(cic->gate_enabled)
+		snd_output_printf(out, "  gated:            %llu periods\n", (unsigned long long)st.gated);
+	if(cic->catchup_time != 0)
+		snd_output_printf(out, "  skipped:          %llu periods\n", (unsigned long long)st.caught_up);
+	if(cic->ctl != NULL)
+		snd_output_printf(out, "  controls:         %s (gen %u)\n", cic->ctl_name, cic->ctl_gen);
+	if(cic->trace != NULL)
+		snd_output_printf(out, "  trace:            %s (%llu dropped)\n", cic->trace_file,
+				  (unsigned long long)st.trace_dropped);
+	if(cic->tap != NULL)
+		snd_output_printf(out, "  tap:              %s (%llu periods dropped)\n", cic->tap_file,
+				  (unsigned long long)st.tap_dropped);
+
+	for(i = 0; i < CIC_STAT_TIMES; i++) {
+		t = &st.time[i];
+		if(t->count == 0)
+			continue;
+		snd_output_printf(out, "  %-8s avg %6llu us max %6llu us, <us:", names[i],
+				  (unsigned long long)(t->total_ns / t->count / 1000),
+				  (unsigned long long)(t->max_ns / 1000));
+		for(b = 0; b < CIC_STATS_BUCKETS; b++)
+			if(t->hist[b] != 0)
+				snd_output_printf(out, " %u:%llu", 1u << b, (unsigned long long)t->hist[b]);
+		snd_output_printf(out, "\n");
+	}
+}
+
+static void *worker_thread(void *arg) {
+	snd_pcm_cic_filter_t *cic = arg;
+	unsigned int g;
+
+	for(;;) {
+		sem_wait(&cic->work);
+		if(cic->worker_exit)
+			break;
+		for(g = 1; g < cic->groups; g++)
+			group_process(cic, g);
+		sem_post(&cic->done);
+	}
+
+	return NULL;
+}
+
+static int start_worker(snd_pcm_cic_filter_t *cic) {
+	cpu_set_t cpus;
+	int err;
+
+	if(cic->worker_running)
+		return 0;
+
+	if(sem_init(&cic->work, 0, 0) < 0)
+		return -errno;
+	if(sem_init(&cic->done, 0, 0) < 0) {
+		err = -errno;
+		sem_destroy(&cic->work);
+		return err;
+	}
+
+	cic->worker_exit = 0;
+	err = pthread_create(&cic->worker, NULL, worker_thread, cic);
+	if(err != 0) {
+		sem_destroy(&cic->work);
+		sem_destroy(&cic->done);
+		return -err;
+	}
+
+	if(cic->worker_cpu >= 0) {
+		CPU_ZERO(&cpus);
+		CPU_SET(cic->worker_cpu, &cpus);
+		if(pthread_setaffinity_np(cic->worker, sizeof(cpus), &cpus) != 0)
+			SNDERR("WARNING: Unable to bind the decoder thread to cpu %d", cic->worker_cpu);
+	}
+
+	cic->worker_running = 1;
+	return 0;
+}
+
+static void stop_worker(snd_pcm_cic_filter_t *cic) {
+	if(!cic->worker_running)
+		return;
+
+	cic->worker_exit = 1;
+	sem_post(&cic->work);
+	pthread_join(cic->worker, NULL);
+	sem_destroy(&cic->work);
+	sem_destroy(&cic->done);
+	cic->worker_running = 0;
+}
+
+/* Append the decoded block to the ring, the mics of every group interleaved. */
+static void share_publish(snd_pcm_cic_filter_t *dec, cic_share *sh) {
+	const int32_t *pcm_samples[MAX_PDM_GROUPS];
+	int32_t *frame;
+	unsigned int g, c;
+	snd_pcm_uframes_t j;
+
+	for(g = 0; g < dec->groups; g++)
+		pcm_samples[g] = group_output(dec, g);
+
+	for(j = 0; j < dec->dec_period_size; j++) {
+		frame = cic_share_frame(sh, sh->write_pos + j);
+		for(c = 0; c < sh->channels; c++)
+			frame[c] = pcm_samples[c / PDM_CHANNELS][j * PDM_CHANNELS + c % PDM_CHANNELS];
+	}
+	cic_share_commit(sh, dec->dec_period_size);
+}
+
+/*
+ * The private pcm decoding the whole slave for the share, without io nor
+ * mixing, set up by the owner at open or by the pcm adopting the share.
+ */
+static int share_decoder(snd_pcm_cic_filter_t *cic) {
+	cic_share *sh = cic->share;
+	snd_pcm_cic_filter_t *dec;
+	unsigned int g;
+	int err;
+
+	dec = calloc(1, sizeof(*dec));
+	if(dec == NULL)
+		return -ENOMEM;
+	cic->share_dec = dec;
+	for(g = 0; g < MAX_PDM_GROUPS; g++) {
+		dec->afe[g] = calloc(1, sizeof(*dec->afe[g]));
+		if(dec->afe[g] == NULL)
+			return -ENOMEM;
+	}
+
+	dec->type = cic->type;
+	dec->OSR = sh->osr;
+	dec->builtin = cic->builtin;
+	dec->worker_cpu = cic->worker_cpu;
+	dec->gain = cic->gain;
+	dec->gate_enabled = cic->gate_enabled;
+	dec->gate_threshold = cic->gate_threshold;
+	dec->gate_hold = cic->gate_hold;
+	dec->mics = sh->channels;
+	dec->groups = (dec->mics + PDM_CHANNELS - 1) / PDM_CHANNELS;
+	dec->dec_rate = sh->rate;
+	dec->dec_period_size = sh->block;
+	dec->iterations = (int)ceil((double)cic->delay * sh->rate / 1000000 / sh->block);
+	dec->prime_iterations = (PRIME_FRAMES + sh->block - 1) / sh->block;
+	dec->recovery_full = cic->recovery_full;
+	dec->slave_periods = cic->slave_periods;
+	dec->slave_buffer_time = cic->slave_buffer_time;
+	dec->rt = cic->rt;
+	dec->rt_huge = cic->rt_huge;
+	dec->stats = cic_stats_open(NULL);
+	if(dec->stats == NULL)
+		return -ENOMEM;
+
+	err = create_decoders(dec);
+	if(err < 0)
+		return err;
+
+	err = rt_reserve(dec, rt_arena_block(dec->in_period_size * dec->groups * PDM_CHANNELS * FORMAT));
+	if(err < 0)
+		return err;
+	rt_lock_buffers(dec);
+
+	if(dec->groups > 1) {
+		err = resize_buffer(dec, &dec->pdm_buffer, dec->in_period_size * dec->groups * PDM_CHANNELS * FORMAT);
+		if(err < 0)
+			return err;
+		err = start_worker(dec);
+		if(err < 0)
+			return err;
+	}
+
+	err = snd_pcm_open(&dec->slave, cic->share_slave, SND_PCM_STREAM_CAPTURE, 0);
+	if(err < 0) {
+		SNDERR("Cant open slave");
+		return err;
+	}
+	return configure_slave(dec, SHARE_SLAVE_PERIODS, slave_periods(dec, SHARE_SLAVE_PERIODS));
+}
+
+/*
+ * Every pcm of the share runs this thread. The one of the owner decodes
+ * the slave for all of them while at least one is started, the slave is
+ * stopped in between. The others wait for the owner to leave or die, the
+ * first one to notice adopts the share and decodes from then on. An
+ * overrun restarts the slave and the settling discard, the clients see a
+ * gap in the stream and overrun themselves if it is too long.
+ */
+static void *share_thread(void *arg) {
+	struct timespec ts = { 0, SHARE_BLOCK_MS * 1000000 };
+	snd_pcm_cic_filter_t *cic = arg;
+	cic_share *sh = cic->share;
+	snd_pcm_cic_filter_t *dec;
+	snd_pcm_sframes_t frames;
+	int discard = 0, restart = 1, settle = 1;
+	int err;
+
+	while(!__atomic_load_n(&cic->share_exit, __ATOMIC_ACQUIRE)) {
+		if(!cic->share_owner) {
+			if(!cic_share_adopt(sh)) {
+				nanosleep(&ts, NULL);
+				continue;
+			}
+			cic->share_owner = 1;
+			err = share_decoder(cic);
+			if(err < 0) {
+				SNDERR("Unable to take the share %s over: %s", cic->share_name, snd_strerror(err));
+				goto fail;
+			}
+			restart = 1;
+		}
+		dec = cic->share_dec;
+
+		if(!cic_share_started(sh)) {
+			if(!restart)
+				snd_pcm_drop(dec->slave);
+			restart = 1;
+			settle = 1;
+			nanosleep(&ts, NULL);
+			continue;
+		}
+
+		if(restart) {
+			if(snd_pcm_prepare(dec->slave) < 0 || snd_pcm_start(dec->slave) < 0)
+				goto fail;
+			/* a slave started again settles fully, after an overrun it may not */
+			if(settle)
+				discard = dec->iterations;
+			restart = 0;
+			settle = 0;
+		}
+
+		frames = read_pdm_groups(dec);
+		if(frames == -EPIPE) {
+			__atomic_add_fetch(&sh->xruns, 1, __ATOMIC_RELAXED);
+			dec->xrun_pending = 0;
+			if(discard < recovery_iterations(dec))
+				discard = recovery_iterations(dec);
+			restart = 1;
+			continue;
+		}
+		if(frames < 0) {
+			SNDERR("Shared capture %s stopped: %s", cic->share_name, snd_strerror(frames));
+			goto fail;
+		}
+
+		if(discard > 0)
+			discard--;
+		else
+			share_publish(dec, sh);
+	}
+
+	return NULL;
+
+fail:
+	/* the clients get -ENODEV from now on */
+	__atomic_store_n(&sh->hdr.running, 0, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/*
+ * Attach to the share, the first pcm opened on it becomes its owner: it
+ * opens the slave and decodes it at the share rate on a thread of its own,
+ * once for all the pcms of the share whatever their rate.
+ */
+static int share_open(snd_pcm_cic_filter_t *cic, const char *devname) {
+	unsigned int rate, block;
+	int err;
+
+	rate = cic->share_rate != 0 ? cic->share_rate : pdm_pcm_rate(cic->OSR, 48000);
+	if(pdm_pcm_rate(cic->OSR, rate) != rate) {
+		SNDERR("'share_rate' %u is not decoded with OSR %u", rate, cic->OSR);
+		return -EINVAL;
+	}
+	block = decoder_block(cic->OSR, rate, rate, rate * SHARE_BLOCK_MS / 1000, MAX_IN_PERIOD_SIZE);
+
+	cic->share_slave = strdup(devname);
+	if(cic->share_slave == NULL)
+		return -ENOMEM;
+
+	cic->share = cic_share_attach(cic->share_name, cic->OSR, rate, cic->share_channels, block,
+				      rate * SHARE_RING_MS / 1000 / block * block, &cic->share_owner);
+	if(cic->share == NULL) {
+		SNDERR("Unable to attach to the share %s", cic->share_name);
+		return errno != 0 ? -errno : -ENOMEM;
+	}
+	cic->OSR = cic->share->osr;
+	cic->share_exit = 1;
+
+	cic->share_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(cic->share_timer < 0)
+		return -errno;
+
+	if(cic->share_owner) {
+		err = share_decoder(cic);
+		if(err < 0)
+			return err;
+	}
+
+	cic->share_exit = 0;
+	err = pthread_create(&cic->share_thread, NULL, share_thread, cic);
+	if(err != 0) {
+		cic->share_exit = 1;
+		return -err;
+	}
+
+	return 0;
+}
+
+static void share_close(snd_pcm_cic_filter_t *cic) {
+	unsigned int g;
+
+	if(cic->share != NULL && cic->share_exit == 0) {
+		/* the thread is blocked at most one block in the slave read or its wait */
+		__atomic_store_n(&cic->share_exit, 1, __ATOMIC_RELEASE);
+		pthread_join(cic->share_thread, NULL);
+	}
+	if(cic->share_dec != NULL)
+		destroy(&cic->share_dec);
+	if(cic->share_started)
+		cic_share_start(cic->share, 0);
+	cic->share_started = 0;
+	/* one of the pcms left decodes for the others */
+	cic_share_detach(cic->share, cic->share_name, cic->share_owner);
+	cic->share = NULL;
+	for(g = 0; g < MAX_PDM_GROUPS; g++) {
+		if(cic->arena == NULL)
+			free(cic->share_out[g]);
+		cic->share_out[g] = NULL;
+	}
+	if(cic->share_name != NULL && cic->share_timer >= 0)
+		close(cic->share_timer);
+	free(cic->share_name);
+	cic->share_name = NULL;
+	free(cic->share_slave);
+	cic->share_slave = NULL;
+}
+
+static void destroy(snd_pcm_cic_filter_t **cic) {
+	unsigned int g;
+
+	if(*cic != NULL) {
+		share_close(*cic);
+		stop_worker(*cic);
+		rt_unlock_buffers(*cic);
+		pcm_resampler_destroy((*cic)->rs);
+		/* the working buffers of the rt mode go with the arena */
+		if((*cic)->arena == NULL) {
+			free((*cic)->pdm_buffer);
+			free((*cic)->pcm_buffer);
+			free((*cic)->carry);
+		}
+		rt_arena_destroy((*cic)->arena);
+		cic_trace_close((*cic)->trace);
+		free((*cic)->trace_file);
+		cic_tap_close((*cic)->tap);
+		free((*cic)->tap_file);
+		cic_ctl_close((*cic)->ctl);
+		free((*cic)->ctl_name);
+		cic_stats_close((*cic)->stats, (*cic)->stats_shm);
+		free((*cic)->stats_shm);
+		for(g = 0; g < MAX_PDM_GROUPS; g++) {
+			if((*cic)->afe[g] != NULL) {
+				deleteAfeCicDecoder((*cic)->afe[g]);
+				free((*cic)->afe[g]);
+				(*cic)->afe[g] = NULL;
+			}
+			cic_decimator_destroy((*cic)->dec[g]);
+			(*cic)->dec[g] = NULL;
+			cic_gate_destroy((*cic)->gate[g]);
+			(*cic)->gate[g] = NULL;
+		}
+		free((*cic)->slave_params);
+		if((*cic)->slave != NULL) {
+			snd_pcm_close((*cic)->slave);
+			(*cic)->slave = NULL;
+		}
+		free(*cic);
+		*cic = NULL;
+	}
+}
+
+/*
+ * Rates of the OSR the slave captures with 4 and 8 channels and its
+ * largest periods, from the cache of the slave or probed once by refining
+ * its hw params for every native rate.
+ */
+static int probe_slave(snd_pcm_cic_filter_t *cic, const char *devname) {
+	snd_pcm_hw_params_t *any, *params;
+	unsigned int native[8], n, i, l, rate;
+	snd_pcm_uframes_t period;
+	int dir, err;
+
+	if(cic->caps_cache && cic_caps_lookup(devname, cic->OSR, &cic->caps) == 0) {
+		cic->caps_cached = 1;
+		return 0;
+	}
+
+	snd_pcm_hw_params_alloca(&any);
+	snd_pcm_hw_params_alloca(&params);
+	err = snd_pcm_hw_params_any(cic->slave, any);
+	if(err >= 0)
+		err = snd_pcm_hw_params_set_access(cic->slave, any, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+	if(err >= 0)
+		err = snd_pcm_hw_params_set_format(cic->slave, any, SND_PCM_FORMAT_DSD_U32_LE);
+	if(err < 0) {
+		SNDERR("The slave %s can't capture mmap DSD_U32_LE: %s", devname, snd_strerror(err));
+		return err;
+	}
+
+	memset(&cic->caps, 0, sizeof(cic->caps));
+	n = pdm_native_rates(cic->OSR, native, ARRAY_SIZE(native));
+	for(l = 0; l < CIC_CAPS_LAYOUTS; l++) {
+		snd_pcm_hw_params_copy(params, any);
+		if(snd_pcm_hw_params_set_channels(cic->slave, params, (l + 1) * PDM_CHANNELS) < 0)
+			continue;
+		for(i = 0; i < n; i++) {
+			rate = pdm_slave_rate(cic->OSR, native[i]);
+			if(rate * snd_pcm_format_width(SND_PCM_FORMAT_DSD_U32_LE) > MAX_PDM_CLOCK)
+				continue;
+			if(snd_pcm_hw_params_test_rate(cic->slave, params, rate, 0) == 0)
+				cic->caps.rates[l] |= 1u << i;
+		}
+		if(snd_pcm_hw_params_get_period_size_max(params, &period, &dir) == 0)
+			cic->caps.max_period[l] = period > MAX_IN_PERIOD_SIZE ? MAX_IN_PERIOD_SIZE : period;
+	}
+	cic->caps.osr = cic->OSR;
+
+	if(cic->caps_cache)
+		cic_caps_store(devname, &cic->caps);
+
+	return 0;
+}
+
+/* Whether an app rate can be decoded with groups, resampled or not. */
+static int rate_feasible(snd_pcm_cic_filter_t *cic, unsigned int rate, unsigned int groups) {
+	unsigned int dec_rate = dec_rate_for(cic, rate, groups);
+
+	return dec_rate != 0 && decoder_block(cic->OSR, dec_rate, rate, 0, slave_max_period(cic, groups)) != 0;
+}
+
+static int constrains(snd_pcm_ioplug_t *io) {
+	snd_pcm_cic_filter_t *cic = io->private_data;
+	unsigned int min_channels = MIN_PCM_CHANNELS, max_channels = MAX_PCM_CHANNELS;
+	unsigned int min_groups, max_groups, g, i, count;
+	int err;
+
+	static unsigned int accesses[] = {
+		SND_PCM_ACCESS_RW_INTERLEAVED,
+		SND_PCM_ACCESS_RW_NONINTERLEAVED,
+		SND_PCM_ACCESS_MMAP_INTERLEAVED,
+		SND_PCM_ACCESS_MMAP_NONINTERLEAVED
+	};
+
+	static unsigned int formats[] = {
+		SND_PCM_FORMAT_S32_LE
+	};
+
+	static unsigned int rates[] = {
+		8000, 11025, 16000, 22050, 24000,
+		32000, 44100, 48000, 64000, 88200,
+		96000
+	};
+	unsigned int feasible[ARRAY_SIZE(rates)];
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_ACCESS, ARRAY_SIZE(accesses), accesses);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw access mode");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_FORMAT, ARRAY_SIZE(formats), formats);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw format");
+		return err;
+	}
+
+	/* the matrix sets the number of app channels and of mics */
+	if(cic->matrix_rows != 0) {
+		min_channels = max_channels = cic->matrix_rows;
+		min_groups = max_groups = (cic->matrix_cols + PDM_CHANNELS - 1) / PDM_CHANNELS;
+	} else {
+		if(cic->share != NULL)
+			max_channels = cic->share->channels;
+		min_groups = 1;
+		max_groups = (max_channels + PDM_CHANNELS - 1) / PDM_CHANNELS;
+	}
+
+	/*
+	 * Only the rates every slave layout of the channel range can produce,
+	 * so that hw_params never fails on one of them. The 8 channel layout
+	 * is given up when that leaves none.
+	 */
+	for(;;) {
+		count = 0;
+		for(i = 0; i < ARRAY_SIZE(rates); i++) {
+			for(g = min_groups; g <= max_groups; g++)
+				if(!rate_feasible(cic, rates[i], g))
+					break;
+			if(g > max_groups)
+				feasible[count++] = rates[i];
+		}
+		if(count != 0 || max_groups == min_groups)
+			break;
+		max_groups--;
+	}
+	if(count == 0) {
+		SNDERR("The slave can't capture any rate with OSR %u", cic->OSR);
+		return -EINVAL;
+	}
+	if(cic->matrix_rows == 0 && max_channels > max_groups * PDM_CHANNELS)
+		max_channels = max_groups * PDM_CHANNELS;
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_CHANNELS, min_channels, max_channels);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw channels");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_RATE, count, feasible);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw rates");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIOD_BYTES, MIN_PERIOD_BYTES, MAX_PERIOD_BYTES);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw period bytes");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIODS, 2, MAX_PERIODS);
+	if (err < 0) {
+		SNDERR("ioplug cannot set periods");
+		return err;
+	}
+
+	return err;
+}
+
+/* channel_gain [ dB dB ... ], one calibration gain per mic. */
+static int parse_channel_gain(snd_config_t *conf, snd_pcm_cic_filter_t *cic) {
+	snd_config_iterator_t i, next;
+	unsigned int c = 0;
+	double val;
+
+	if(snd_config_get_type(conf) != SND_CONFIG_TYPE_COMPOUND) {
+		SNDERR("'channel_gain' must be a list of dB values");
+		return -EINVAL;
+	}
+
+	snd_config_for_each(i, next, conf) {
+		if(c == MAX_PCM_CHANNELS) {
+			SNDERR("'channel_gain' has more than %d values", MAX_PCM_CHANNELS);
+			return -EINVAL;
+		}
+		if(snd_config_get_ireal(snd_config_iterator_entry(i), &val) < 0 ||
+		   val < MIC_GAIN_MIN || val > MIC_GAIN_MAX) {
+			SNDERR("'channel_gain' values must be in range of: [%.0fdB, %.0fdB].",
+			       MIC_GAIN_MIN, MIC_GAIN_MAX);
+			return -EINVAL;
+		}
+		cic->mic_gain[c++] = val;
+	}
+
+	return 0;
+}
+
+/* matrix [ [ w w ... ] [ w w ... ] ], one row of mic weights per app channel. */
+static int parse_matrix(snd_config_t *conf, snd_pcm_cic_filter_t *cic) {
+	snd_config_iterator_t i, next, j, jnext;
+	snd_config_t *row;
+	unsigned int r = 0, c;
+	double val;
+
+	if(snd_config_get_type(conf) != SND_CONFIG_TYPE_COMPOUND) {
+		SNDERR("'matrix' must be a list of rows");
+		return -EINVAL;
+	}
+
+	snd_config_for_each(i, next, conf) {
+		row = snd_config_iterator_entry(i);
+		if(r == MAX_PCM_CHANNELS || snd_config_get_type(row) != SND_CONFIG_TYPE_COMPOUND) {
+			SNDERR("'matrix' must have 1 to %d rows of weights", MAX_PCM_CHANNELS);
+			return -EINVAL;
+		}
+
+		c = 0;
+		snd_config_for_each(j, jnext, row) {
+			if(c == MAX_PCM_CHANNELS) {
+				SNDERR("'matrix' rows have more than %d mics", MAX_PCM_CHANNELS);
+				return -EINVAL;
+			}
+			if(snd_config_get_ireal(snd_config_iterator_entry(j), &val) < 0 ||
+			   fabs(val) > MATRIX_COEF_MAX) {
+				SNDERR("'matrix' weights must be in range of: [%.0f, %.0f].",
+				       -MATRIX_COEF_MAX, MATRIX_COEF_MAX);
+				return -EINVAL;
+			}
+			cic->matrix[r][c++] = val;
+		}
+
+		if(c == 0 || (r > 0 && c != cic->matrix_cols)) {
+			SNDERR("'matrix' rows must all have the same number of mics");
+			return -EINVAL;
+		}
+		cic->matrix_cols = c;
+		r++;
+	}
+
+	if(r == 0) {
+		SNDERR("'matrix' has no rows");
+		return -EINVAL;
+	}
+
+	cic->matrix_rows = r;
+	return 0;
+}
+
+static inline int parse_struct(snd_config_t **conf, const char **str, snd_pcm_cic_filter_t *cic) {
+	snd_config_iterator_t i, next;
+	snd_config_t *n;
+	const char *id;
+	long val;
+	int err = 1;
+
+	snd_config_for_each(i, next, *conf) {
+		n = snd_config_iterator_entry(i);
+
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+
+		if ((strcmp(id, "comment") == 0) || (strcmp(id, "type") == 0))
+			continue;
+
+		if(strcmp(id, "slave") == 0) {
+			if(snd_config_get_string(n, str) < 0) {
+				SNDERR("slave must be a string");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if (strcmp(id, "delay") == 0) {
+			if (snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'delay' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 1000 && val <= 1000000)
+				cic->delay = (unsigned int)val;
+			else {
+				SNDERR("'delay' must be in range of: [1,000us, 1,000,000us].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "OSR")==0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'OSR' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			switch (val) {
+			case 48:
+				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_12;
+				cic->OSR = 48;
+				break;
+			case 64:
+				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_16;
+				cic->OSR = 64;
+				break;
+			case 96:
+				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_24;
+				cic->OSR = 96;
+				break;
+			case 128:
+				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_32;
+				cic->OSR = 128;
+				break;
+			case 192:
+				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_48;
+				cic->OSR = 192;
+				break;
+			default:
+				SNDERR("OSR value read %ld\n", val);
+				SNDERR("Valid 'OSR' values are 48, 64, 96, 128, 192.");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "gain") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'gain' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 0 && val <= 100) {
+				cic->gain = (float)val;
+			} else {
+				SNDERR("'gain' must be in range of: [0, 100]. Default set to 0.");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "settle") == 0) {
+			const char *settle;
+			if(snd_config_get_string(n, &settle) < 0) {
+				SNDERR("'settle' must be a string");
+				err = -EINVAL;
+				break;
+			}
+			if(strcmp(settle, "fixed") == 0) {
+				cic->settle_adaptive = 0;
+			} else if(strcmp(settle, "adaptive") == 0) {
+				cic->settle_adaptive = 1;
+			} else {
+				SNDERR("Valid 'settle' values are fixed, adaptive.");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "recovery") == 0) {
+			const char *recovery;
+			if(snd_config_get_string(n, &recovery) < 0) {
+				SNDERR("'recovery' must be a string");
+				err = -EINVAL;
+				break;
+			}
+			if(strcmp(recovery, "fast") == 0) {
+				cic->recovery_full = 0;
+			} else if(strcmp(recovery, "full") == 0) {
+				cic->recovery_full = 1;
+			} else {
+				SNDERR("Valid 'recovery' values are fast, full.");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "settle_threshold") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'settle_threshold' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= -120 && val <= -20) {
+				cic->settle_threshold = (int)val;
+			} else {
+				SNDERR("'settle_threshold' must be in range of: [-120dB, -20dB].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "decoder") == 0) {
+			const char *decoder;
+			if(snd_config_get_string(n, &decoder) < 0) {
+				SNDERR("'decoder' must be a string");
+				err = -EINVAL;
+				break;
+			}
+			if(strcmp(decoder, "imx") == 0) {
+#ifdef HAVE_IMXSWPDM
+				cic->builtin = 0;
+#else
+				SNDERR("cicFilter was built without libimxswpdm, only the builtin decoder is there");
+				err = -EINVAL;
+				break;
+#endif
+			} else if(strcmp(decoder, "builtin") == 0) {
+				cic->builtin = 1;
+			} else {
+				SNDERR("Valid 'decoder' values are imx, builtin.");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "decoder_delay") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'decoder_delay' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 0 && val <= 100000) {
+				cic->decoder_delay = (unsigned int)val;
+			} else {
+				SNDERR("'decoder_delay' must be in range of: [0us, 100,000us].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
 		}
-		free(*cic);
-		*cic = NULL;
-	}
-}
 
-static int constrains(snd_pcm_ioplug_t *io) {
-	int err;
+		if(strcmp(id, "channel_gain") == 0) {
+			err = parse_channel_gain(n, cic);
+			if(err < 0)
+				break;
+			continue;
+		}
 
-	static unsigned int accesses[] = {
-		SND_PCM_ACCESS_RW_INTERLEAVED
-	};
+		if(strcmp(id, "matrix") == 0) {
+			err = parse_matrix(n, cic);
+			if(err < 0)
+				break;
+			continue;
+		}
 
-	static unsigned int formats[] = {
-		SND_PCM_FORMAT_S32_LE
-	};
+		if(strcmp(id, "dc_block") == 0) {
+			err = snd_config_get_bool(n);
+			if(err < 0) {
+				SNDERR("'dc_block' must be a boolean");
+				break;
+			}
+			cic->dc_block = err;
+			continue;
+		}
 
-	static unsigned int rates[] = {
-		8000, 11025, 16000, 22050, 24000,
-		32000, 44100, 48000, 64000, 88200,
-		96000
-	};
+		if(strcmp(id, "gate") == 0) {
+			err = snd_config_get_bool(n);
+			if(err < 0) {
+				SNDERR("'gate' must be a boolean");
+				break;
+			}
+			cic->gate_enabled = err;
+			continue;
+		}
 
-	static unsigned int period_bytes[] = {
-		192, 384, 768, 1536
-	};
+		if(strcmp(id, "gate_threshold") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'gate_threshold' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= -100 && val <= -20) {
+				cic->gate_threshold = (int)val;
+			} else {
+				SNDERR("'gate_threshold' must be in range of: [-100dB, -20dB].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
 
-	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_ACCESS, ARRAY_SIZE(accesses), accesses);
-	if (err < 0) {
-		SNDERR("ioplug cannot set hw access mode");
-		return err;
-	}
+		if(strcmp(id, "gate_hold") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'gate_hold' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 0 && val <= 10000) {
+				cic->gate_hold = (unsigned int)val;
+			} else {
+				SNDERR("'gate_hold' must be in range of: [0ms, 10,000ms].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
 
-	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_FORMAT, ARRAY_SIZE(formats), formats);
-	if (err < 0) {
-		SNDERR("ioplug cannot set hw format");
-		return err;
-	}
+		if(strcmp(id, "slave_periods") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'slave_periods' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 2 && val <= 64) {
+				cic->slave_periods = (unsigned int)val;
+			} else {
+				SNDERR("'slave_periods' must be in range of: [2, 64].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
 
-	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_CHANNELS, MIN_PCM_CHANNELS, MAX_PCM_CHANNELS);
-	if (err < 0) {
-		SNDERR("ioplug cannot set hw channels");
-		return err;
-	}
+		if(strcmp(id, "slave_buffer_time") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'slave_buffer_time' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 0 && val <= 2000000) {
+				cic->slave_buffer_time = (unsigned int)val;
+			} else {
+				SNDERR("'slave_buffer_time' must be in range of: [0us, 2,000,000us].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
 
-	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_RATE, ARRAY_SIZE(rates), rates);
-	if (err < 0) {
-		SNDERR("ioplug cannot set hw rates");
-		return err;
-	}
+		if(strcmp(id, "catchup_watermark") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'catchup_watermark' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 0 && val <= 2000000) {
+				cic->catchup_time = (unsigned int)val;
+			} else {
+				SNDERR("'catchup_watermark' must be in range of: [0us, 2,000,000us].");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
 
-	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_PERIOD_BYTES, ARRAY_SIZE(period_bytes), period_bytes);
-	if (err < 0) {
-		SNDERR("ioplug cannot set hw period bytes");
-		return err;
-	}
+		if(strcmp(id, "caps_cache") == 0) {
+			err = snd_config_get_bool(n);
+			if(err < 0) {
+				SNDERR("'caps_cache' must be a boolean");
+				break;
+			}
+			cic->caps_cache = err;
+			continue;
+		}
 
-	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIODS, 2, MAX_PERIODS);
-	if (err < 0) {
-		SNDERR("ioplug cannot set periods");
-		return err;
-	}
+		if(strcmp(id, "rt") == 0) {
+			err = snd_config_get_bool(n);
+			if(err < 0) {
+				SNDERR("'rt' must be a boolean");
+				break;
+			}
+			cic->rt = err;
+			continue;
+		}
 
-	return err;
-}
+		if(strcmp(id, "rt_huge") == 0) {
+			err = snd_config_get_bool(n);
+			if(err < 0) {
+				SNDERR("'rt_huge' must be a boolean");
+				break;
+			}
+			cic->rt_huge = err;
+			continue;
+		}
 
-static inline int parse_struct(snd_config_t **conf, const char **str, snd_pcm_cic_filter_t *cic) {
-	snd_config_iterator_t i, next;
-	snd_config_t *n;
-	const char *id;
-	long val;
-	int err = 1;
+		if(strcmp(id, "control") == 0) {
+			const char *ctl;
+			if(snd_config_get_string(n, &ctl) < 0) {
+				SNDERR("'control' must be a string");
+				err = -EINVAL;
+				break;
+			}
+			if(ctl[0] != '/' || strchr(ctl + 1, '/') != NULL) {
+				SNDERR("'control' must be a shm name like /swpdm-ctl");
+				err = -EINVAL;
+				break;
+			}
+			free(cic->ctl_name);
+			cic->ctl_name = strdup(ctl);
+			continue;
+		}
 
-	snd_config_for_each(i, next, *conf) {
-		n = snd_config_iterator_entry(i);
+		if(strcmp(id, "tap_file") == 0) {
+			const char *path;
+			if(snd_config_get_string(n, &path) < 0) {
+				SNDERR("'tap_file' must be a string");
+				err = -EINVAL;
+				break;
+			}
+			free(cic->tap_file);
+			cic->tap_file = strdup(path);
+			continue;
+		}
 
-		if (snd_config_get_id(n, &id) < 0)
+		if(strcmp(id, "tap_start") == 0) {
+			err = snd_config_get_bool(n);
+			if(err < 0) {
+				SNDERR("'tap_start' must be a boolean");
+				break;
+			}
+			cic->tap_pending = err;
 			continue;
+		}
 
-		if ((strcmp(id, "comment") == 0) || (strcmp(id, "type") == 0))
+		if(strcmp(id, "tap_time") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'tap_time' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= 1 && val <= 3600) {
+				cic->tap_time = (unsigned int)val;
+			} else {
+				SNDERR("'tap_time' must be in range of: [1s, 3600s].");
+				err = -EINVAL;
+				break;
+			}
 			continue;
+		}
 
-		if(strcmp(id, "slave") == 0) {
-			if(snd_config_get_string(n, str) < 0) {
-				SNDERR("slave must be a string");
+		if(strcmp(id, "tap_buffer") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'tap_buffer' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= CIC_TAP_MIN_RING / 1024 && val <= 65536) {
+				cic->tap_buffer = (unsigned int)val;
+			} else {
+				SNDERR("'tap_buffer' must be in range of: [%dKB, 65536KB].", CIC_TAP_MIN_RING / 1024);
 				err = -EINVAL;
 				break;
 			}
 			continue;
 		}
 
-		if (strcmp(id, "delay") == 0) {
-			if (snd_config_get_integer(n, &val) < 0) {
-				SNDERR("'delay' must be a int");
+		if(strcmp(id, "stats_shm") == 0) {
+			const char *path;
+			if(snd_config_get_string(n, &path) < 0) {
+				SNDERR("'stats_shm' must be a string");
 				err = -EINVAL;
 				break;
 			}
-			if(val >= 1000 && val <= 1000000)
-				cic->delay = (unsigned int)val;
-			else {
-				SNDERR("'delay' must be in range of: [1,000us, 1,000,000us].");
+			if(path[0] != '/' || strchr(path + 1, '/') != NULL) {
+				SNDERR("'stats_shm' must be a shm name like /swpdm-stats");
 				err = -EINVAL;
 				break;
 			}
+			free(cic->stats_shm);
+			cic->stats_shm = strdup(path);
 			continue;
 		}
 
-		if(strcmp(id, "OSR")==0) {
-			if(snd_config_get_integer(n, &val) < 0) {
-				SNDERR("'OSR' must be a int");
+		if(strcmp(id, "trace_file") == 0) {
+			const char *path;
+			if(snd_config_get_string(n, &path) < 0) {
+				SNDERR("'trace_file' must be a string");
 				err = -EINVAL;
 				break;
 			}
-			switch (val) {
-			case 48:
-				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_12;
-				cic->OSR = 48;
+			free(cic->trace_file);
+			cic->trace_file = strdup(path);
+			continue;
+		}
+
+		if(strcmp(id, "share") == 0) {
+			const char *share;
+			if(snd_config_get_string(n, &share) < 0) {
+				SNDERR("'share' must be a string");
+				err = -EINVAL;
 				break;
-			case 64:
-				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_16;
-				cic->OSR = 64;
+			}
+			if(share[0] == '\0' || strchr(share, '/') != NULL) {
+				SNDERR("'share' must be a name without /");
+				err = -EINVAL;
 				break;
-			case 96:
-				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_24;
-				cic->OSR = 96;
+			}
+			free(cic->share_name);
+			cic->share_name = malloc(strlen(share) + sizeof("/swpdm-"));
+			if(cic->share_name == NULL) {
+				err = -ENOMEM;
 				break;
-			case 128:
-				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_32;
-				cic->OSR = 128;
+			}
+			sprintf(cic->share_name, "/swpdm-%s", share);
+			continue;
+		}
+
+		if(strcmp(id, "share_rate") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'share_rate' must be a int");
+				err = -EINVAL;
 				break;
-			case 192:
-				cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_48;
-				cic->OSR = 192;
+			}
+			if(val >= 8000 && val <= 64000) {
+				cic->share_rate = (unsigned int)val;
+			} else {
+				SNDERR("'share_rate' must be in range of: [8000, 64000].");
+				err = -EINVAL;
 				break;
-			default:
-				SNDERR("OSR value read %ld\n", val);
-				SNDERR("Valid 'OSR' values are 48, 64, 96, 128, 192.");
+			}
+			continue;
+		}
+
+		if(strcmp(id, "share_channels") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'share_channels' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= MIN_PCM_CHANNELS && val <= MAX_PCM_CHANNELS) {
+				cic->share_channels = (unsigned int)val;
+			} else {
+				SNDERR("'share_channels' must be in range of: [%d, %d].", MIN_PCM_CHANNELS, MAX_PCM_CHANNELS);
 				err = -EINVAL;
 				break;
 			}
 			continue;
 		}
 
-		if(strcmp(id, "gain") == 0) {
+		if(strcmp(id, "worker_cpu") == 0) {
 			if(snd_config_get_integer(n, &val) < 0) {
-				SNDERR("'gain' must be a int");
+				SNDERR("'worker_cpu' must be a int");
 				err = -EINVAL;
 				break;
 			}
-			if(val >= 0 && val <= 100) {
-				cic->gain = (float)val;
+			if(val >= -1 && val < CPU_SETSIZE) {
+				cic->worker_cpu = (int)val;
 			} else {
-				SNDERR("'gain' must be in range of: [0, 100]. Default set to 0.");
+				SNDERR("'worker_cpu' must be -1 or a valid cpu index.");
 				err = -EINVAL;
 				break;
 			}
@@ -608,13 +3070,34 @@ static inline int parse_struct(snd_config_t **conf, const char **str, snd_pcm_ci
 	return err;
 }
 
+/* Fill the control page with the configured values, the last ones of a previous open are lost. */
+static int open_controls(snd_pcm_cic_filter_t *cic) {
+	cic_ctl *ctl;
+	unsigned int i;
+
+	ctl = cic_ctl_open(cic->ctl_name, 1);
+	if(ctl == NULL)
+		return -errno;
+	cic->ctl = ctl;
+
+	for(i = 0; i < CIC_CTL_CHANNELS; i++) {
+		ctl->mic_gain[i] = (int32_t)lrint(cic->mic_gain[i] * 10);
+		ctl->map[i] = 0;
+	}
+	ctl->settle_us = cic->delay;
+	cic->ctl_gen = cic_ctl_publish(ctl);
+
+	return 0;
+}
+
 SND_PCM_PLUGIN_DEFINE_FUNC(PLUG_NAME) {
 	snd_pcm_cic_filter_t *cic;
 	const char *devname;
+	unsigned int g;
 	int err;
 
 	if(stream != SND_PCM_STREAM_CAPTURE)
-		SNDERR("cicFilter is only for caputure");
+		SNDERR("cicFilter is only for caputure, use sdmFilter for playback");
 
 	cic = calloc(1, sizeof(*cic));
 	if(cic == NULL) {
@@ -622,37 +3105,104 @@ SND_PCM_PLUGIN_DEFINE_FUNC(PLUG_NAME) {
 		return -ENOMEM;
 	}
 
-	cic->afe = malloc(sizeof(*cic->afe));
-	if (cic->afe == NULL) {
-		SNDERR("Cant create afe structure");
-		destroy(&cic);
-		return -ENOMEM;
+	for(g = 0; g < MAX_PDM_GROUPS; g++) {
+		cic->afe[g] = calloc(1, sizeof(*cic->afe[g]));
+		if (cic->afe[g] == NULL) {
+			SNDERR("Cant create afe structure");
+			destroy(&cic);
+			return -ENOMEM;
+		}
 	}
 
 	/* Set default values. */
 	cic->type = CIC_pdmToPcmType_cic_order_5_cic_downsample_16;
+#ifndef HAVE_IMXSWPDM
+	cic->builtin = 1;
+#endif
 	cic->OSR = 64;
 	cic->gain = 0.0f;
+	cic->worker_cpu = -1;
+	cic->settle_threshold = SETTLE_THRESHOLD;
+	cic->share_channels = PDM_CHANNELS;
+	cic->share_timer = -1;
+	cic->gate_threshold = GATE_THRESHOLD;
+	cic->gate_hold = GATE_HOLD_MS;
+	cic->caps_cache = 1;
+	cic->tap_time = TAP_TIME_S;
+	cic->tap_buffer = TAP_BUFFER_KB;
 
 	err = parse_struct(&conf, &devname, cic);
 	if(err != 0){
 		destroy(&cic);
 		return err;
 	}
+	cic->settle_level = pow(10, cic->settle_threshold / 20.0) * 2147483648.0;
+
+	cic->stats = cic_stats_open(cic->stats_shm);
+	if(cic->stats == NULL) {
+		SNDERR("Unable to create the stats %s", cic->stats_shm ? cic->stats_shm : "");
+		destroy(&cic);
+		return -ENOMEM;
+	}
+	if(cic->trace_file != NULL) {
+		cic->trace = cic_trace_open(cic->trace_file);
+		if(cic->trace == NULL) {
+			SNDERR("Unable to open the trace file %s", cic->trace_file);
+			destroy(&cic);
+			return -EINVAL;
+		}
+	}
+	if(cic->ctl_name != NULL) {
+		err = open_controls(cic);
+		if(err < 0) {
+			SNDERR("Unable to create the controls %s", cic->ctl_name);
+			destroy(&cic);
+			return err;
+		}
+	}
+	if(cic->tap_file != NULL) {
+		/* the periods of a share are read by its owner thread */
+		if(cic->share_name != NULL) {
+			SNDERR("'tap_file' can't be used with 'share'");
+			destroy(&cic);
+			return -EINVAL;
+		}
+		cic->tap = cic_tap_open(cic->tap_file, (size_t)cic->tap_buffer * 1024);
+		if(cic->tap == NULL) {
+			SNDERR("Unable to create the tap of %s", cic->tap_file);
+			destroy(&cic);
+			return -ENOMEM;
+		}
+		/* tap_start captures tap_time seconds from the first period */
+		if(cic->tap_pending)
+			cic->tap_pending = cic->tap_time;
+	}
 
-	err = snd_pcm_open(&cic->slave, devname, stream, mode);
+	/* nonblock is handled by the plugin, a slave read never returns short */
+	if(cic->share_name != NULL)
+		err = share_open(cic, devname);
+	else
+		err = snd_pcm_open(&cic->slave, devname, stream, mode & ~SND_PCM_NONBLOCK);
 	if(err < 0) {
 		SNDERR("Cant open slave");
 		destroy(&cic);
 		return err;
 	}
+	if(cic->slave != NULL) {
+		err = probe_slave(cic, devname);
+		if(err < 0) {
+			destroy(&cic);
+			return err;
+		}
+	}
 
 	cic->io.version = SND_PCM_IOPLUG_VERSION;
 	cic->io.name = "Digital conversion from PDM 2 PCM";
-	cic->io.mmap_rw = 0; /*still having doubts on this field.*/
+	/* mmap access uses the buffer of ioplug, filled by cic_transfer() on avail updates */
+	cic->io.mmap_rw = 0;
 	cic->io.callback = &cic_funcs;
 	cic->io.private_data = cic;
-	cic->io.flags = SND_PCM_IOPLUG_FLAG_BOUNDARY_WA;
+	cic->io.flags = SND_PCM_IOPLUG_FLAG_BOUNDARY_WA | SND_PCM_IOPLUG_FLAG_MONOTONIC;
 
 	err = snd_pcm_ioplug_create(&cic->io, name, stream, mode);
 	if(err < 0) {
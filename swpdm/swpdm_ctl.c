@@ -0,0 +1,250 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * Control plugin of cicFilter: the mic gains, channel map and settle
+ * window of a running capture as mixer elements, through the shared
+ * memory page of its control option.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <alsa/asoundlib.h>
+#include <alsa/control_external.h>
+
+#include "cic_ctl.h"
+
+#define PLUG_NAME                               cicCtl
+
+enum {
+	CTL_MIC_GAIN,
+	CTL_CHANNEL_MAP,
+	CTL_SETTLE_TIME,
+	CTL_ELEMS
+};
+
+static const char *const ctl_names[CTL_ELEMS] = {
+	"Mic Capture Volume",
+	"Capture Channel Map",
+	"Capture Settle Time",
+};
+
+typedef struct snd_ctl_cic {
+	snd_ctl_ext_t ext;
+	cic_ctl *ctl;
+}snd_ctl_cic_t;
+
+static int cic_elem_count(snd_ctl_ext_t *ext) {
+	return CTL_ELEMS;
+}
+
+static int cic_elem_list(snd_ctl_ext_t *ext, unsigned int offset, snd_ctl_elem_id_t *id) {
+	if(offset >= CTL_ELEMS)
+		return -EINVAL;
+
+	snd_ctl_elem_id_set_interface(id, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_id_set_name(id, ctl_names[offset]);
+	return 0;
+}
+
+static snd_ctl_ext_key_t cic_find_elem(snd_ctl_ext_t *ext, const snd_ctl_elem_id_t *id) {
+	const char *name = snd_ctl_elem_id_get_name(id);
+	unsigned int i;
+
+	for(i = 0; i < CTL_ELEMS; i++)
+		if(strcmp(name, ctl_names[i]) == 0)
+			return i;
+
+	return SND_CTL_EXT_KEY_NOT_FOUND;
+}
+
+static int cic_get_attribute(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key, int *type,
+			     unsigned int *acc, unsigned int *count) {
+	if(key >= CTL_ELEMS)
+		return -EINVAL;
+
+	*type = SND_CTL_ELEM_TYPE_INTEGER;
+	*acc = SND_CTL_EXT_ACCESS_READWRITE;
+	*count = key == CTL_SETTLE_TIME ? 1 : CIC_CTL_CHANNELS;
+	return 0;
+}
+
+/* Gains in 0.1 dB, channels as mic + 1 or 0 as configured, settle in us. */
+static int cic_get_integer_info(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+				long *imin, long *imax, long *istep) {
+	*istep = 1;
+	switch(key) {
+	case CTL_MIC_GAIN:
+		*imin = CIC_CTL_GAIN_MIN;
+		*imax = CIC_CTL_GAIN_MAX;
+		break;
+	case CTL_CHANNEL_MAP:
+		*imin = 0;
+		*imax = CIC_CTL_CHANNELS;
+		break;
+	case CTL_SETTLE_TIME:
+		*imin = 0;
+		*imax = CIC_CTL_SETTLE_MAX;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int cic_read_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key, long *value) {
+	snd_ctl_cic_t *cic = ext->private_data;
+	cic_ctl *ctl = cic->ctl;
+	unsigned int i;
+
+	switch(key) {
+	case CTL_MIC_GAIN:
+		for(i = 0; i < CIC_CTL_CHANNELS; i++)
+			value[i] = ctl->mic_gain[i];
+		break;
+	case CTL_CHANNEL_MAP:
+		for(i = 0; i < CIC_CTL_CHANNELS; i++)
+			value[i] = ctl->map[i];
+		break;
+	case CTL_SETTLE_TIME:
+		value[0] = ctl->settle_us;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Returns 1 when a value changed, the pcm applies it on its next block. */
+static int cic_write_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key, long *value) {
+	snd_ctl_cic_t *cic = ext->private_data;
+	cic_ctl *ctl = cic->ctl;
+	long imin, imax, istep;
+	unsigned int i;
+	int changed = 0;
+
+	if(cic_get_integer_info(ext, key, &imin, &imax, &istep) < 0)
+		return -EINVAL;
+	for(i = 0; i < (key == CTL_SETTLE_TIME ? 1 : CIC_CTL_CHANNELS); i++)
+		if(value[i] < imin || value[i] > imax)
+			return -EINVAL;
+
+	switch(key) {
+	case CTL_MIC_GAIN:
+		for(i = 0; i < CIC_CTL_CHANNELS; i++) {
+			changed |= ctl->mic_gain[i] != value[i];
+			ctl->mic_gain[i] = (int32_t)value[i];
+		}
+		break;
+	case CTL_CHANNEL_MAP:
+		for(i = 0; i < CIC_CTL_CHANNELS; i++) {
+			changed |= ctl->map[i] != (uint32_t)value[i];
+			ctl->map[i] = (uint32_t)value[i];
+		}
+		break;
+	default:
+		changed = ctl->settle_us != (uint32_t)value[0];
+		ctl->settle_us = (uint32_t)value[0];
+		break;
+	}
+
+	if(changed)
+		cic_ctl_commit(ctl);
+
+	return changed;
+}
+
+static void cic_ctl_close_ext(snd_ctl_ext_t *ext) {
+	snd_ctl_cic_t *cic = ext->private_data;
+
+	cic_ctl_close(cic->ctl);
+	free(cic);
+}
+
+static const snd_ctl_ext_callback_t cic_ctl_funcs = {
+	.elem_count = cic_elem_count,
+	.elem_list = cic_elem_list,
+	.find_elem = cic_find_elem,
+	.get_attribute = cic_get_attribute,
+	.get_integer_info = cic_get_integer_info,
+	.read_integer = cic_read_integer,
+	.write_integer = cic_write_integer,
+	.close = cic_ctl_close_ext,
+};
+
+SND_CTL_PLUGIN_DEFINE_FUNC(PLUG_NAME) {
+	snd_config_iterator_t i, next;
+	snd_ctl_cic_t *cic;
+	const char *control = NULL;
+	const char *id;
+	snd_config_t *n;
+	int err;
+
+	snd_config_for_each(i, next, conf) {
+		n = snd_config_iterator_entry(i);
+
+		if(snd_config_get_id(n, &id) < 0)
+			continue;
+
+		if((strcmp(id, "comment") == 0) || (strcmp(id, "type") == 0) || (strcmp(id, "hint") == 0))
+			continue;
+
+		if(strcmp(id, "control") == 0) {
+			if(snd_config_get_string(n, &control) < 0) {
+				SNDERR("'control' must be a string");
+				return -EINVAL;
+			}
+			continue;
+		}
+
+		SNDERR("Unknow field %s", id);
+		return -EINVAL;
+	}
+
+	if(control == NULL) {
+		SNDERR("No control page defined for cicCtl");
+		return -EINVAL;
+	}
+
+	cic = calloc(1, sizeof(*cic));
+	if(cic == NULL)
+		return -ENOMEM;
+
+	/* the pcm creates the page, the controls only exist once it was opened */
+	cic->ctl = cic_ctl_open(control, 0);
+	if(cic->ctl == NULL) {
+		err = -errno;
+		SNDERR("No cicFilter pcm with the control %s", control);
+		free(cic);
+		return err;
+	}
+
+	cic->ext.version = SND_CTL_EXT_VERSION;
+	cic->ext.card_idx = 0;
+	strncpy(cic->ext.id, "cicCtl", sizeof(cic->ext.id) - 1);
+	strncpy(cic->ext.driver, "cicFilter", sizeof(cic->ext.driver) - 1);
+	strncpy(cic->ext.name, "cicFilter", sizeof(cic->ext.name) - 1);
+	snprintf(cic->ext.longname, sizeof(cic->ext.longname), "cicFilter controls of %s", control);
+	strncpy(cic->ext.mixername, "cicFilter", sizeof(cic->ext.mixername) - 1);
+	cic->ext.poll_fd = -1;
+	cic->ext.callback = &cic_ctl_funcs;
+	cic->ext.private_data = cic;
+
+	err = snd_ctl_ext_create(&cic->ext, name, mode);
+	if(err < 0) {
+		cic_ctl_close(cic->ctl);
+		free(cic);
+		return err;
+	}
+
+	*handlep = cic->ext.handle;
+	return 0;
+}
+
+SND_CTL_PLUGIN_SYMBOL(PLUG_NAME);
@@ -0,0 +1,616 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Copyright 2026 NXP
+ *
+ * PCM to PDM playback plugin, the companion of cicFilter for amplifiers
+ * with a PDM input: the app frames are interpolated and sigma-delta
+ * modulated to DSD_U32_LE for the imxswpdmaudio slave.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_external.h>
+#include <alsa/global.h>
+
+#include "sdm_modulator.h"
+#include "pdm_rates.h"
+#include "pcm_kernels.h"
+
+#define PLUG_NAME                               sdmFilter
+
+#define ARRAY_SIZE(ary)                       (sizeof(ary)/sizeof(ary[0]))
+
+#define MAX_OUT_PERIOD_SIZE                   4096
+#define MIN_PERIOD_BYTES                      64
+#define MAX_PERIOD_BYTES                      65536
+#define MODULATOR_BLOCK_UNIT                  16
+#define PDM_CHANNELS                          4 /* channels per pdm slave group */
+#define MAX_PCM_CHANNELS                      SDM_MODULATOR_MAX_CHANNELS
+#define MIN_PCM_CHANNELS                      1
+#define MAX_PERIODS                           8
+#define MAX_PDM_FREQUENCY                     4800000
+#define GAIN_MIN                              -60
+
+typedef struct snd_pcm_sdm_filter {
+	/* internal plug elements */
+	snd_pcm_ioplug_t io;
+	snd_pcm_t *slave;
+	snd_pcm_hw_params_t *slave_params;
+	snd_pcm_uframes_t ptr;
+	snd_pcm_uframes_t boundary;
+	/* modulator of every slave channel, the ones above the app channels get silence */
+	sdm_modulator *mod;
+	unsigned int slave_channels;
+	snd_pcm_uframes_t block;            /* app frames modulated at once */
+	snd_pcm_uframes_t out_period_size;  /* slave frames of a block */
+	snd_pcm_uframes_t fill;             /* app frames waiting in the modulator input */
+	snd_pcm_uframes_t slave_buffer;
+	/* external plug elements */
+	unsigned int OSR;
+	int gain;
+}snd_pcm_sdm_filter_t;
+
+static int sdm_start(snd_pcm_ioplug_t *io);
+static int sdm_stop(snd_pcm_ioplug_t *io);
+static snd_pcm_sframes_t sdm_pointer(snd_pcm_ioplug_t *io);
+static int sdm_delay(snd_pcm_ioplug_t *io, snd_pcm_sframes_t *delayp);
+static snd_pcm_sframes_t sdm_transfer(snd_pcm_ioplug_t *io, const snd_pcm_channel_area_t *areas,
+                                      snd_pcm_uframes_t offset, snd_pcm_uframes_t size);
+static int sdm_close(snd_pcm_ioplug_t *io);
+static int sdm_hw(snd_pcm_ioplug_t *io, snd_pcm_hw_params_t *params);
+static int sdm_hw_free(snd_pcm_ioplug_t *io);
+static int sdm_sw(snd_pcm_ioplug_t *io, snd_pcm_sw_params_t *params);
+static int sdm_prepare(snd_pcm_ioplug_t *io);
+static int sdm_drain(snd_pcm_ioplug_t *io);
+static int sdm_poll_descriptors_count(snd_pcm_ioplug_t *io);
+static int sdm_poll_descriptors(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int space);
+static int sdm_poll_revents(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int nfds, unsigned short *revents);
+static void sdm_dump(snd_pcm_ioplug_t *io, snd_output_t *out);
+static void destroy(snd_pcm_sdm_filter_t **sdm);
+
+static const snd_pcm_ioplug_callback_t sdm_funcs = {
+	.start = sdm_start,
+	.stop = sdm_stop,
+	.pointer = sdm_pointer,
+	.transfer = sdm_transfer,
+	.close = sdm_close,
+	.hw_params = sdm_hw,
+	.hw_free = sdm_hw_free,
+	.sw_params = sdm_sw,
+	.prepare = sdm_prepare,
+	.drain = sdm_drain,
+	.poll_descriptors_count = sdm_poll_descriptors_count,
+	.poll_descriptors = sdm_poll_descriptors,
+	.poll_revents = sdm_poll_revents,
+	.dump = sdm_dump,
+	.delay = sdm_delay
+};
+
+/* The slave starts on its own once a period is written, see sdm_sw(). */
+static int sdm_start(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+
+	/* nothing queued yet, the first block starts it */
+	if(snd_pcm_state(sdm->slave) != SND_PCM_STATE_PREPARED ||
+	   snd_pcm_avail_update(sdm->slave) >= (snd_pcm_sframes_t)sdm->slave_buffer)
+		return 0;
+
+	return snd_pcm_start(sdm->slave);
+}
+
+static int sdm_stop(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+
+	sdm->fill = 0;
+	snd_pcm_drop(sdm->slave);
+	return 0;
+}
+
+/* Every frame written is consumed at once, the slave write paces the app. */
+static snd_pcm_sframes_t sdm_pointer(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	snd_pcm_sframes_t avail;
+
+	avail = snd_pcm_avail_update(sdm->slave);
+	if(avail < 0)
+		return avail;
+
+	return sdm->ptr;
+}
+
+/* Frames waiting for a whole block, in the slave buffer, then in the interpolator. */
+static int sdm_delay(snd_pcm_ioplug_t *io, snd_pcm_sframes_t *delayp) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	snd_pcm_sframes_t slave_delay;
+	int err;
+
+	err = snd_pcm_delay(sdm->slave, &slave_delay);
+	if(err < 0)
+		return err;
+
+	*delayp = slave_delay * (snd_pcm_sframes_t)sdm->block / (snd_pcm_sframes_t)sdm->out_period_size +
+		  sdm->fill + (snd_pcm_sframes_t)(sdm_modulator_delay() + 0.5);
+	return 0;
+}
+
+/* Modulate the block in the modulator input and write it to the slave. */
+static snd_pcm_sframes_t write_block(snd_pcm_sdm_filter_t *sdm) {
+	const uint32_t *pdm_samples;
+	snd_pcm_sframes_t frames;
+	snd_pcm_uframes_t done = 0;
+
+	sdm_modulator_process(sdm->mod);
+
+	pdm_samples = sdm->mod->outputBuffer;
+	while(done < sdm->out_period_size) {
+		frames = snd_pcm_mmap_writei(sdm->slave, pdm_samples + done * sdm->slave_channels,
+					     sdm->out_period_size - done);
+		if(frames < 0)
+			return frames;
+		done += frames;
+	}
+	sdm->fill = 0;
+
+	return done;
+}
+
+/* Copy app frames, S16 or S32 from any area, to the S32 modulator input. */
+static void copy_from_areas(snd_pcm_sdm_filter_t *sdm, const snd_pcm_channel_area_t *areas,
+			    snd_pcm_uframes_t offset, unsigned int channels, snd_pcm_uframes_t frames) {
+	const pcm_kernels *k = pcm_kernels_get();
+	int32_t *pcm_samples;
+	const char *src;
+	unsigned int c;
+
+	for(c = 0; c < channels; c++) {
+		pcm_samples = sdm->mod->inputBuffer + sdm->fill * sdm->slave_channels + c;
+		src = (const char *)areas[c].addr + (areas[c].first + offset * areas[c].step) / 8;
+		if(sdm->io.format == SND_PCM_FORMAT_S16_LE)
+			k->s16_to_s32(pcm_samples, sdm->slave_channels, (const int16_t *)src, areas[c].step / 16, frames);
+		else
+			k->gather_s32(pcm_samples, sdm->slave_channels, (const int32_t *)src, areas[c].step / 32, frames);
+	}
+}
+
+/*
+ * The app frames are gathered in the modulator input, every whole block is
+ * modulated and written to the slave, blocking until the slave has room.
+ */
+static snd_pcm_sframes_t sdm_transfer(snd_pcm_ioplug_t *io, const snd_pcm_channel_area_t *areas,
+				      snd_pcm_uframes_t offset, snd_pcm_uframes_t size) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	snd_pcm_sframes_t err = 0;
+	snd_pcm_uframes_t n, done = 0;
+
+	while(done < size) {
+		n = sdm->block - sdm->fill;
+		if(n > size - done)
+			n = size - done;
+		copy_from_areas(sdm, areas, offset + done, io->channels, n);
+		sdm->fill += n;
+		done += n;
+
+		if(sdm->fill == sdm->block) {
+			err = write_block(sdm);
+			if(err < 0)
+				break;
+		}
+	}
+
+	/* the frames of a failed block are lost with the xrun */
+	if(err < 0)
+		return err;
+
+	sdm->ptr = (sdm->ptr + done) % sdm->boundary;
+	return done;
+}
+
+/* Pad the last block with silence, then let the slave play everything. */
+static int sdm_drain(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	snd_pcm_sframes_t err;
+
+	if(sdm->fill > 0) {
+		memset(sdm->mod->inputBuffer + sdm->fill * sdm->slave_channels, 0,
+		       (sdm->block - sdm->fill) * sdm->slave_channels * sizeof(int32_t));
+		err = write_block(sdm);
+		if(err < 0)
+			return err;
+	}
+
+	if(snd_pcm_state(sdm->slave) == SND_PCM_STATE_PREPARED)
+		snd_pcm_start(sdm->slave);
+
+	return snd_pcm_drain(sdm->slave);
+}
+
+static int sdm_close(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+
+	destroy(&sdm);
+	return 0;
+}
+
+static int sdm_hw(snd_pcm_ioplug_t *io, snd_pcm_hw_params_t *params) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	unsigned int rate, slave_rate, periods;
+	snd_pcm_uframes_t max;
+	int err;
+	int dir;
+
+	err = snd_pcm_hw_params_get_rate(params, &rate, &dir);
+	if (err < 0) {
+		SNDERR("unable to get device rate\n");
+		return err;
+	}
+
+	slave_rate = pdm_pcm_rate(sdm->OSR, rate) == rate ? pdm_slave_rate(sdm->OSR, rate) : 0;
+	if (slave_rate == 0) {
+		SNDERR("Rate %u can't be modulated with OSR %u\n", rate, sdm->OSR);
+		return -EINVAL;
+	}
+	if (slave_rate * snd_pcm_format_width(SND_PCM_FORMAT_DSD_U32_LE) > MAX_PDM_FREQUENCY) {
+		SNDERR("max frequency can't exceed 4.8MHz\n");
+		return -EINVAL;
+	}
+
+	/* the largest block of 16 frames below the app period */
+	max = MAX_OUT_PERIOD_SIZE * 32 / sdm->OSR / MODULATOR_BLOCK_UNIT * MODULATOR_BLOCK_UNIT;
+	sdm->block = io->period_size / MODULATOR_BLOCK_UNIT * MODULATOR_BLOCK_UNIT;
+	if (sdm->block < MODULATOR_BLOCK_UNIT)
+		sdm->block = MODULATOR_BLOCK_UNIT;
+	if (sdm->block > max)
+		sdm->block = max;
+	sdm->out_period_size = sdm->block * sdm->OSR / 32;
+
+	/* the pdm slave has 4 or 8 channels */
+	sdm->slave_channels = io->channels <= PDM_CHANNELS ? PDM_CHANNELS : 2 * PDM_CHANNELS;
+
+	sdm_modulator_destroy(sdm->mod);
+	sdm->mod = sdm_modulator_create(sdm->OSR, sdm->slave_channels, sdm->block, pow(10, sdm->gain / 20.0));
+	if (sdm->mod == NULL) {
+		SNDERR("Fail to create the modulator");
+		return -ENOMEM;
+	}
+	sdm->fill = 0;
+
+	if(sdm->slave_params == NULL) {
+		err = snd_pcm_hw_params_malloc(&sdm->slave_params);
+		if (err < 0)
+			return err;
+	}
+
+	err = snd_pcm_hw_params_any(sdm->slave, sdm->slave_params);
+	if (err < 0) {
+		SNDERR("Broken configuration for playback: no configurations available: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_access(sdm->slave, sdm->slave_params, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+	if (err < 0) {
+		SNDERR("Access type not available for playback: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_channels(sdm->slave, sdm->slave_params, sdm->slave_channels);
+	if (err < 0) {
+		SNDERR("Unable to set numbers of channels: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_format(sdm->slave, sdm->slave_params, SND_PCM_FORMAT_DSD_U32_LE);
+	if (err < 0) {
+		SNDERR("Sample format not available for playback: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_rate(sdm->slave, sdm->slave_params, slave_rate, 0);
+	if (err < 0) {
+		SNDERR("Unable to set rate: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* at least as long as the app buffer */
+	snd_pcm_hw_params_get_periods(params, &periods, &dir);
+	if (periods < (io->buffer_size + sdm->block - 1) / sdm->block)
+		periods = (io->buffer_size + sdm->block - 1) / sdm->block;
+	sdm->slave_buffer = sdm->out_period_size * periods;
+	err = snd_pcm_hw_params_set_buffer_size(sdm->slave, sdm->slave_params, sdm->slave_buffer);
+	if (err < 0) {
+		SNDERR("Unable to set buffer size.\n");
+		return err;
+	}
+
+	err = snd_pcm_hw_params_set_period_size(sdm->slave, sdm->slave_params, sdm->out_period_size, 0);
+	if (err < 0) {
+		SNDERR("Unable to set period time\n");
+		return err;
+	}
+
+	err = snd_pcm_hw_params(sdm->slave, sdm->slave_params);
+	if (err < 0) {
+		SNDERR("Couldnt set hw params\n");
+		return err;
+	}
+
+	return err;
+}
+
+static int sdm_hw_free(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+
+	sdm_modulator_destroy(sdm->mod);
+	sdm->mod = NULL;
+	free(sdm->slave_params);
+	sdm->slave_params = NULL;
+	return snd_pcm_hw_free(sdm->slave);
+}
+
+static int sdm_sw(snd_pcm_ioplug_t *io, snd_pcm_sw_params_t *params) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	snd_pcm_sw_params_t *sparams;
+	int err;
+
+	snd_pcm_sw_params_get_boundary(params, &sdm->boundary);
+
+	snd_pcm_sw_params_alloca(&sparams);
+	err = snd_pcm_sw_params_current(sdm->slave, sparams);
+	if (err < 0) {
+		SNDERR("Unable to determine current swparams for playback: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	/* start once a whole block is queued, wake up for every free block */
+	err = snd_pcm_sw_params_set_start_threshold(sdm->slave, sparams, sdm->out_period_size);
+	err = err == 0 ? snd_pcm_sw_params_set_avail_min(sdm->slave, sparams, sdm->out_period_size) : err;
+	if (err < 0) {
+		SNDERR("Unable to set the swparams for playback: %s\n", snd_strerror(err));
+		return err;
+	}
+
+	return snd_pcm_sw_params(sdm->slave, sparams);
+}
+
+static int sdm_prepare(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+
+	sdm->ptr = 0;
+	sdm->fill = 0;
+	if(sdm->mod != NULL)
+		sdm_modulator_reset(sdm->mod);
+	return snd_pcm_prepare(sdm->slave);
+}
+
+static int sdm_poll_descriptors_count(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	return snd_pcm_poll_descriptors_count(sdm->slave);
+}
+
+static int sdm_poll_descriptors(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int space) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	return snd_pcm_poll_descriptors(sdm->slave, pfd, space);
+}
+
+static int sdm_poll_revents(snd_pcm_ioplug_t *io, struct pollfd *pfd, unsigned int nfds, unsigned short *revents) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	return snd_pcm_poll_descriptors_revents(sdm->slave, pfd, nfds, revents);
+}
+
+static void sdm_dump(snd_pcm_ioplug_t *io, snd_output_t *out) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+
+	snd_output_printf(out, "%s\n", io->name);
+	snd_output_printf(out, "Its setup is:\n");
+	snd_pcm_dump_setup(io->pcm, out);
+	snd_output_printf(out, "Modulator Settings: \n");
+	snd_output_printf(out, "  OSR:              %u\n", sdm->OSR);
+	snd_output_printf(out, "  Gain:             %d dB\n", sdm->gain);
+	snd_output_printf(out, "  block:            %lu frames\n", sdm->block);
+	snd_output_printf(out, "  slave channels:   %u\n", sdm->slave_channels);
+	snd_output_printf(out, "Slave: ");
+	snd_pcm_dump(sdm->slave, out);
+}
+
+static void destroy(snd_pcm_sdm_filter_t **sdm) {
+	if(*sdm != NULL) {
+		sdm_modulator_destroy((*sdm)->mod);
+		free((*sdm)->slave_params);
+		if((*sdm)->slave != NULL)
+			snd_pcm_close((*sdm)->slave);
+		free(*sdm);
+		*sdm = NULL;
+	}
+}
+
+static int constrains(snd_pcm_ioplug_t *io) {
+	snd_pcm_sdm_filter_t *sdm = io->private_data;
+	unsigned int rates[8], n;
+	int err;
+
+	static unsigned int accesses[] = {
+		SND_PCM_ACCESS_RW_INTERLEAVED,
+		SND_PCM_ACCESS_MMAP_INTERLEAVED
+	};
+
+	static unsigned int formats[] = {
+		SND_PCM_FORMAT_S16_LE,
+		SND_PCM_FORMAT_S32_LE
+	};
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_ACCESS, ARRAY_SIZE(accesses), accesses);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw access mode");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_FORMAT, ARRAY_SIZE(formats), formats);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw format");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_CHANNELS, MIN_PCM_CHANNELS, MAX_PCM_CHANNELS);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw channels");
+		return err;
+	}
+
+	/* no resampler, only the rates carried natively at the OSR */
+	n = pdm_native_rates(sdm->OSR, rates, ARRAY_SIZE(rates));
+	err = snd_pcm_ioplug_set_param_list(io, SND_PCM_IOPLUG_HW_RATE, n, rates);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw rates");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIOD_BYTES, MIN_PERIOD_BYTES, MAX_PERIOD_BYTES);
+	if (err < 0) {
+		SNDERR("ioplug cannot set hw period bytes");
+		return err;
+	}
+
+	err = snd_pcm_ioplug_set_param_minmax(io, SND_PCM_IOPLUG_HW_PERIODS, 2, MAX_PERIODS);
+	if (err < 0) {
+		SNDERR("ioplug cannot set periods");
+		return err;
+	}
+
+	return err;
+}
+
+static inline int parse_struct(snd_config_t **conf, const char **str, snd_pcm_sdm_filter_t *sdm) {
+	snd_config_iterator_t i, next;
+	snd_config_t *n;
+	const char *id;
+	long val;
+	int err = 1;
+
+	snd_config_for_each(i, next, *conf) {
+		n = snd_config_iterator_entry(i);
+
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+
+		if ((strcmp(id, "comment") == 0) || (strcmp(id, "type") == 0))
+			continue;
+
+		if(strcmp(id, "slave") == 0) {
+			if(snd_config_get_string(n, str) < 0) {
+				SNDERR("slave must be a string");
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		if(strcmp(id, "OSR") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'OSR' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(pdm_slave_rate(val, 8000) == 0) {
+				SNDERR("Valid 'OSR' values are 48, 64, 96, 128, 192.");
+				err = -EINVAL;
+				break;
+			}
+			sdm->OSR = (unsigned int)val;
+			continue;
+		}
+
+		if(strcmp(id, "gain") == 0) {
+			if(snd_config_get_integer(n, &val) < 0) {
+				SNDERR("'gain' must be a int");
+				err = -EINVAL;
+				break;
+			}
+			if(val >= GAIN_MIN && val <= 0) {
+				sdm->gain = (int)val;
+			} else {
+				SNDERR("'gain' must be in range of: [%ddB, 0dB].", GAIN_MIN);
+				err = -EINVAL;
+				break;
+			}
+			continue;
+		}
+
+		SNDERR("Unknow field %s", id);
+		err = -EINVAL;
+		break;
+	}
+
+	if(err > 0)
+		err = 0;
+
+	return err;
+}
+
+SND_PCM_PLUGIN_DEFINE_FUNC(PLUG_NAME) {
+	snd_pcm_sdm_filter_t *sdm;
+	const char *devname = NULL;
+	int err;
+
+	if(stream != SND_PCM_STREAM_PLAYBACK) {
+		SNDERR("sdmFilter is only for playback, use cicFilter for capture");
+		return -EINVAL;
+	}
+
+	sdm = calloc(1, sizeof(*sdm));
+	if(sdm == NULL) {
+		SNDERR("Cannot allocate");
+		return -ENOMEM;
+	}
+
+	/* Set default values. */
+	sdm->OSR = 64;
+	sdm->gain = 0;
+
+	err = parse_struct(&conf, &devname, sdm);
+	if(err != 0) {
+		destroy(&sdm);
+		return err;
+	}
+	if(devname == NULL) {
+		SNDERR("No slave defined for sdmFilter");
+		destroy(&sdm);
+		return -EINVAL;
+	}
+
+	/* nonblock is handled by the app side, a slave write never returns short */
+	err = snd_pcm_open(&sdm->slave, devname, stream, mode & ~SND_PCM_NONBLOCK);
+	if(err < 0) {
+		SNDERR("Cant open slave");
+		destroy(&sdm);
+		return err;
+	}
+
+	sdm->io.version = SND_PCM_IOPLUG_VERSION;
+	sdm->io.name = "Digital conversion from PCM 2 PDM";
+	sdm->io.mmap_rw = 0;
+	sdm->io.callback = &sdm_funcs;
+	sdm->io.private_data = sdm;
+	sdm->io.flags = SND_PCM_IOPLUG_FLAG_BOUNDARY_WA | SND_PCM_IOPLUG_FLAG_MONOTONIC;
+
+	err = snd_pcm_ioplug_create(&sdm->io, name, stream, mode);
+	if(err < 0) {
+		destroy(&sdm);
+		return err;
+	}
+
+	err = constrains(&sdm->io);
+	if(err < 0) {
+		destroy(&sdm);
+		return err;
+	}
+
+	*pcmp = sdm->io.pcm;
+
+	return 0;
+}
+
+SND_PCM_PLUGIN_SYMBOL(PLUG_NAME);